@@ -0,0 +1,100 @@
+dnl -------------------------------------------------------- -*- autoconf -*-
+dnl Licensed to the Apache Software Foundation (ASF) under one or more
+dnl contributor license agreements.  See the NOTICE file distributed with
+dnl this work for additional information regarding copyright ownership.
+dnl The ASF licenses this file to You under the Apache License, Version 2.0
+dnl (the "License"); you may not use this file except in compliance with
+dnl the License.  You may obtain a copy of the License at
+dnl
+dnl     http://www.apache.org/licenses/LICENSE-2.0
+dnl
+dnl Unless required by applicable law or agreed to in writing, software
+dnl distributed under the License is distributed on an "AS IS" BASIS,
+dnl WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+dnl See the License for the specific language governing permissions and
+dnl limitations under the License.
+
+dnl
+dnl lz4.m4: Trafficserver's lz4 autoconf macros
+dnl
+
+dnl
+dnl TS_CHECK_LZ4: look for lz4 libraries and headers
+dnl
+AC_DEFUN([TS_CHECK_LZ4], [
+enable_lz4=no
+AC_ARG_WITH(lz4, [AC_HELP_STRING([--with-lz4=DIR],[use a specific lz4 library])],
+[
+  if test "x$withval" != "xyes" && test "x$withval" != "x"; then
+    lz4_base_dir="$withval"
+    if test "$withval" != "no"; then
+      enable_lz4=yes
+      case "$withval" in
+      *":"*)
+        lz4_include="`echo $withval |sed -e 's/:.*$//'`"
+        lz4_ldflags="`echo $withval |sed -e 's/^.*://'`"
+        AC_MSG_CHECKING(checking for lz4 includes in $lz4_include libs in $lz4_ldflags )
+        ;;
+      *)
+        lz4_include="$withval/include"
+        lz4_ldflags="$withval/lib"
+        AC_MSG_CHECKING(checking for lz4 includes in $withval)
+        ;;
+      esac
+    fi
+  fi
+])
+
+if test "x$lz4_base_dir" = "x"; then
+  AC_MSG_CHECKING([for lz4 location])
+  AC_CACHE_VAL(ats_cv_lz4_dir,[
+  for dir in /usr/local /usr ; do
+    if test -d $dir && test -f $dir/include/lz4.h; then
+      ats_cv_lz4_dir=$dir
+      break
+    fi
+  done
+  ])
+  lz4_base_dir=$ats_cv_lz4_dir
+  if test "x$lz4_base_dir" = "x"; then
+    enable_lz4=no
+    AC_MSG_RESULT([not found])
+  else
+    enable_lz4=yes
+    lz4_include="$lz4_base_dir/include"
+    lz4_ldflags="$lz4_base_dir/lib"
+    AC_MSG_RESULT([$lz4_base_dir])
+  fi
+else
+  if test -d $lz4_include && test -d $lz4_ldflags && test -f $lz4_include/lz4.h; then
+    AC_MSG_RESULT([ok])
+  else
+    AC_MSG_RESULT([not found])
+  fi
+fi
+
+lz4h=0
+if test "$enable_lz4" != "no"; then
+  saved_ldflags=$LDFLAGS
+  saved_cppflags=$CPPFLAGS
+  lz4_have_headers=0
+  lz4_have_libs=0
+  if test "$lz4_base_dir" != "/usr"; then
+    TS_ADDTO(CPPFLAGS, [-I${lz4_include}])
+    TS_ADDTO(LDFLAGS, [-L${lz4_ldflags}])
+    TS_ADDTO(LIBTOOL_LINK_FLAGS, [-R${lz4_ldflags}])
+  fi
+  AC_CHECK_LIB(lz4, LZ4_compress_default, [lz4_have_libs=1])
+  if test "$lz4_have_libs" != "0"; then
+    TS_FLAG_HEADERS(lz4.h, [lz4_have_headers=1])
+  fi
+  if test "$lz4_have_headers" != "0"; then
+    AC_SUBST(LIBLZ4, [-llz4])
+  else
+    enable_lz4=no
+    CPPFLAGS=$saved_cppflags
+    LDFLAGS=$saved_ldflags
+  fi
+fi
+AC_SUBST(lz4h)
+])
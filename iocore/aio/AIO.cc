@@ -168,6 +168,13 @@ ink_aio_start()
 #ifdef AIO_STATS
   data = new AIOTestData();
   eventProcessor.schedule_in(data, HRTIME_MSECONDS(100), ET_CALL);
+#endif
+#if (AIO_MODE == AIO_MODE_NATIVE)
+  /* each regular event thread (ET_CALL, which the net threads share)
+     gets its own kernel AIO context; the DiskHandler attaches itself to
+     the thread once io_setup() succeeds */
+  for (int i = 0; i < eventProcessor.n_threads_for_type[ET_CALL]; i++)
+    eventProcessor.eventthread[ET_CALL][i]->schedule_imm(new DiskHandler);
 #endif
   return 0;
 }
@@ -208,6 +215,19 @@ struct AIOThreadInfo:public Continuation
    check if there is any request on the other disks */
 
 
+/* tell the registered error callback (the cache) that an operation
+   on the file descriptor of op failed */
+static void
+aio_notify_error(AIOCallback *op)
+{
+  if (aio_err_callbck) {
+    AIOCallback *callback_op = new AIOCallbackInternal();
+    callback_op->aiocb.aio_fildes = op->aiocb.aio_fildes;
+    callback_op->action = aio_err_callbck;
+    eventProcessor.schedule_imm(callback_op);
+  }
+}
+
 /* insert  an entry for file descriptor fildes into aio_reqs */
 static AIO_Reqs *
 aio_init_fildes(int fildes, int fromAPI = 0)
@@ -387,9 +407,21 @@ aio_queue_req(AIOCallbackInternal *op, int fromAPI = 0)
   }
 }
 
+static inline void
+aio_prefetch(AIOCallbackInternal *op)
+{
+#if TS_HAS_POSIX_FADVISE
+  posix_fadvise(op->prefetch_fd, op->aiocb.aio_offset, op->prefetch_nbytes, POSIX_FADV_WILLNEED);
+#endif
+  op->prefetch_nbytes = 0;
+}
+
 static inline int
 cache_op(AIOCallbackInternal *op)
 {
+  if (op->prefetch_nbytes)
+    aio_prefetch(op);
+
   bool read = (op->aiocb.aio_lio_opcode == LIO_READ) ? 1 : 0;
   for (; op; op = (AIOCallbackInternal *) op->then) {
     ink_aiocb_t *a = &op->aiocb;
@@ -416,6 +448,165 @@ cache_op(AIOCallbackInternal *op)
   return 1;
 }
 
+#if (AIO_MODE == AIO_MODE_NATIVE)
+
+/*
+ * Linux native AIO
+ */
+
+/* (re)build the kernel control block for the part of op that has not
+   been transferred yet */
+static inline void
+aio_native_prep(AIOCallbackInternal *op)
+{
+  ink_aiocb_t *a = &op->aiocb;
+  char *buf = ((char *) a->aio_buf) + op->aio_result;
+  size_t nbytes = a->aio_nbytes - op->aio_result;
+  off_t offset = a->aio_offset + op->aio_result;
+
+  // ops chained through "then" take their opcode from the first one
+  if (op->first->aiocb.aio_lio_opcode == LIO_READ)
+    io_prep_pread(&op->native_iocb, a->aio_fildes, buf, nbytes, offset);
+  else
+    io_prep_pwrite(&op->native_iocb, a->aio_fildes, buf, nbytes, offset);
+  op->native_iocb.data = op;
+}
+
+/* queue op and everything chained to it on the DiskHandler of the calling
+   thread. Returns false if this thread has no DiskHandler, in which case
+   the request has to go through the AIO threads. */
+static bool
+aio_native_queue_req(AIOCallbackInternal *op)
+{
+  EThread *t = this_ethread();
+  if (!t || !t->diskHandler)
+    return false;
+
+  DiskHandler *dh = t->diskHandler;
+  int n = 0;
+  for (AIOCallbackInternal *cur = op; cur; cur = (AIOCallbackInternal *) cur->then) {
+    cur->first = op;
+    cur->aio_result = 0;
+    cur->link.next = NULL;
+    cur->link.prev = NULL;
+    aio_native_prep(cur);
+    dh->ready_list.enqueue(cur);
+    n++;
+  }
+  op->aio_op_num = n;
+  return true;
+}
+
+int
+DiskHandler::startAIOEvent(int event, Event *e)
+{
+  NOWARN_UNUSED(event);
+  int ret = io_setup(MAX_AIO_EVENTS, &ctx);
+  if (ret < 0) {
+    Warning("io_setup failed: %s, using AIO threads for this thread", strerror(-ret));
+    delete this;
+    return EVENT_DONE;
+  }
+  SET_HANDLER(&DiskHandler::mainAIOEvent);
+  e->ethread->diskHandler = this;
+  trigger_event = e->ethread->schedule_every(this, AIO_PERIOD);
+  return EVENT_DONE;
+}
+
+int
+DiskHandler::mainAIOEvent(int event, Event *e)
+{
+  NOWARN_UNUSED(event);
+  NOWARN_UNUSED(e);
+  AIOCallbackInternal *op;
+  struct iocb *cbs[MAX_AIO_EVENTS];
+
+  /* hand everything queued since the last pass to the kernel in one batch */
+  while (ready_list.head && in_flight < MAX_AIO_EVENTS) {
+    int num = 0;
+    for (op = (AIOCallbackInternal *) ready_list.head; op && num < MAX_AIO_EVENTS - in_flight;
+         op = (AIOCallbackInternal *) op->link.next)
+      cbs[num++] = &op->native_iocb;
+    int ret = io_submit(ctx, num, cbs);
+    if (ret == -EAGAIN || ret == 0)
+      break;                    // kernel is out of resources, retry on the next pass
+    if (ret < 0) {
+      // the first iocb was rejected, fail it and submit the rest
+      op = (AIOCallbackInternal *) ready_list.dequeue();
+      Warning("cache disk operation failed %s %d %d\n",
+              (op->first->aiocb.aio_lio_opcode == LIO_READ) ? "READ" : "WRITE", ret, -ret);
+      op->aio_result = ret;
+      aio_notify_error(op);
+      if (--((AIOCallbackInternal *) op->first)->aio_op_num == 0)
+        complete_list.enqueue(op->first);
+      continue;
+    }
+    for (int i = 0; i < ret; i++)
+      ready_list.dequeue();
+    in_flight += ret;
+    if (ret < num)
+      break;
+  }
+
+  /* reap whatever has completed, without waiting */
+  while (in_flight) {
+    int ret = io_getevents(ctx, 0, MAX_AIO_EVENTS, events, NULL);
+    if (ret <= 0)
+      break;
+    for (int i = 0; i < ret; i++) {
+      op = (AIOCallbackInternal *) events[i].data;
+      AIOCallbackInternal *first = (AIOCallbackInternal *) op->first;
+      int64_t res = (int64_t) (long) events[i].res;
+      in_flight--;
+      if (res <= 0) {
+        Warning("cache disk operation failed %s %" PRId64 " %" PRId64 "\n",
+                (first->aiocb.aio_lio_opcode == LIO_READ) ? "READ" : "WRITE", res, -res);
+        op->aio_result = res < 0 ? res : -EIO;
+        aio_notify_error(op);
+      } else {
+        op->aio_result += res;
+        if (op->aio_result < (int64_t) op->aiocb.aio_nbytes) {
+          // short transfer, submit the remainder on the next pass
+          aio_native_prep(op);
+          ready_list.enqueue(op);
+          continue;
+        }
+        if (first->aiocb.aio_lio_opcode == LIO_WRITE) {
+          aio_num_write++;
+          aio_bytes_written += op->aiocb.aio_nbytes;
+        } else {
+          aio_num_read++;
+          aio_bytes_read += op->aiocb.aio_nbytes;
+        }
+      }
+      if (--first->aio_op_num == 0)
+        complete_list.enqueue(first);
+    }
+    if (ret < MAX_AIO_EVENTS)
+      break;
+  }
+
+  /* call back on this thread when we can, otherwise hand off */
+  EThread *t = trigger_event->ethread;
+  while ((op = (AIOCallbackInternal *) complete_list.dequeue())) {
+    op->link.next = NULL;
+    op->link.prev = NULL;
+    op->mutex = op->action.mutex;
+    if (op->thread != AIO_CALLBACK_THREAD_ANY && op->thread != AIO_CALLBACK_THREAD_AIO && op->thread != t) {
+      op->thread->schedule_imm_signal(op);
+      continue;
+    }
+    MUTEX_TRY_LOCK(lock, op->mutex, t);
+    if (lock)
+      op->handleEvent(EVENT_NONE, NULL);
+    else
+      t->schedule_imm(op);
+  }
+  return EVENT_CONT;
+}
+
+#endif
+
 int
 ink_aio_read(AIOCallback *op, int fromAPI)
 {
@@ -423,6 +614,7 @@ ink_aio_read(AIOCallback *op, int fromAPI)
 
 #if (AIO_MODE == AIO_MODE_AIO)
   ink_debug_assert(this_ethread() == op->thread);
+  op->prefetch_nbytes = 0;
   op->thread->aio_ops.enqueue(op);
   if (aio_read(&op->aiocb) < 0) {
     Warning("failed aio_read: %s\n", strerror(errno));
@@ -434,6 +626,11 @@ ink_aio_read(AIOCallback *op, int fromAPI)
   op->action.continuation->handleEvent(AIO_EVENT_DONE, op);
 #elif (AIO_MODE == AIO_MODE_THREAD)
   aio_queue_req((AIOCallbackInternal *) op, fromAPI);
+#elif (AIO_MODE == AIO_MODE_NATIVE)
+  // a prefetch must not be issued from the event thread, so such reads
+  // go through the AIO threads
+  if (fromAPI || op->prefetch_nbytes || !aio_native_queue_req((AIOCallbackInternal *) op))
+    aio_queue_req((AIOCallbackInternal *) op, fromAPI);
 #endif
 
   return 1;
@@ -457,6 +654,9 @@ ink_aio_write(AIOCallback *op, int fromAPI)
   op->action.continuation->handleEvent(AIO_EVENT_DONE, op);
 #elif (AIO_MODE == AIO_MODE_THREAD)
   aio_queue_req((AIOCallbackInternal *) op, fromAPI);
+#elif (AIO_MODE == AIO_MODE_NATIVE)
+  if (fromAPI || !aio_native_queue_req((AIOCallbackInternal *) op))
+    aio_queue_req((AIOCallbackInternal *) op, fromAPI);
 #endif
 
   return 1;
@@ -503,14 +703,8 @@ aio_thread_main(void *arg)
         aio_bytes_read += op->aiocb.aio_nbytes;
       }
       ink_mutex_release(&current_req->aio_mutex);
-      if (cache_op((AIOCallbackInternal *) op) <= 0) {
-        if (aio_err_callbck) {
-          AIOCallback *callback_op = new AIOCallbackInternal();
-          callback_op->aiocb.aio_fildes = op->aiocb.aio_fildes;
-          callback_op->action = aio_err_callbck;
-          eventProcessor.schedule_imm(callback_op);
-        }
-      }
+      if (cache_op((AIOCallbackInternal *) op) <= 0)
+        aio_notify_error(op);
       ink_atomic_increment((int *) &current_req->requests_queued, -1);
 #ifdef AIO_STATS
       ink_atomic_increment((int *) &current_req->pending, -1);
@@ -50,7 +50,13 @@
 #define AIO_MODE_AIO             0
 #define AIO_MODE_SYNC            1
 #define AIO_MODE_THREAD          2
+#define AIO_MODE_NATIVE          3
+
+#if TS_USE_LINUX_NATIVE_AIO
+#define AIO_MODE                 AIO_MODE_NATIVE
+#else
 #define AIO_MODE                 AIO_MODE_THREAD
+#endif
 
 // AIOCallback::thread special values
 #define AIO_CALLBACK_THREAD_ANY ((EThread*)0) // any regular event thread
@@ -68,14 +74,21 @@ struct AIOCallback: public Continuation
   AIOCallback *then;
   // set on return from aio_read/aio_write
   int64_t aio_result;
+  // if set, the AIO thread performing the request also asks the kernel
+  // to start reading prefetch_nbytes of prefetch_fd from aiocb.aio_offset
+  // into the page cache, so that a later send from that fd does not
+  // block. Cleared once issued.
+  int prefetch_fd;
+  int64_t prefetch_nbytes;
 
   int ok();
-  AIOCallback() : thread(AIO_CALLBACK_THREAD_ANY), then(0) {
+  AIOCallback() : thread(AIO_CALLBACK_THREAD_ANY), then(0), prefetch_fd(-1), prefetch_nbytes(0) {
     aiocb.aio_reqprio = AIO_DEFAULT_PRIORITY;
   }
 };
 
 void ink_aio_init(ModuleVersion version);
+// Must be called after the event threads have been started.
 int ink_aio_start();
 void ink_aio_set_callback(Continuation * error_callback);
 
@@ -39,6 +39,10 @@
 #include "P_EventSystem.h"
 #include "I_AIO.h"
 
+#if (AIO_MODE == AIO_MODE_NATIVE)
+#include <libaio.h>
+#endif
+
 // for debugging
 // #define AIO_STATS 1
 
@@ -53,6 +57,10 @@ struct AIOCallbackInternal: public AIOCallback
   AIOCallback *first;
   AIO_Reqs *aio_req;
   ink_hrtime sleep_time;
+#if (AIO_MODE == AIO_MODE_NATIVE)
+  struct iocb native_iocb;      /* kernel control block, built from aiocb at submit time */
+  int aio_op_num;               /* on the first op of a chain, number of ops still in flight */
+#endif
   int io_complete(int event, void *data);
   AIOCallbackInternal()
   {
@@ -97,6 +105,33 @@ struct AIO_Reqs
   volatile int requests_queued;
 };
 
+#if (AIO_MODE == AIO_MODE_NATIVE)
+#define MAX_AIO_EVENTS           1024
+#define AIO_PERIOD               -HRTIME_MSECONDS(4)
+
+/* One per ET_NET thread. Operations issued on a thread with a DiskHandler
+   are batched on ready_list and handed to the kernel with io_submit on the
+   next pass of the event loop; completions are reaped with io_getevents on
+   the same pass and called back on the submitting thread. */
+struct DiskHandler: public Continuation
+{
+  Event *trigger_event;
+  io_context_t ctx;
+  struct io_event events[MAX_AIO_EVENTS];
+  Que(AIOCallback, link) ready_list;
+  Que(AIOCallback, link) complete_list;
+  int in_flight;                /* iocbs submitted and not yet reaped */
+
+  int startAIOEvent(int event, Event *e);
+  int mainAIOEvent(int event, Event *e);
+
+  DiskHandler():Continuation(new_ProxyMutex()), trigger_event(NULL), ctx(0), in_flight(0)
+  {
+    SET_HANDLER(&DiskHandler::startAIOEvent);
+  }
+};
+#endif
+
 #ifdef AIO_STATS
 class AIOTestData:public Continuation
 {
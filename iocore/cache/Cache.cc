@@ -75,10 +75,16 @@ int cache_config_force_sector_size = 0;
 int cache_config_target_fragment_size = DEFAULT_TARGET_FRAGMENT_SIZE;
 int cache_config_agg_write_backlog = AGG_SIZE * 2;
 int cache_config_enable_checksum = 0;
+int cache_config_zero_copy_min_fragment = 0;
+int cache_config_wait_for_all_volumes = 1;
 int cache_config_alt_rewrite_max_size = 4096;
 int cache_config_read_while_writer = 0;
+int cache_config_read_while_writer_max_retries = 10;
+int cache_config_read_while_writer_retry_delay = 50;
+int cache_config_read_while_writer_max_wait = 0;
 char cache_system_config_directory[PATH_NAME_MAX + 1];
 int cache_config_mutex_retry_delay = 2;
+int cache_config_dir_hugepages = ATS_HUGEPAGE_NONE;
 
 // Globals
 
@@ -88,6 +94,11 @@ Cache *theCache = 0;
 CacheDisk **gdisks = NULL;
 int gndisks = 0;
 static volatile int initialize_disk = 0;
+static ink_mutex vol_open_lock = INK_MUTEX_INIT;        // gvol and the volume hash tables during startup
+static bool vols_opened = false;                        // cacheInitialized() took the volumes in gvol
+static int64_t http_ram_cache_size = 0;                 // configured RAM cache size of each cache
+static int64_t stream_ram_cache_size = 0;
+static ink_hrtime cache_start_time = 0;
 Cache *caches[NUM_CACHE_FRAG_TYPES] = { 0 };
 CacheSync *cacheDirSync = 0;
 Store theCacheStore;
@@ -531,6 +542,7 @@ CacheProcessor::start_internal(int flags)
 #endif
 
   start_internal_flags = flags;
+  cache_start_time = ink_get_hrtime();
   clear = !!(flags & PROCESSOR_RECONFIGURE) || auto_clear_flag;
   fix = !!(flags & PROCESSOR_FIX);
   int i;
@@ -594,6 +606,8 @@ CacheProcessor::start_internal(int flags)
         off_t skip = ROUND_TO_STORE_BLOCK((sd->offset < START_POS ? START_POS + sd->alignment : sd->offset));
         blocks = blocks - ROUND_TO_STORE_BLOCK(sd->offset + skip);
         gdisks[gndisks]->open(path, blocks, skip, sector_size, fd, clear);
+        if (cache_config_zero_copy_min_fragment)
+          gdisks[gndisks]->send_fd = open(path, O_RDONLY);
         gndisks++;
       }
     } else {
@@ -718,6 +732,61 @@ CacheProcessor::diskInitialized()
   }
 }
 
+/* Give a volume which has finished initializing its RAM cache, in
+   proportion to the disk space it occupies, and add it to the size
+   stats. Returns the RAM cache bytes given to it. */
+static int64_t
+cache_vol_open(Vol *vol)
+{
+  ProxyMutex *mutex = this_ethread()->mutex;
+  int64_t ram_cache_bytes;
+
+  // new ram_caches, with algorithm from the config
+  switch (cache_config_ram_cache_algorithm) {
+    default:
+    case RAM_CACHE_ALGORITHM_CLFUS:
+      vol->ram_cache = new_RamCacheCLFUS();
+      break;
+    case RAM_CACHE_ALGORITHM_LRU:
+      vol->ram_cache = new_RamCacheLRU();
+      break;
+    case RAM_CACHE_ALGORITHM_TLFU:
+      vol->ram_cache = new_RamCacheTLFU();
+      break;
+  }
+  if (cache_config_ram_cache_size == AUTO_SIZE_RAM_CACHE)
+    ram_cache_bytes = vol_dirlen(vol);
+  else {
+    double factor;
+    if (vol->cache == theCache) {
+      factor = (double) (int64_t) (vol->len >> STORE_BLOCK_SHIFT) / (int64_t) theCache->cache_size;
+      ram_cache_bytes = (int64_t) (http_ram_cache_size * factor);
+    } else {
+      factor = (double) (int64_t) (vol->len >> STORE_BLOCK_SHIFT) / (int64_t) theStreamCache->cache_size;
+      ram_cache_bytes = (int64_t) (stream_ram_cache_size * factor);
+    }
+    Debug("cache_init", "cache_vol_open - factor = %f", factor);
+  }
+  vol->ram_cache->init(ram_cache_bytes, vol);
+  CACHE_VOL_SUM_DYN_STAT(cache_ram_cache_bytes_total_stat, ram_cache_bytes);
+  GLOBAL_CACHE_SUM_GLOBAL_DYN_STAT(cache_ram_cache_bytes_total_stat, ram_cache_bytes);
+
+  uint64_t vol_total_cache_bytes = vol->len - vol_dirlen(vol);
+  CACHE_VOL_SUM_DYN_STAT(cache_bytes_total_stat, vol_total_cache_bytes);
+  GLOBAL_CACHE_SUM_GLOBAL_DYN_STAT(cache_bytes_total_stat, vol_total_cache_bytes);
+
+  uint64_t vol_total_direntries = vol->buckets * vol->segments * DIR_DEPTH;
+  CACHE_VOL_SUM_DYN_STAT(cache_direntries_total_stat, vol_total_direntries);
+  GLOBAL_CACHE_SUM_GLOBAL_DYN_STAT(cache_direntries_total_stat, vol_total_direntries);
+
+  CACHE_VOL_SUM_DYN_STAT(cache_direntries_used_stat, vol->used_direntries);
+  GLOBAL_CACHE_SUM_GLOBAL_DYN_STAT(cache_direntries_used_stat, vol->used_direntries);
+  Debug("cache_init", "cache_vol_open - '%s' ram_cache_bytes = %" PRId64 " cache_bytes = %" PRIu64
+        " direntries = %" PRIu64 " used = %" PRIu64, vol->hash_id, ram_cache_bytes, vol_total_cache_bytes,
+        vol_total_direntries, vol->used_direntries);
+  return ram_cache_bytes;
+}
+
 void
 CacheProcessor::cacheInitialized()
 {
@@ -731,16 +800,9 @@ CacheProcessor::cacheInitialized()
   /* allocate ram size in proportion to the disk space the
      volume accupies */
   int64_t total_size = 0;               // count in HTTP & MIXT
-  uint64_t total_cache_bytes = 0;       // bytes that can used in total_size
-  uint64_t total_direntries = 0;        // all the direntries in the cache
-  uint64_t used_direntries = 0;         //   and used
-  uint64_t vol_total_cache_bytes = 0;
-  uint64_t vol_total_direntries = 0;
-  uint64_t vol_used_direntries = 0;
+  int nvol = 0;
   Vol *vol;
 
-  ProxyMutex *mutex = this_ethread()->mutex;
-
   if (theCache) {
     total_size += theCache->cache_size;
     Debug("cache_init", "CacheProcessor::cacheInitialized - theCache, total_size = %" PRId64 " = %" PRId64 " MB",
@@ -778,101 +840,37 @@ CacheProcessor::cacheInitialized()
     Debug("cache_init", "CacheProcessor::cacheInitialized - caches_ready=0x%0X, gnvol=%d",
           (unsigned int) caches_ready, gnvol);
     int64_t ram_cache_bytes = 0;
-    if (gnvol) {
-      // new ram_caches, with algorithm from the config
-      for (i = 0; i < gnvol; i++) {
-        switch (cache_config_ram_cache_algorithm) {
-          default:
-          case RAM_CACHE_ALGORITHM_CLFUS:
-            gvol[i]->ram_cache = new_RamCacheCLFUS();
-            break;
-          case RAM_CACHE_ALGORITHM_LRU:
-            gvol[i]->ram_cache = new_RamCacheLRU();
-            break;
-        }
-      }
-      // let us cocalate the Size
-      if (cache_config_ram_cache_size == AUTO_SIZE_RAM_CACHE) {
-        Debug("cache_init", "CacheProcessor::cacheInitialized - cache_config_ram_cache_size == AUTO_SIZE_RAM_CACHE");
-        for (i = 0; i < gnvol; i++) {
-          vol = gvol[i];
-          gvol[i]->ram_cache->init(vol_dirlen(vol), vol);
-          ram_cache_bytes += vol_dirlen(gvol[i]);
-          Debug("cache_init", "CacheProcessor::cacheInitialized - ram_cache_bytes = %" PRId64 " = %" PRId64 "Mb",
-                ram_cache_bytes, ram_cache_bytes / (1024 * 1024));
-          CACHE_VOL_SUM_DYN_STAT(cache_ram_cache_bytes_total_stat, (int64_t) vol_dirlen(gvol[i]));
-
-          vol_total_cache_bytes = gvol[i]->len - vol_dirlen(gvol[i]);
-          total_cache_bytes += vol_total_cache_bytes;
-          Debug("cache_init", "CacheProcessor::cacheInitialized - total_cache_bytes = %" PRId64 " = %" PRId64 "Mb",
-                total_cache_bytes, total_cache_bytes / (1024 * 1024));
-
-          CACHE_VOL_SUM_DYN_STAT(cache_bytes_total_stat, vol_total_cache_bytes);
-
-
-          vol_total_direntries = gvol[i]->buckets * gvol[i]->segments * DIR_DEPTH;
-          total_direntries += vol_total_direntries;
-          CACHE_VOL_SUM_DYN_STAT(cache_direntries_total_stat, vol_total_direntries);
-
-
-          vol_used_direntries = dir_entries_used(gvol[i]);
-          CACHE_VOL_SUM_DYN_STAT(cache_direntries_used_stat, vol_used_direntries);
-          used_direntries += vol_used_direntries;
-        }
-
-      } else {
-        // we got configured memory size
-        // TODO, should we check the available system memories, or you will
-        //   OOM or swapout, that is not a good situation for the server
-        Debug("cache_init", "CacheProcessor::cacheInitialized - %" PRId64 " != AUTO_SIZE_RAM_CACHE",
-              cache_config_ram_cache_size);
-        int64_t http_ram_cache_size =
-          (theCache) ? (int64_t) (((double) theCache->cache_size / total_size) * cache_config_ram_cache_size) : 0;
-        Debug("cache_init", "CacheProcessor::cacheInitialized - http_ram_cache_size = %" PRId64 " = %" PRId64 "Mb",
-              http_ram_cache_size, http_ram_cache_size / (1024 * 1024));
-        int64_t stream_ram_cache_size = cache_config_ram_cache_size - http_ram_cache_size;
-        Debug("cache_init", "CacheProcessor::cacheInitialized - stream_ram_cache_size = %" PRId64 " = %" PRId64 "Mb",
-              stream_ram_cache_size, stream_ram_cache_size / (1024 * 1024));
-
-        // Dump some ram_cache size information in debug mode.
-        Debug("ram_cache", "config: size = %" PRId64 ", cutoff = %" PRId64 "",
-              cache_config_ram_cache_size, cache_config_ram_cache_cutoff);
-
-        for (i = 0; i < gnvol; i++) {
-          vol = gvol[i];
-          double factor;
-          if (gvol[i]->cache == theCache) {
-            factor = (double) (int64_t) (gvol[i]->len >> STORE_BLOCK_SHIFT) / (int64_t) theCache->cache_size;
-            Debug("cache_init", "CacheProcessor::cacheInitialized - factor = %f", factor);
-            gvol[i]->ram_cache->init((int64_t) (http_ram_cache_size * factor), vol);
-            ram_cache_bytes += (int64_t) (http_ram_cache_size * factor);
-            CACHE_VOL_SUM_DYN_STAT(cache_ram_cache_bytes_total_stat, (int64_t) (http_ram_cache_size * factor));
-          } else {
-            factor = (double) (int64_t) (gvol[i]->len >> STORE_BLOCK_SHIFT) / (int64_t) theStreamCache->cache_size;
-            Debug("cache_init", "CacheProcessor::cacheInitialized - factor = %f", factor);
-            gvol[i]->ram_cache->init((int64_t) (stream_ram_cache_size * factor), vol);
-            ram_cache_bytes += (int64_t) (stream_ram_cache_size * factor);
-            CACHE_VOL_SUM_DYN_STAT(cache_ram_cache_bytes_total_stat, (int64_t) (stream_ram_cache_size * factor));
-          }
-          Debug("cache_init", "CacheProcessor::cacheInitialized[%d] - ram_cache_bytes = %" PRId64 " = %" PRId64 "Mb",
-                i, ram_cache_bytes, ram_cache_bytes / (1024 * 1024));
-
-          vol_total_cache_bytes = gvol[i]->len - vol_dirlen(gvol[i]);
-          total_cache_bytes += vol_total_cache_bytes;
-          CACHE_VOL_SUM_DYN_STAT(cache_bytes_total_stat, vol_total_cache_bytes);
-          Debug("cache_init", "CacheProcessor::cacheInitialized - total_cache_bytes = %" PRId64 " = %" PRId64 "Mb",
-                total_cache_bytes, total_cache_bytes / (1024 * 1024));
-
-          vol_total_direntries = gvol[i]->buckets * gvol[i]->segments * DIR_DEPTH;
-          total_direntries += vol_total_direntries;
-          CACHE_VOL_SUM_DYN_STAT(cache_direntries_total_stat, vol_total_direntries);
-
-
-          vol_used_direntries = dir_entries_used(gvol[i]);
-          CACHE_VOL_SUM_DYN_STAT(cache_direntries_used_stat, vol_used_direntries);
-          used_direntries += vol_used_direntries;
-
-        }
+    if (cache_config_ram_cache_size == AUTO_SIZE_RAM_CACHE) {
+      Debug("cache_init", "CacheProcessor::cacheInitialized - cache_config_ram_cache_size == AUTO_SIZE_RAM_CACHE");
+    } else {
+      // we got configured memory size
+      // TODO, should we check the available system memories, or you will
+      //   OOM or swapout, that is not a good situation for the server
+      Debug("cache_init", "CacheProcessor::cacheInitialized - %" PRId64 " != AUTO_SIZE_RAM_CACHE",
+            cache_config_ram_cache_size);
+      http_ram_cache_size =
+        (theCache) ? (int64_t) (((double) theCache->cache_size / total_size) * cache_config_ram_cache_size) : 0;
+      Debug("cache_init", "CacheProcessor::cacheInitialized - http_ram_cache_size = %" PRId64 " = %" PRId64 "Mb",
+            http_ram_cache_size, http_ram_cache_size / (1024 * 1024));
+      stream_ram_cache_size = cache_config_ram_cache_size - http_ram_cache_size;
+      Debug("cache_init", "CacheProcessor::cacheInitialized - stream_ram_cache_size = %" PRId64 " = %" PRId64 "Mb",
+            stream_ram_cache_size, stream_ram_cache_size / (1024 * 1024));
+
+      // Dump some ram_cache size information in debug mode.
+      Debug("ram_cache", "config: size = %" PRId64 ", cutoff = %" PRId64 "",
+            cache_config_ram_cache_size, cache_config_ram_cache_cutoff);
+    }
+    // volumes which become ready from here on open themselves
+    ink_mutex_acquire(&vol_open_lock);
+    nvol = gnvol;
+    vols_opened = true;
+    ink_mutex_release(&vol_open_lock);
+    if (nvol) {
+      for (i = 0; i < nvol; i++) {
+        vol = gvol[i];
+        ram_cache_bytes += cache_vol_open(vol);
+        Debug("cache_init", "CacheProcessor::cacheInitialized[%d] - ram_cache_bytes = %" PRId64 " = %" PRId64 "Mb",
+              i, ram_cache_bytes, ram_cache_bytes / (1024 * 1024));
       }
       switch (cache_config_ram_cache_compress) {
         default:
@@ -888,14 +886,25 @@ CacheProcessor::cacheInitialized()
         case CACHE_COMPRESSION_LIBLZMA:
 #if ! TS_HAS_LZMA
           Fatal("lzma not available for RAM cache compression");
+#endif
+          break;
+        case CACHE_COMPRESSION_LZ4:
+#if ! TS_HAS_LZ4
+          Fatal("lz4 not available for RAM cache compression");
+#endif
+          break;
+        case CACHE_COMPRESSION_ZSTD:
+#if ! TS_HAS_ZSTD
+          Fatal("zstd not available for RAM cache compression");
+#endif
+          break;
+        case CACHE_COMPRESSION_TIERED:
+#if ! TS_HAS_LZ4 || ! TS_HAS_ZSTD
+          Fatal("lz4 and zstd are both required for tiered RAM cache compression");
 #endif
           break;
       }
 
-      GLOBAL_CACHE_SET_DYN_STAT(cache_ram_cache_bytes_total_stat, ram_cache_bytes);
-      GLOBAL_CACHE_SET_DYN_STAT(cache_bytes_total_stat, total_cache_bytes);
-      GLOBAL_CACHE_SET_DYN_STAT(cache_direntries_total_stat, total_direntries);
-      GLOBAL_CACHE_SET_DYN_STAT(cache_direntries_used_stat, used_direntries);
       dir_sync_init();
       cache_init_ok = 1;
     } else
@@ -905,7 +914,8 @@ CacheProcessor::cacheInitialized()
     // Initialize virtual cache
     CacheProcessor::initialized = CACHE_INITIALIZED;
     CacheProcessor::cache_ready = caches_ready;
-    Note("cache enabled");
+    Note("cache enabled in %.3f seconds with %d volumes", (double)(ink_get_hrtime() - cache_start_time) / HRTIME_SECOND,
+         nvol);
 #ifdef CLUSTER_CACHE
     if (!(start_internal_flags & PROCESSOR_RECONFIGURE)) {
       CacheContinuation::init();
@@ -997,6 +1007,7 @@ vol_clear_init(Vol *d)
 {
   size_t dir_len = vol_dirlen(d);
   memset(d->raw_dir, 0, dir_len);
+  memset(d->dir_sync_dirty, 0, vol_dir_sync_chunks(d));
   vol_init_dir(d);
   d->header->magic = VOL_MAGIC;
   d->header->version.ink_major = CACHE_DB_MAJOR_VERSION;
@@ -1006,9 +1017,12 @@ vol_clear_init(Vol *d)
   d->header->phase = 0;
   d->header->cycle = 0;
   d->header->create_time = time(NULL);
+  d->agg_written += d->skip + d->len - d->start;
   d->header->dirty = 0;
   d->sector_size = d->header->sector_size = d->disk->hw_sector_size;
   *d->footer = *d->header;
+  // only the header of copy B is cleared, so its first sync must be full
+  d->dir_sync_full = SYNC_COPY(1);
 }
 
 int
@@ -1046,6 +1060,7 @@ Vol::clear_dir()
 int
 Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
 {
+  init_start = ink_get_hrtime();
   dir_skip = ROUND_TO_STORE_BLOCK((dir_skip < START_POS ? START_POS : dir_skip));
   path = ats_strdup(s);
   const size_t hash_id_size = strlen(s) + 32;
@@ -1076,10 +1091,22 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
 
   Debug("cache_init", "allocating %zu directory bytes for a %lld byte volume (%lf%%)",
     vol_dirlen(this), (long long)this->len, (double)vol_dirlen(this) / (double)this->len * 100.0);
-  raw_dir = (char *)ats_memalign(sysconf(_SC_PAGESIZE), vol_dirlen(this));
+  raw_dir = NULL;
+  if (cache_config_dir_hugepages != ATS_HUGEPAGE_NONE) {
+    int huge = 0;
+    raw_dir = (char *)ats_alloc_hugepage(vol_dirlen(this), cache_config_dir_hugepages, &huge);
+    if (huge)
+      RecIncrGlobalRawStatSum(cache_rsb, cache_direntries_hugepage_advised_bytes_stat, vol_dirlen(this));
+    else
+      Warning("unable to back the directory of '%s' with huge pages", hash_id);
+  }
+  if (!raw_dir)
+    raw_dir = (char *)ats_memalign(sysconf(_SC_PAGESIZE), vol_dirlen(this));
   dir = (Dir *) (raw_dir + vol_headerlen(this));
   header = (VolHeaderFooter *) raw_dir;
   footer = (VolHeaderFooter *) (raw_dir + vol_dirlen(this) - ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter)));
+  dir_sync_dirty = (uint8_t *)ats_malloc(vol_dir_sync_chunks(this));
+  memset(dir_sync_dirty, 0, vol_dir_sync_chunks(this));
 
   if (clear) {
     Note("clearing cache directory '%s'", hash_id);
@@ -1163,7 +1190,10 @@ Vol::handle_dir_read(int event, void *data)
     return EVENT_DONE;
   }
   CHECK_DIR(this);
+  dir_read_done = ink_get_hrtime();
   sector_size = header->sector_size;
+  // nothing is known about the copy which was not read
+  dir_sync_full = SYNC_COPY(header->sync_serial + 1);
   SET_HANDLER(&Vol::handle_recover_from_data);
   return handle_recover_from_data(EVENT_IMMEDIATE, 0);
 }
@@ -1438,6 +1468,8 @@ Ldone:{
     init_info->vol_aio[2].aiocb.aio_buf = raw_dir + dirlen - footerlen;
     init_info->vol_aio[2].aiocb.aio_nbytes = footerlen;
     init_info->vol_aio[2].aiocb.aio_offset = ss + dirlen - footerlen;
+    // this copy is written in full, the other only lacks the cleared entries
+    dir_sync_full &= ~SYNC_COPY(header->sync_serial);
 
     SET_HANDLER(&Vol::handle_recover_write_dir);
     ink_assert(ink_aio_write(init_info->vol_aio));
@@ -1461,6 +1493,7 @@ Vol::handle_recover_write_dir(int event, void *data)
     free((char *) io.aiocb.aio_buf);
   delete init_info;
   init_info = 0;
+  recover_done = ink_get_hrtime();
   set_io_not_in_progress();
   scan_pos = header->write_pos;
   periodic_scan();
@@ -1535,14 +1568,19 @@ Vol::dir_init_done(int event, void *data)
     eventProcessor.schedule_in(this, HRTIME_MSECONDS(5), ET_CALL);
     return EVENT_CONT;
   } else {
-    int vol_no = ink_atomic_increment(&gnvol, 1);
-    ink_assert(!gvol[vol_no]);
-    gvol[vol_no] = this;
+    // count on this thread rather than for every volume in cacheInitialized()
+    if (fd != -1)
+      used_direntries = dir_entries_used(this);
+    ink_hrtime now = ink_get_hrtime();
+    if (!dir_read_done)
+      dir_read_done = now;    // cleared
+    if (!recover_done)
+      recover_done = dir_read_done;
+    Note("cache volume '%s' ready in %.3f seconds (directory read %.3f, recovery %.3f, scan %.3f)", hash_id,
+         (double)(now - init_start) / HRTIME_SECOND, (double)(dir_read_done - init_start) / HRTIME_SECOND,
+         (double)(recover_done - dir_read_done) / HRTIME_SECOND, (double)(now - recover_done) / HRTIME_SECOND);
     SET_HANDLER(&Vol::aggWrite);
-    if (fd == -1)
-      cache->vol_initialized(0);
-    else
-      cache->vol_initialized(1);
+    cache->vol_initialized(this, fd != -1);
     return EVENT_DONE;
   }
 }
@@ -1579,7 +1617,7 @@ build_vol_hash_table(CacheHostRecord *cp)
   uint64_t used = 0;
   // initialize number of elements per vol
   for (int i = 0; i < num_vols; i++) {
-    if (DISK_BAD(cp->vols[i]->disk)) {
+    if (DISK_BAD(cp->vols[i]->disk) || !cp->vols[i]->ready) {
       bad_vols++;
       continue;
     }
@@ -1647,8 +1685,9 @@ build_vol_hash_table(CacheHostRecord *cp)
   for (int j = 0; j < VOL_HASH_TABLE_SIZE; j++) {
     pos = width / 2 + j * width;  // position to select closest to
     while (pos > rtable[i].rval && i < (int)rtable_size - 1) i++;
-    ttable[j] = rtable[i].vol;
-    gotvol[ttable[j]]++;
+    // the table indexes cp->vols, which include the volumes skipped above
+    ttable[j] = mapping[rtable[i].vol];
+    gotvol[rtable[i].vol]++;
   }
   for (int i = 0; i < num_vols; i++) {
     Debug("cache_init", "build_vol_hash_table %d request %d got %d", i, forvol[i], gotvol[i]);
@@ -1666,12 +1705,60 @@ build_vol_hash_table(CacheHostRecord *cp)
   cp->vol_hash_table = ttable;
 }
 
+/* Whether the generic record and every hosting.config record have a
+   ready volume. Until they do a host would be sent to the generic
+   volumes, or to a volume still being recovered. */
+static bool
+host_table_ready(CacheHostTable *ht)
+{
+  if (!ht->gen_host_rec.vol_hash_table)
+    return false;
+  if (ht->m_numEntries != 0) {
+    CacheHostMatcher *hm = ht->getHostMatcher();
+    CacheHostRecord *h_rec = hm->getDataArray();
+    int h_rec_len = hm->getNumElements();
+    for (int i = 0; i < h_rec_len; i++) {
+      if (!h_rec[i].vol_hash_table)
+        return false;
+    }
+  }
+  return true;
+}
+
+/* Volumes finish initializing on their own threads. Until
+   cacheInitialized() has taken the volumes ready so far they are only
+   added to gvol; after that (wait_for_all_volumes 0) each one opens
+   its own RAM cache and is added to the volume hash tables. */
 void
-Cache::vol_initialized(bool result) {
+Cache::vol_initialized(Vol *vol, bool result) {
+  bool open = false;
+  bool finish = false;
+  ink_mutex_acquire(&vol_open_lock);
+  if (vols_opened) {
+    cache_vol_open(vol);
+    Note("cache volume '%s' added", vol->hash_id);
+  }
+  gvol[gnvol] = vol;
+  ink_atomic_increment(&gnvol, 1);
+  vol->ready = true;
   if (result)
-    ink_atomic_increment(&total_good_nvol, 1);
-  if (total_nvol == ink_atomic_increment(&total_initialized_vol, 1) + 1)
+    total_good_nvol++;
+  total_initialized_vol++;
+  if (ready == CACHE_INITIALIZING && !open_started) {
+    open = (total_initialized_vol == total_nvol) || (result && !cache_config_wait_for_all_volumes);
+    open_started = open;
+  } else if (hosttable) {
+    rebuild_host_table(this);
+    if (open_waiting && (total_initialized_vol == total_nvol || host_table_ready(hosttable))) {
+      open_waiting = false;
+      finish = true;
+    }
+  }
+  ink_mutex_release(&vol_open_lock);
+  if (open)
     open_done();
+  else if (finish)
+    open_finish();
 }
 
 int
@@ -1772,9 +1859,24 @@ Cache::open_done() {
     return 0;
   }
 
+  ink_mutex_acquire(&vol_open_lock);
   hosttable = NEW(new CacheHostTable(this, scheme));
   hosttable->register_config_callback(&hosttable);
+  // with wait_for_all_volumes 0, the rest is left to vol_initialized()
+  // once every host has a ready volume
+  open_waiting = total_initialized_vol < total_nvol && !host_table_ready(hosttable);
+  bool waiting = open_waiting;
+  ink_mutex_release(&vol_open_lock);
+
+  if (waiting) {
+    Note("cache waiting for a ready volume for every hosting.config entry");
+    return 0;
+  }
+  return open_finish();
+}
 
+int
+Cache::open_finish() {
   if (hosttable->gen_host_rec.num_cachevols == 0)
     ready = CACHE_INIT_FAILED;
   else
@@ -1811,6 +1913,7 @@ Cache::open(bool clear, bool fix) {
             CacheDisk *d = cp->disk_vols[i]->disk;
             cp->vols[vol_no]->disk = d;
             cp->vols[vol_no]->fd = d->fd;
+            cp->vols[vol_no]->send_fd = d->send_fd;
             cp->vols[vol_no]->cache = this;
             cp->vols[vol_no]->cache_vol = cp;
             blocks = q->b->len;
@@ -1850,6 +1953,208 @@ CacheVC::is_pread_capable()
   return alternate.get_frag_offset_count() > 0;
 }
 
+bool
+CacheVC::set_zero_copy()
+{
+  if (!cache_config_zero_copy_min_fragment || cache_config_enable_checksum || vio.op != VIO::READ)
+    return false;
+  f.zero_copy = 1;
+  return true;
+}
+
+// How far the aggregator may write before it reaches offset.
+static inline off_t
+zero_copy_fragment_ahead(Vol *vol, off_t offset)
+{
+  off_t end = vol->skip + vol->len, pos = vol->header->agg_pos;
+  return offset >= pos ? offset - pos : (offset - vol->start) + (end - pos);
+}
+
+// A fragment sent from the disk must not be overwritten before it has
+// gone out, so only those well ahead of the write position qualify.
+static inline bool
+zero_copy_fragment_safe(Vol *vol, off_t offset)
+{
+  return zero_copy_fragment_ahead(vol, offset) > (vol->skip + vol->len - vol->start) / 4;
+}
+
+// IOBufferData::_fd_check for fragments sent from the disk: a slow
+// client may still be sending one when the aggregator comes around, so
+// the sender asks again before and after each send.
+static int
+zero_copy_fragment_check(IOBufferData *d)
+{
+  int64_t headroom = d->_fd_limit - ((Vol *) d->_fd_owner)->agg_written;
+  if (headroom < 0)
+    return -1;
+  return headroom > 2 * AGG_SIZE ? 1 : 0;
+}
+
+static inline void
+zero_copy_fragment_set(Vol *vol, IOBufferData *d, off_t offset)
+{
+  d->_fd = vol->send_fd;
+  d->_fd_offset = offset;
+  d->_fd_check = zero_copy_fragment_check;
+  d->_fd_owner = vol;
+  d->_fd_limit = vol->agg_written + zero_copy_fragment_ahead(vol, offset);
+}
+
+#if TS_HAS_TESTS
+// Drives the aggregator position by hand past a fragment, through a
+// wrap and a clear, and checks what a sender of it would be told.
+REGRESSION_TEST(Cache_zero_copy) (RegressionTest *t, int atype, int *status) {
+  NOWARN_UNUSED(atype);
+  Vol *vol = NEW(new Vol);
+  VolHeaderFooter header;
+  memset(&header, 0, sizeof(header));
+  vol->header = &header;
+  vol->send_fd = 0;
+  vol->skip = 0;
+  vol->start = 8192;
+  vol->len = 64 * AGG_SIZE;
+  header.agg_pos = header.write_pos = vol->start;
+  off_t end = vol->skip + vol->len;
+  int ok = 1;
+
+  // aggregator writes, with agg_wrap() when it reaches the end
+  struct Agg {
+    static void write(Vol *v, off_t n) {
+      if (v->header->agg_pos + n > v->skip + v->len) {
+        v->agg_written += v->skip + v->len - v->header->agg_pos;
+        v->header->agg_pos = v->start;
+      }
+      v->header->agg_pos += n;
+      v->agg_written += n;
+    }
+  };
+
+  // a fragment ahead of the aggregator
+  Ptr<IOBufferData> d = new_IOBufferData(iobuffer_size_to_index(CACHE_BLOCK_SIZE, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
+  off_t frag = vol->start + 32 * AGG_SIZE;
+  zero_copy_fragment_set(vol, d, frag);
+  ok = ok && d->file_backed() && d->_fd_check(d) == 1;
+  while (header.agg_pos + 2 * AGG_SIZE < frag)
+    Agg::write(vol, AGG_SIZE);
+  ok = ok && d->_fd_check(d) == 0;
+  while (header.agg_pos <= frag)
+    Agg::write(vol, AGG_SIZE);
+  ok = ok && d->_fd_check(d) == -1;
+  rprintf(t, "ahead: %s\n", ok ? "ok" : "failed");
+
+  // a fragment behind it, reached only after a wrap
+  frag = header.agg_pos - 4 * AGG_SIZE;
+  zero_copy_fragment_set(vol, d, frag);
+  while (header.agg_pos + AGG_SIZE <= end)
+    Agg::write(vol, AGG_SIZE);
+  ok = ok && d->_fd_check(d) == 1;
+  Agg::write(vol, AGG_SIZE);
+  ok = ok && header.agg_pos < frag && d->_fd_check(d) == 1;
+  while (header.agg_pos <= frag)
+    Agg::write(vol, AGG_SIZE);
+  ok = ok && d->_fd_check(d) == -1;
+  rprintf(t, "wrap: %s\n", ok ? "ok" : "failed");
+
+  // anything outstanding is gone once the volume is cleared
+  frag = header.agg_pos + 16 * AGG_SIZE;
+  zero_copy_fragment_set(vol, d, frag);
+  ok = ok && d->_fd_check(d) == 1;
+  vol->agg_written += vol->skip + vol->len - vol->start;
+  header.agg_pos = vol->start;
+  ok = ok && d->_fd_check(d) == -1;
+  rprintf(t, "clear: %s\n", ok ? "ok" : "failed");
+
+  // a reader that copies it now gets a copy no sender will send
+  Ptr<IOBufferBlock> b = new_IOBufferBlock(d, CACHE_BLOCK_SIZE, 0);
+  b->load_file();
+  ok = ok && !b->data->file_backed() && b->data->_lost;
+  rprintf(t, "lost: %s\n", ok ? "ok" : "failed");
+  b = NULL;
+
+  d->_fd = -1;
+  d = NULL;
+  delete vol;
+  *status = ok ? REGRESSION_TEST_PASSED : REGRESSION_TEST_FAILED;
+}
+
+// Splits three volumes between two hosts and the generic record, and
+// brings their vols up one at a time as vol_initialized() does with
+// wait_for_all_volumes 0. No host may be sent outside its own volume
+// or to a vol that is not ready.
+EXCLUSIVE_REGRESSION_TEST(Cache_hosting_partial_open) (RegressionTest *t, int atype, int *status) {
+  NOWARN_UNUSED(atype);
+  static const int nvols = 3;
+  char config[] = "hostname=a.example.com volume=1\nhostname=b.example.com volume=2\nhostname=* volume=3\n";
+  char *hosts[nvols] = { (char *) "a.example.com", (char *) "b.example.com", (char *) "c.example.com" };
+  Queue<CacheVol> saved_cp_list = cp_list;
+  CacheDisk disk;
+  CacheVol cachevol[nvols];
+  Vol *vols[nvols][2];
+  Cache cache;
+  int ok = 1;
+
+  cp_list.head = cp_list.tail = NULL;
+  for (int i = 0; i < nvols; i++) {
+    for (int j = 0; j < 2; j++) {
+      char name[32];
+      snprintf(name, sizeof(name), "hosting test %d %d", i, j);
+      vols[i][j] = NEW(new Vol);
+      vols[i][j]->disk = &disk;
+      vols[i][j]->len = 128 * 1024 * 1024;
+      vols[i][j]->hash_id_md5.encodeBuffer(name, strlen(name));
+    }
+    cachevol[i].vol_number = i + 1;
+    cachevol[i].scheme = CACHE_HTTP_TYPE;
+    cachevol[i].num_vols = 2;
+    cachevol[i].vols = vols[i];
+    cp_list.enqueue(&cachevol[i]);
+  }
+
+  // checks that every host only gets ready vols of its own volume
+  struct Check {
+    static int hosts_ok(Cache *c, char **h, Vol *v[][2]) {
+      for (int k = 0; k < 256; k++) {
+        CacheKey key;
+        key.encodeBuffer((unsigned char *) &k, sizeof(k));
+        for (int i = 0; i < nvols; i++) {
+          Vol *vol = c->key_to_vol(&key, h[i], strlen(h[i]));
+          if ((vol != v[i][0] && vol != v[i][1]) || !vol->ready)
+            return 0;
+        }
+      }
+      return 1;
+    }
+  };
+
+  vols[0][0]->ready = true;
+  cache.hosttable = NEW(new CacheHostTable(&cache, CACHE_HTTP_TYPE, config));
+  ok = ok && cache.hosttable->m_numEntries == nvols && !host_table_ready(cache.hosttable);
+  vols[2][1]->ready = true;
+  rebuild_host_table(&cache);
+  ok = ok && !host_table_ready(cache.hosttable);
+  rprintf(t, "not ready without a vol for every host: %s\n", ok ? "ok" : "failed");
+
+  vols[1][1]->ready = true;
+  rebuild_host_table(&cache);
+  ok = ok && host_table_ready(cache.hosttable) && Check::hosts_ok(&cache, hosts, vols);
+  rprintf(t, "one vol for every host: %s\n", ok ? "ok" : "failed");
+
+  for (int i = 0; i < nvols; i++)
+    vols[i][0]->ready = vols[i][1]->ready = true;
+  rebuild_host_table(&cache);
+  ok = ok && Check::hosts_ok(&cache, hosts, vols);
+  rprintf(t, "all vols: %s\n", ok ? "ok" : "failed");
+
+  delete cache.hosttable;
+  for (int i = 0; i < nvols; i++) {
+    delete vols[i][0];
+    delete vols[i][1];
+  }
+  cp_list = saved_cp_list;
+  *status = ok ? REGRESSION_TEST_PASSED : REGRESSION_TEST_FAILED;
+}
+#endif
+
 #define STORE_COLLISION 1
 
 #ifdef HTTP_CACHE
@@ -1956,7 +2261,7 @@ CacheVC::handleReadDone(int event, Event *e) {
         cutoff_check = ((!doc_len && (int64_t)doc->total_len < cache_config_ram_cache_cutoff)
                         || (doc_len && (int64_t)doc_len < cache_config_ram_cache_cutoff)
                         || !cache_config_ram_cache_cutoff);
-        if (cutoff_check && !f.doc_from_ram_cache) {
+        if (cutoff_check && !f.doc_from_ram_cache && buf->_fd < 0) {
           uint64_t o = dir_offset(&dir);
           vol->ram_cache->put(read_key, buf, doc->len, http_copy_hdr, (uint32_t)(o >> 32), (uint32_t)o);
         }
@@ -2020,7 +2325,24 @@ CacheVC::handleRead(int event, Event *e)
   io.aiocb.aio_offset = vol_offset(vol, &dir);
   if ((off_t)(io.aiocb.aio_offset + io.aiocb.aio_nbytes) > (off_t)(vol->skip + vol->len))
     io.aiocb.aio_nbytes = vol->skip + vol->len - io.aiocb.aio_offset;
-  buf = new_IOBufferData(iobuffer_size_to_index(io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
+  // for a large fragment after the first, read just the Doc and leave
+  // the rest to be sent from the disk
+  if (f.zero_copy && doc_len && !write_vc && vol->send_fd >= 0 &&
+#ifdef HIT_EVACUATE
+      !f.hit_evacuate &&
+#endif
+      io.aiocb.aio_nbytes >= (size_t)cache_config_zero_copy_min_fragment &&
+      zero_copy_fragment_safe(vol, io.aiocb.aio_offset)) {
+    // the net thread must not wait on the disk, so have the AIO thread
+    // bring the rest of the fragment into the page cache
+    io.prefetch_fd = vol->send_fd;
+    io.prefetch_nbytes = io.aiocb.aio_nbytes;
+    io.aiocb.aio_nbytes = CACHE_BLOCK_SIZE;
+    buf = new_IOBufferData(iobuffer_size_to_index(CACHE_BLOCK_SIZE, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
+    zero_copy_fragment_set(vol, buf, io.aiocb.aio_offset);
+    CACHE_INCREMENT_DYN_STAT(cache_zero_copy_fragments_stat);
+  } else
+    buf = new_IOBufferData(iobuffer_size_to_index(io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
   io.aiocb.aio_buf = buf->data();
   io.action = this;
   io.thread = mutex->thread_holding->tt == DEDICATED ? AIO_CALLBACK_THREAD_ANY : mutex->thread_holding;
@@ -2054,6 +2376,7 @@ Cache::lookup(Continuation *cont, CacheKey *key, CacheFragType type, char *hostn
   }
 
   Vol *vol = key_to_vol(key, hostname, host_len);
+  dir_prefetch(key, vol);
   ProxyMutex *mutex = cont->mutex;
   CacheVC *c = new_CacheVC(cont);
   SET_CONTINUATION_HANDLER(c, &CacheVC::openReadStartHead);
@@ -2629,7 +2952,28 @@ register_cache_stats(RecRawStatBlock *rsb, const char *prefix)
   REG_INT("ram_cache.bytes_used", cache_ram_cache_bytes_stat);
   REG_INT("ram_cache.hits", cache_ram_cache_hits_stat);
   REG_INT("ram_cache.misses", cache_ram_cache_misses_stat);
+  REG_INT("ram_cache.compress.fastlz.bytes_in", cache_ram_cache_fastlz_bytes_in_stat);
+  REG_INT("ram_cache.compress.fastlz.bytes_out", cache_ram_cache_fastlz_bytes_out_stat);
+  REG_INT("ram_cache.compress.fastlz.compress_usecs", cache_ram_cache_fastlz_compress_usecs_stat);
+  REG_INT("ram_cache.compress.fastlz.decompress_usecs", cache_ram_cache_fastlz_decompress_usecs_stat);
+  REG_INT("ram_cache.compress.libz.bytes_in", cache_ram_cache_libz_bytes_in_stat);
+  REG_INT("ram_cache.compress.libz.bytes_out", cache_ram_cache_libz_bytes_out_stat);
+  REG_INT("ram_cache.compress.libz.compress_usecs", cache_ram_cache_libz_compress_usecs_stat);
+  REG_INT("ram_cache.compress.libz.decompress_usecs", cache_ram_cache_libz_decompress_usecs_stat);
+  REG_INT("ram_cache.compress.liblzma.bytes_in", cache_ram_cache_liblzma_bytes_in_stat);
+  REG_INT("ram_cache.compress.liblzma.bytes_out", cache_ram_cache_liblzma_bytes_out_stat);
+  REG_INT("ram_cache.compress.liblzma.compress_usecs", cache_ram_cache_liblzma_compress_usecs_stat);
+  REG_INT("ram_cache.compress.liblzma.decompress_usecs", cache_ram_cache_liblzma_decompress_usecs_stat);
+  REG_INT("ram_cache.compress.lz4.bytes_in", cache_ram_cache_lz4_bytes_in_stat);
+  REG_INT("ram_cache.compress.lz4.bytes_out", cache_ram_cache_lz4_bytes_out_stat);
+  REG_INT("ram_cache.compress.lz4.compress_usecs", cache_ram_cache_lz4_compress_usecs_stat);
+  REG_INT("ram_cache.compress.lz4.decompress_usecs", cache_ram_cache_lz4_decompress_usecs_stat);
+  REG_INT("ram_cache.compress.zstd.bytes_in", cache_ram_cache_zstd_bytes_in_stat);
+  REG_INT("ram_cache.compress.zstd.bytes_out", cache_ram_cache_zstd_bytes_out_stat);
+  REG_INT("ram_cache.compress.zstd.compress_usecs", cache_ram_cache_zstd_compress_usecs_stat);
+  REG_INT("ram_cache.compress.zstd.decompress_usecs", cache_ram_cache_zstd_decompress_usecs_stat);
   REG_INT("pread_count", cache_pread_count_stat);
+  REG_INT("zero_copy_fragments", cache_zero_copy_fragments_stat);
   REG_INT("percent_full", cache_percent_full_stat);
   REG_INT("lookup.active", cache_lookup_active_stat);
   REG_INT("lookup.success", cache_lookup_success_stat);
@@ -2655,7 +2999,11 @@ register_cache_stats(RecRawStatBlock *rsb, const char *prefix)
   REG_INT("scan.failure", cache_scan_failure_stat);
   REG_INT("direntries.total", cache_direntries_total_stat);
   REG_INT("direntries.used", cache_direntries_used_stat);
+  REG_INT("direntries.hugepage_advised_bytes", cache_direntries_hugepage_advised_bytes_stat);
   REG_INT("directory_collision", cache_directory_collision_count_stat);
+  REG_INT("directory_sync.count", cache_directory_sync_count_stat);
+  REG_INT("directory_sync.bytes", cache_directory_sync_bytes_stat);
+  REG_INT("directory_sync.usecs", cache_directory_sync_usecs_stat);
   REG_INT("frags_per_doc.1", cache_single_fragment_document_count_stat);
   REG_INT("frags_per_doc.2", cache_two_fragment_document_count_stat);
   REG_INT("frags_per_doc.3+", cache_three_plus_plus_fragment_document_count_stat);
@@ -2712,6 +3060,9 @@ ink_cache_init(ModuleVersion v)
   IOCORE_EstablishStaticConfigInt32(cache_config_mutex_retry_delay, "proxy.config.cache.mutex_retry_delay");
   Debug("cache_init", "proxy.config.cache.mutex_retry_delay = %dms", cache_config_mutex_retry_delay);
 
+  IOCORE_EstablishStaticConfigInt32(cache_config_dir_hugepages, "proxy.config.cache.dir.hugepages");
+  Debug("cache_init", "proxy.config.cache.dir.hugepages = %d", cache_config_dir_hugepages);
+
   // This is just here to make sure IOCORE "standalone" works, it's usually configured in RecordsConfig.cc
   IOCORE_RegisterConfigString(RECT_CONFIG, "proxy.config.config_dir", TS_BUILD_SYSCONFDIR, RECU_DYNAMIC, RECC_NULL, NULL);
   IOCORE_ReadConfigString(cache_system_config_directory, "proxy.config.config_dir", PATH_NAME_MAX);
@@ -2764,6 +3115,13 @@ ink_cache_init(ModuleVersion v)
   IOCORE_EstablishStaticConfigInt32(cache_config_enable_checksum, "proxy.config.cache.enable_checksum");
   Debug("cache_init", "proxy.config.cache.enable_checksum = %d", cache_config_enable_checksum);
 
+  // read once: the disks' send_fd are opened only if this is set at startup
+  IOCORE_ReadConfigInt32(cache_config_zero_copy_min_fragment, "proxy.config.cache.zero_copy_min_fragment");
+  Debug("cache_init", "proxy.config.cache.zero_copy_min_fragment = %d", cache_config_zero_copy_min_fragment);
+
+  IOCORE_EstablishStaticConfigInt32(cache_config_wait_for_all_volumes, "proxy.config.cache.wait_for_all_volumes");
+  Debug("cache_init", "proxy.config.cache.wait_for_all_volumes = %d", cache_config_wait_for_all_volumes);
+
   IOCORE_EstablishStaticConfigInt32(cache_config_alt_rewrite_max_size, "proxy.config.cache.alt_rewrite_max_size");
   Debug("cache_init", "proxy.config.cache.alt_rewrite_max_size = %d", cache_config_alt_rewrite_max_size);
 
@@ -2772,6 +3130,15 @@ ink_cache_init(ModuleVersion v)
   IOCORE_RegisterConfigUpdateFunc("proxy.config.cache.enable_read_while_writer", update_cache_config, NULL);
   Debug("cache_init", "proxy.config.cache.enable_read_while_writer = %d", cache_config_read_while_writer);
 
+  IOCORE_EstablishStaticConfigInt32(cache_config_read_while_writer_max_retries, "proxy.config.cache.read_while_writer.max_retries");
+  Debug("cache_init", "proxy.config.cache.read_while_writer.max_retries = %d", cache_config_read_while_writer_max_retries);
+
+  IOCORE_EstablishStaticConfigInt32(cache_config_read_while_writer_retry_delay, "proxy.config.cache.read_while_writer.retry_delay");
+  Debug("cache_init", "proxy.config.cache.read_while_writer.retry_delay = %d", cache_config_read_while_writer_retry_delay);
+
+  IOCORE_EstablishStaticConfigInt32(cache_config_read_while_writer_max_wait, "proxy.config.cache.read_while_writer.max_wait");
+  Debug("cache_init", "proxy.config.cache.read_while_writer.max_wait = %d", cache_config_read_while_writer_max_wait);
+
   register_cache_stats(cache_rsb, "proxy.process.cache");
 
   const char *err = NULL;
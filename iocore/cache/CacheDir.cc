@@ -139,8 +139,7 @@ OpenDir::close_write(CacheVC *cont)
     unsigned int h = cont->first_key.word(0);
     int b = h % OPEN_DIR_BUCKETS;
     bucket[b].remove(cont->od);
-    delayed_readers.append(cont->od->readers);
-    signal_readers(0, 0);
+    cont->od->wake_readers(cont->mutex->thread_holding, true);
     cont->od->vector.clear();
     THREAD_FREE(cont->od, openDirEntryAllocator, cont->mutex->thread_holding);
   }
@@ -163,13 +162,40 @@ int
 OpenDirEntry::wait(CacheVC *cont, int msec)
 {
   ink_debug_assert(cont->vol->mutex->thread_holding == this_ethread());
-  cont->f.open_read_timeout = 1;
-  ink_assert(!cont->trigger);
-  cont->trigger = cont->vol->mutex->thread_holding->schedule_in_local(cont, HRTIME_MSECONDS(msec));
+  ink_assert(!cont->trigger && !cont->wait_od);
+  cont->trigger = cont->mutex->thread_holding->schedule_in_local(cont, HRTIME_MSECONDS(msec));
+  cont->wait_od = this;
   readers.push(cont);
   return EVENT_CONT;
 }
 
+/*
+   Called by a writer with the Vol lock held once it has inserted a
+   fragment into the directory, or with all set when the entry is about
+   to be freed. Readers whose lock we get are rescheduled immediately on
+   the thread they were waiting on; the others are running and will
+   probe the directory themselves. With all set every reader is unlinked
+   so that none keeps a pointer to this entry.
+   */
+void
+OpenDirEntry::wake_readers(EThread *t, bool all)
+{
+  CacheVC *c = readers.head, *next = NULL;
+  for (; c; c = next) {
+    next = (CacheVC *) c->opendir_link.next;
+    CACHE_TRY_LOCK(lock, c->mutex, t);
+    if (!lock && !all)
+      continue;
+    readers.remove(c);
+    c->wait_od = NULL;
+    if (lock && c->trigger) {
+      EThread *ct = c->trigger->ethread;
+      c->cancel_trigger();
+      c->trigger = ct->schedule_in(c, 0);
+    }
+  }
+}
+
 //
 // Cache Directory
 //
@@ -210,6 +236,7 @@ dir_init_segment(int s, Vol *d)
   Dir *seg = dir_segment(s, d);
   int l, b;
   memset(seg, 0, SIZEOF_DIR * DIR_DEPTH * d->buckets);
+  vol_dir_dirty(d, seg, SIZEOF_DIR * DIR_DEPTH * d->buckets);
   for (l = 1; l < DIR_DEPTH; l++) {
     for (b = 0; b < d->buckets; b++) {
       Dir *bucket = dir_bucket(b, seg);
@@ -288,13 +315,16 @@ unlink_from_freelist(Dir *e, int s, Vol *d)
 {
   Dir *seg = dir_segment(s, d);
   Dir *p = dir_from_offset(dir_prev(e), seg);
-  if (p)
+  if (p) {
     dir_set_next(p, dir_next(e));
-  else
+    vol_dir_dirty(d, p);
+  } else
     d->header->freelist[s] = dir_next(e);
   Dir *n = dir_from_offset(dir_next(e), seg);
-  if (n)
+  if (n) {
     dir_set_prev(n, dir_prev(e));
+    vol_dir_dirty(d, n);
+  }
 }
 
 inline Dir *
@@ -303,14 +333,18 @@ dir_delete_entry(Dir *e, Dir *p, int s, Vol *d)
   Dir *seg = dir_segment(s, d);
   int no = dir_next(e);
   d->header->dirty = 1;
+  vol_dir_dirty(d, e);
   if (p) {
     unsigned int fo = d->header->freelist[s];
     unsigned int eo = dir_to_offset(e, seg);
     dir_clear(e);
     dir_set_next(p, no);
+    vol_dir_dirty(d, p);
     dir_set_next(e, fo);
-    if (fo)
+    if (fo) {
       dir_set_prev(dir_from_offset(fo, seg), eo);
+      vol_dir_dirty(d, dir_from_offset(fo, seg));
+    }
     d->header->freelist[s] = eo;
   } else {
     Dir *n = next_dir(e, seg);
@@ -382,6 +416,7 @@ dir_clear_range(off_t start, off_t end, Vol *vol)
     if (!dir_token(e) && dir_offset(e) >= (int64_t)start && dir_offset(e) < (int64_t)end) {
       CACHE_DEC_DIR_USED(vol->mutex);
       dir_set_offset(e, 0);     // delete
+      vol_dir_dirty(vol, e);
     }
   }
   dir_clean_vol(vol);
@@ -415,6 +450,7 @@ freelist_clean(int s, Vol *vol)
       if (dir_head(e) && !(n++ % 10)) {
         CACHE_DEC_DIR_USED(vol->mutex);
         dir_set_offset(e, 0);   // delete
+        vol_dir_dirty(vol, e);
       }
     }
   }
@@ -437,8 +473,10 @@ freelist_pop(int s, Vol *d)
     return NULL;
   }
   Dir *h = dir_from_offset(d->header->freelist[s], seg);
-  if (h)
+  if (h) {
     dir_set_prev(h, 0);
+    vol_dir_dirty(d, h);
+  }
   return e;
 }
 
@@ -493,8 +531,11 @@ dir_free_entry(Dir *e, int s, Vol *d)
   unsigned int fo = d->header->freelist[s];
   unsigned int eo = dir_to_offset(e, seg);
   dir_set_next(e, fo);
-  if (fo)
+  vol_dir_dirty(d, e);
+  if (fo) {
     dir_set_prev(dir_from_offset(fo, seg), eo);
+    vol_dir_dirty(d, dir_from_offset(fo, seg));
+  }
   d->header->freelist[s] = eo;
 }
 
@@ -605,6 +646,8 @@ Llink:
 Lfill:
   dir_assign_data(e, to_part);
   dir_set_tag(e, key->word(2));
+  vol_dir_dirty(d, e);
+  vol_dir_dirty(d, b);
   ink_assert(vol_offset(d, e) < (d->skip + d->len));
   DDebug("dir_insert",
         "insert %p %X into vol %d bucket %d at %p tag %X %X boffset %" PRId64 "",
@@ -679,6 +722,8 @@ Llink:
 Lfill:
   dir_assign_data(e, dir);
   dir_set_tag(e, t);
+  vol_dir_dirty(d, e);
+  vol_dir_dirty(d, b);
   ink_assert(vol_offset(d, e) < d->skip + d->len);
   DDebug("dir_overwrite",
         "overwrite %p %X into vol %d bucket %d at %p tag %X %X boffset %" PRId64 "",
@@ -986,6 +1031,11 @@ Lrestart:
       buf = 0;
       buflen = 0;
     }
+    if (writemap) {
+      ats_free(writemap);
+      writemap = 0;
+      writemap_len = 0;
+    }
     Debug("cache_dir_sync", "sync done");
     if (event == EVENT_INTERVAL)
       trigger = e->ethread->schedule_in(this, HRTIME_SECONDS(cache_config_dir_sync_frequency));
@@ -997,10 +1047,15 @@ Lrestart:
     // AIO Thread
     if (io.aio_result != (int64_t)io.aiocb.aio_nbytes) {
       Warning("vol write error during directory sync '%s'", gvol[vol]->hash_id);
+      // the copy is now torn, rewrite all of it next time
+      gvol[vol]->dir_sync_full |= SYNC_COPY(gvol[vol]->header->sync_serial);
+      gvol[vol]->dir_sync_in_progress = 0;
       event = EVENT_NONE;
       goto Ldone;
     }
-    trigger = eventProcessor.schedule_in(this, SYNC_DELAY);
+    bytes += io.aiocb.aio_nbytes;
+    // pace the writes at SYNC_MAX_WRITE bytes per SYNC_DELAY
+    trigger = eventProcessor.schedule_in(this, SYNC_DELAY * (ink_hrtime)io.aiocb.aio_nbytes / SYNC_MAX_WRITE);
     return EVENT_CONT;
   }
   {
@@ -1021,6 +1076,9 @@ Lrestart:
 
     int headerlen = ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter));
     size_t dirlen = vol_dirlen(d);
+    off_t body = vol_headerlen(d);
+    off_t body_end = dirlen - headerlen;
+    int chunks = vol_dir_sync_chunks(d);
     if (!writepos) {
       // start
       Debug("cache_dir_sync", "sync started");
@@ -1049,24 +1107,69 @@ Lrestart:
         buf = (char *)ats_memalign(sysconf(_SC_PAGESIZE), dirlen);
         buflen = dirlen;
       }
+      if (writemap_len < chunks) {
+        ats_free(writemap);
+        writemap = (uint8_t *)ats_malloc(chunks);
+        writemap_len = chunks;
+      }
       d->header->sync_serial++;
       d->footer->sync_serial = d->header->sync_serial;
       CHECK_DIR(d);
-      memcpy(buf, d->raw_dir, dirlen);
+      /* The copy being written already holds everything up to its
+         previous sync, so only the chunks changed since then (plus
+         short clean gaps between them, to merge writes) are copied
+         and written. The header and footer are always written, and
+         the serial number check on them at startup rejects a copy
+         whose sync did not complete, falling back to the other. */
+      uint8_t copy = SYNC_COPY(d->header->sync_serial);
+      bool full = (d->dir_sync_full & copy) != 0;
+      d->dir_sync_full &= ~copy;
+      memcpy(buf, d->raw_dir, body);
+      memcpy(buf + body_end, d->footer, headerlen);
+      int last = -1;
+      for (int c = 0; c < chunks; c++) {
+        writemap[c] = full || (d->dir_sync_dirty[c] & copy);
+        if (!writemap[c])
+          continue;
+        d->dir_sync_dirty[c] &= ~copy;
+        int from = (last >= 0 && c - last - 1 <= SYNC_MAX_GAP) ? last + 1 : c;
+        memset(writemap + from, 1, c - from);
+        memcpy(buf + body + ((off_t)from << SYNC_CHUNK_SHIFT), (char *)d->dir + ((off_t)from << SYNC_CHUNK_SHIFT),
+               (c - from + 1) << SYNC_CHUNK_SHIFT);
+        last = c;
+      }
       d->dir_sync_in_progress = 1;
+      bytes = 0;
+      start_time = ink_get_hrtime();
     }
     size_t B = d->header->sync_serial & 1;
     off_t start = d->skip + (B ? dirlen : 0);
 
+    if (writepos >= body && writepos < body_end) {
+      // find the next run of chunks to write
+      int c = (writepos - body) >> SYNC_CHUNK_SHIFT, n;
+      while (c < chunks && !writemap[c])
+        c++;
+      for (n = c; n < chunks && writemap[n] && (n - c) < (SYNC_MAX_WRITE >> SYNC_CHUNK_SHIFT); n++)
+        ;
+      writepos = body + ((off_t)c << SYNC_CHUNK_SHIFT);
+      if (c < chunks) {
+        int l = (n - c) << SYNC_CHUNK_SHIFT;
+        aio_write(d->fd, buf + writepos, l, start + writepos);
+        writepos += l;
+        return EVENT_CONT;
+      }
+      writepos = body_end;
+    }
     if (!writepos) {
       // write header
       aio_write(d->fd, buf + writepos, headerlen, start + writepos);
       writepos += headerlen;
-    } else if (writepos < (off_t)dirlen - headerlen) {
-      // write part of body
+    } else if (writepos < body) {
+      // write the rest of the header, the segment freelists
       int l = SYNC_MAX_WRITE;
-      if (writepos + l > (off_t)dirlen - headerlen)
-        l = dirlen - headerlen - writepos;
+      if (writepos + l > body)
+        l = body - writepos;
       aio_write(d->fd, buf + writepos, l, start + writepos);
       writepos += l;
     } else if (writepos < (off_t)dirlen) {
@@ -1076,6 +1179,10 @@ Lrestart:
       writepos += headerlen;
     } else {
       d->dir_sync_in_progress = 0;
+      RecIncrGlobalRawStatSum(cache_rsb, cache_directory_sync_count_stat, 1);
+      RecIncrGlobalRawStatSum(cache_rsb, cache_directory_sync_bytes_stat, bytes);
+      RecIncrGlobalRawStatSum(cache_rsb, cache_directory_sync_usecs_stat, ink_hrtime_to_usec(ink_get_hrtime() - start_time));
+      Debug("cache_dir_sync", "Dir %s: wrote %" PRId64 " of %zu bytes", d->hash_id, bytes, dirlen);
       goto Ldone;
     }
     return EVENT_CONT;
@@ -1305,6 +1412,19 @@ EXCLUSIVE_REGRESSION_TEST(Cache_dir) (RegressionTest *t, int atype, int *status)
   int s = key.word(0) % d->segments, i, j;
   Dir *seg = dir_segment(s, d);
 
+  // test that an insert only dirties the chunks it touched
+  rprintf(t, "sync dirty test\n");
+  memset(d->dir_sync_dirty, 0, vol_dir_sync_chunks(d));
+  dir_insert(&key, d, &dir);
+  int dirty = 0;
+  for (i = 0; i < vol_dir_sync_chunks(d); i++)
+    dirty += d->dir_sync_dirty[i] != 0;
+  rprintf(t, "dirty chunks: %d\n", dirty);
+  char *b = (char *)dir_bucket(key.word(1) % d->buckets, seg);
+  if (!d->dir_sync_dirty[(b - (char *)d->dir) >> SYNC_CHUNK_SHIFT] || dirty > 2)
+    ret = REGRESSION_TEST_FAILED;
+  dir_delete(&key, d, &dir);
+
   // test insert
   rprintf(t, "insert test\n", free);
   int inserted = 0;
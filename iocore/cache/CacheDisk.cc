@@ -73,6 +73,8 @@ CacheDisk::open(char *s, off_t blocks, off_t askip, int ahw_sector_size, int fil
 
 CacheDisk::~CacheDisk()
 {
+  if (send_fd >= 0)
+    close(send_fd);
   if (path) {
     ats_free(path);
     for (int i = 0; i < (int) header->num_volumes; i++) {
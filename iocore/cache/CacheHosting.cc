@@ -190,7 +190,7 @@ CacheHostMatcher::NewEntry(matcher_line * line_info)
  *   End class HostMatcher
  *************************************************************/
 
-CacheHostTable::CacheHostTable(Cache * c, int typ)
+CacheHostTable::CacheHostTable(Cache * c, int typ, char *config_str)
 {
 
 
@@ -209,7 +209,7 @@ CacheHostTable::CacheHostTable(Cache * c, int typ)
   ats_free(config_file);
   hostMatch = NULL;
 
-  m_numEntries = this->BuildTable();
+  m_numEntries = config_str ? this->BuildTableFromString(config_str) : this->BuildTable();
 }
 
 CacheHostTable::~CacheHostTable()
@@ -39,6 +39,7 @@ Cache::open_read(Continuation * cont, CacheKey * key, CacheFragType type, char *
   ink_assert(caches[type] == this);
 
   Vol *vol = key_to_vol(key, hostname, host_len);
+  dir_prefetch(key, vol);
   Dir result, *last_collision = NULL;
   ProxyMutex *mutex = cont->mutex;
   OpenDirEntry *od = NULL;
@@ -100,6 +101,7 @@ Cache::open_read(Continuation * cont, CacheKey * key, CacheHTTPHdr * request,
   ink_assert(caches[type] == this);
 
   Vol *vol = key_to_vol(key, hostname, host_len);
+  dir_prefetch(key, vol);
   Dir result, *last_collision = NULL;
   ProxyMutex *mutex = cont->mutex;
   OpenDirEntry *od = NULL;
@@ -296,13 +298,14 @@ CacheVC::openReadFromWriter(int event, Event * e)
 #ifndef READ_WHILE_WRITER
   return openReadFromWriterFailure(CACHE_EVENT_OPEN_READ_FAILED, (Event *) -err);
 #else
+  CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+  if (!lock)
+    VC_SCHED_LOCK_RETRY();
+  cancel_writer_wait();
   if (_action.cancelled) {
     od = NULL; // only open for read so no need to close
     return free_CacheVC(this);
   }
-  CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
-  if (!lock)
-    VC_SCHED_LOCK_RETRY();
   od = vol->open_read(&first_key); // recheck in case the lock failed
   if (!od) {
     MUTEX_RELEASE(lock);
@@ -323,7 +326,10 @@ CacheVC::openReadFromWriter(int event, Event * e)
       return openReadStartHead(event, e);
     } else if (ret == EVENT_CONT) {
       ink_debug_assert(!write_vc);
-      VC_SCHED_WRITER_RETRY();
+      if (VC_WRITER_WAIT_OK())
+        VC_SCHED_WRITER_RETRY();
+      MUTEX_RELEASE(lock);
+      return openReadFromWriterFailure(CACHE_EVENT_OPEN_READ_FAILED, (Event *) -err);
     } else
       ink_assert(write_vc);
   } else {
@@ -359,7 +365,13 @@ CacheVC::openReadFromWriter(int event, Event * e)
     DDebug("cache_read_agg",
           "%p: key: %X writer: closed:%d, fragment:%d, retry: %d",
           this, first_key.word(1), write_vc->closed, write_vc->fragment, writer_lock_retry);
-    VC_SCHED_WRITER_RETRY();
+    if (VC_WRITER_WAIT_OK()) {
+      // the writer wakes us when it commits its first fragment or closes
+      writer_lock_retry++;
+      VC_WAIT_FOR_WRITER();
+    }
+    MUTEX_RELEASE(lock);
+    return openReadFromWriterFailure(CACHE_EVENT_OPEN_READ_FAILED, (Event *) - err);
   }
 
   CACHE_TRY_LOCK(writer_lock, write_vc->mutex, mutex->thread_holding);
@@ -519,6 +531,7 @@ CacheVC::openReadClose(int event, Event * e)
   CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
   if (!lock)
     VC_SCHED_LOCK_RETRY();
+  cancel_writer_wait();
 #ifdef HIT_EVACUATE
   if (f.hit_evacuate && dir_valid(vol, &first_dir) && closed > 0) {
     if (f.single_fragment)
@@ -546,6 +559,7 @@ CacheVC::openReadReadDone(int event, Event * e)
     CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
     if (!lock)
       VC_SCHED_LOCK_RETRY();
+    cancel_writer_wait();
     if (event == AIO_EVENT_DONE && !io.ok()) {
       dir_delete(&earliest_key, vol, &earliest_dir);
       goto Lerror;
@@ -587,8 +601,8 @@ CacheVC::openReadReadDone(int event, Event * e)
               this, first_key.word(1), (int)vio.ndone);
         goto Lerror;
       }
-      DDebug("cache_read_agg", "%p: key: %X ReadRead retrying: %d", this, first_key.word(1), (int)vio.ndone);
-      VC_SCHED_WRITER_RETRY(); // wait for writer
+      DDebug("cache_read_agg", "%p: key: %X ReadRead waiting: %d", this, first_key.word(1), (int)vio.ndone);
+      VC_WAIT_FOR_WRITER();
     }
     // fall through for truncated documents
   }
@@ -727,11 +741,28 @@ Lread: {
     // EVENT_IMMEDIATE events. So, we have to cancel that trigger and set
     // a new EVENT_INTERVAL event.
     cancel_trigger();
+    // the keys of the following fragments are unique to this write, so a
+    // RAM cache hit needs neither the directory nor the volume lock
+    if (!write_vc) {
+      Ptr<IOBufferData> data;
+      if (vol->ram_cache->get_unlocked(&key, &data)) {
+        Doc *ndoc = (Doc *) data->data();
+        if (ndoc->magic == DOC_MAGIC && ndoc->key == key && !ndoc->hlen) {
+          buf = data;
+          f.doc_from_ram_cache = true;
+          fragment++;
+          doc_pos = ndoc->prefix_len();
+          next_CacheKey(&key, &key);
+          return openReadMain(event, e);
+        }
+      }
+    }
     CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
     if (!lock) {
       SET_HANDLER(&CacheVC::openReadMain);
       VC_SCHED_LOCK_RETRY();
     }
+    cancel_writer_wait();
     if (dir_probe(&key, vol, &dir, &last_collision)) {
       SET_HANDLER(&CacheVC::openReadReadDone);
       int ret = do_read_call(&key);
@@ -753,9 +784,9 @@ Lread: {
               this, first_key.word(1), (int)vio.ndone);
         goto Lerror;
       }
-      DDebug("cache_read_agg", "%p: key: %X ReadMain retrying: %d", this, first_key.word(1), (int)vio.ndone);
+      DDebug("cache_read_agg", "%p: key: %X ReadMain waiting: %d", this, first_key.word(1), (int)vio.ndone);
       SET_HANDLER(&CacheVC::openReadMain);
-      VC_SCHED_WRITER_RETRY();
+      VC_WAIT_FOR_WRITER();
     }
     if (is_action_tag_set("cache"))
       ink_release_assert(false);
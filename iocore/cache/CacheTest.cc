@@ -414,5 +414,114 @@ EXCLUSIVE_REGRESSION_TEST(cache)(RegressionTest *t, int atype, int *pstatus) {
   return;
 }
 
+static inline uint64_t
+ram_cache_regression_rand(uint64_t *state)
+{
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+static void
+ram_cache_regression_key(INK_MD5 *key, uint64_t id)
+{
+  uint64_t state = id;
+  key->b[0] = ram_cache_regression_rand(&state);
+  key->b[1] = ram_cache_regression_rand(&state);
+}
+
+//
+// Replays one trace through each RAM cache algorithm: Zipf distributed
+// requests for a working set several times larger than the cache, with
+// every fifth request for an object that is never asked for again.  A
+// miss reads the object "from disk" and puts it.  Prints the hit rate
+// and time taken by each.
+//
+REGRESSION_TEST(ram_cache) (RegressionTest *t, int atype, int *pstatus) {
+  NOWARN_UNUSED(atype);
+  *pstatus = REGRESSION_TEST_PASSED;
+
+  const int n_objects = 50000;
+  const int n_requests = 500000;
+  const int64_t cache_size = 32 * 1024 * 1024;
+  const char *names[] = { "CLFUS", "LRU", "TLFU" };
+  double hit_rate[3];
+
+  CacheVol cache_vol;
+  cache_vol.vol_rsb = cache_rsb;
+  Vol *vol = NEW(new Vol);
+  vol->cache_vol = &cache_vol;
+
+  double *cdf = (double *)ats_malloc(n_objects * sizeof(double));
+  double sum = 0;
+  for (int i = 0; i < n_objects; i++)
+    cdf[i] = (sum += 1.0 / pow(i + 1, 0.9));
+  for (int i = 0; i < n_objects; i++)
+    cdf[i] /= sum;
+
+  for (int a = 0; a < 3; a++) {
+    RamCache *cache = a == 0 ? new_RamCacheCLFUS() : a == 1 ? new_RamCacheLRU() : new_RamCacheTLFU();
+    uint64_t state = 1;
+    int hits = 0;
+    cache->init(cache_size, vol);
+
+    ink_hrtime start = ink_get_hrtime_internal();
+    for (int r = 0; r < n_requests; r++) {
+      uint64_t x = ram_cache_regression_rand(&state);
+      uint64_t id;
+      if (x % 5 == 0)
+        id = n_objects + r;                     // one hit wonder
+      else {
+        double u = (double)(x >> 11) / (double)(1ULL << 53);
+        int lo = 0, hi = n_objects - 1;
+        while (lo < hi) {
+          int mid = (lo + hi) / 2;
+          if (cdf[mid] < u)
+            lo = mid + 1;
+          else
+            hi = mid;
+        }
+        id = lo;
+      }
+      INK_MD5 key;
+      Ptr<IOBufferData> data;
+      ram_cache_regression_key(&key, id);
+      if (cache->get(&key, &data, 0, (uint32_t)id))
+        hits++;
+      else {
+        int64_t size_index = BUFFER_SIZE_INDEX_1K + (int64_t)(id % 4);       // 1K to 8K
+        data = new_IOBufferData(size_index, MEMALIGNED);
+        cache->put(&key, data, (uint32_t)data->block_size(), false, 0, (uint32_t)id);
+      }
+    }
+    ink_hrtime elapsed = ink_get_hrtime_internal() - start;
+    hit_rate[a] = (double)hits / n_requests;
+    rprintf(t, "%s hit rate %d.%d%%, %d ns per request\n", names[a], (int)(1000 * hit_rate[a]) / 10,
+            (int)(1000 * hit_rate[a]) % 10, (int)(elapsed / n_requests));
+
+    if (a == 2) {
+      // the interface contract, on a key nothing else uses
+      INK_MD5 key;
+      Ptr<IOBufferData> data = new_IOBufferData(BUFFER_SIZE_INDEX_1K, MEMALIGNED), got;
+      ram_cache_regression_key(&key, (uint64_t)-1);
+      if (!cache->put(&key, data, (uint32_t)data->block_size(), false, 1, 2) ||
+          !cache->get(&key, &got, 1, 2) || got != data ||
+          !cache->fixup(&key, 1, 2, 3, 4) || cache->get(&key, &got, 1, 2) ||
+          !cache->get(&key, &got, 3, 4) || !cache->get_unlocked(&key, &got) || got != data) {
+        rprintf(t, "TLFU get/put/fixup mismatch\n");
+        *pstatus = REGRESSION_TEST_FAILED;
+      }
+    }
+  }
+  ats_free(cdf);
+  delete vol;
+
+  if (hit_rate[2] < hit_rate[1]) {
+    rprintf(t, "TLFU hit rate below LRU\n");
+    *pstatus = REGRESSION_TEST_FAILED;
+  }
+}
+
 void force_link_CacheTest() {
 }
@@ -106,6 +106,7 @@ CacheVC::updateVector(int event, Event *e)
       */
       if (alternate_index >= 0)
         alternate.copy_frag_offsets_from(write_vector->get(alternate_index));
+      alternate.variant_key_set(HttpTransactCache::CalcVariantKey(alternate.request_get(), alternate.response_get()));
       alternate_index = write_vector->insert(&alternate, alternate_index);
     }
 
@@ -945,6 +946,7 @@ Vol::periodic_scan()
 void
 Vol::agg_wrap()
 {
+  agg_written += skip + len - header->write_pos;
   header->write_pos = start;
   header->phase = !header->phase;
 
@@ -1056,6 +1058,7 @@ Lagain:
 
   // set write limit
   header->agg_pos = header->write_pos + agg_buf_pos;
+  agg_written += agg_buf_pos;
 
   io.aiocb.aio_fildes = fd;
   io.aiocb.aio_offset = header->write_pos;
@@ -1336,6 +1339,9 @@ CacheVC::openWriteWriteDone(int event, Event *e)
     write_pos += write_len;
     dir_insert(&key, vol, &dir);
     DDebug("cache_insert", "WriteDone: %X, %X, %d", key.word(0), first_key.word(0), write_len);
+    // readers following us can now read this fragment
+    if (od && od->readers.head)
+      od->wake_readers(mutex->thread_holding, false);
     blocks = iobufferblock_skip(blocks, &offset, &length, write_len);
     next_CacheKey(&key, &key);
   }
@@ -1631,6 +1637,7 @@ Cache::open_write(Continuation *cont, CacheKey *key, CacheFragType frag_type,
   c->base_stat = cache_write_active_stat;
   c->vol = key_to_vol(key, hostname, host_len);
   Vol *vol = c->vol;
+  dir_prefetch(key, vol);
   CACHE_INCREMENT_DYN_STAT(c->base_stat + CACHE_STAT_ACTIVE);
   c->first_key = c->key = *key;
   c->frag_type = frag_type;
@@ -1713,6 +1720,7 @@ Cache::open_write(Continuation *cont, CacheKey *key, CacheHTTPInfo *info, time_t
   c->frag_type = CACHE_FRAG_TYPE_HTTP;
   c->vol = key_to_vol(key, hostname, host_len);
   Vol *vol = c->vol;
+  dir_prefetch(key, vol);
   c->info = info;
   if (c->info && (uintptr_t) info != CACHE_ALLOW_MULTIPLE_WRITES) {
     /*
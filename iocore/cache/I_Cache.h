@@ -49,11 +49,16 @@
 
 #define RAM_CACHE_ALGORITHM_CLFUS        0
 #define RAM_CACHE_ALGORITHM_LRU          1
+#define RAM_CACHE_ALGORITHM_TLFU         2
 
 #define CACHE_COMPRESSION_NONE           0
 #define CACHE_COMPRESSION_FASTLZ         1
 #define CACHE_COMPRESSION_LIBZ           2
 #define CACHE_COMPRESSION_LIBLZMA        3
+#define CACHE_COMPRESSION_LZ4            4
+#define CACHE_COMPRESSION_ZSTD           5
+// LZ4 for entries which have been hit since insertion, zstd for the rest
+#define CACHE_COMPRESSION_TIERED         6
 
 struct CacheVC;
 #ifdef HTTP_CACHE
@@ -185,6 +190,14 @@ struct CacheVConnection:public VConnection
   */
   virtual bool is_pread_capable() = 0;
 
+  /** Allow the VC to hand out large fragments as blocks which refer to
+      the cache disk (see IOBufferData::_fd) rather than reading them
+      into memory. Only for readers which pass the data unmodified to a
+      NetVConnection which is_zero_copy_capable().
+      @return @c true if the VC may do so.
+  */
+  virtual bool set_zero_copy() { return false; }
+
   CacheVConnection();
 };
 
@@ -54,6 +54,10 @@ struct CacheVC;
 
 #define SYNC_MAX_WRITE                  (2 * 1024 * 1024)
 #define SYNC_DELAY                      HRTIME_MSECONDS(500)
+#define SYNC_CHUNK_SHIFT                STORE_BLOCK_SHIFT
+#define SYNC_CHUNK_SIZE                 (1 << SYNC_CHUNK_SHIFT)
+#define SYNC_MAX_GAP                    8       // clean chunks rewritten to join two dirty runs
+#define SYNC_COPY(_serial)              (1 << ((_serial) & 1))
 #define DO_NOT_REMOVE_THIS              0
 
 // Debugging Options
@@ -223,7 +227,7 @@ LINK_FORWARD_DECLARATION(CacheVC, opendir_link) // forward declaration
 struct OpenDirEntry
 {
   DLL<CacheVC, Link_CacheVC_opendir_link> writers;       // list of all the current writers
-  DLL<CacheVC, Link_CacheVC_opendir_link> readers;         // list of all the current readers - not used
+  DLL<CacheVC, Link_CacheVC_opendir_link> readers;         // readers waiting for the next fragment
   CacheHTTPInfoVector vector;   // Vector for the http document. Each writer
                                 // maintains a pointer to this vector and
                                 // writes it down to disk.
@@ -241,6 +245,7 @@ struct OpenDirEntry
   LINK(OpenDirEntry, link);
 
   int wait(CacheVC *c, int msec);
+  void wake_readers(EThread *t, bool all);
 
   bool has_multiple_writers()
   {
@@ -267,12 +272,17 @@ struct CacheSync: public Continuation
   char *buf;
   size_t buflen;
   off_t writepos;
+  uint8_t *writemap;    // chunks of the directory copy in this sync
+  int writemap_len;
+  int64_t bytes;
+  ink_hrtime start_time;
   AIOCallbackInternal io;
   Event *trigger;
   int mainEvent(int event, Event *e);
   void aio_write(int fd, char *b, int n, off_t o);
 
-  CacheSync():Continuation(new_ProxyMutex()), vol(0), buf(0), buflen(0), writepos(0), trigger(0)
+  CacheSync():Continuation(new_ProxyMutex()), vol(0), buf(0), buflen(0), writepos(0),
+    writemap(0), writemap_len(0), bytes(0), start_time(0), trigger(0)
   {
     SET_HANDLER(&CacheSync::mainEvent);
   }
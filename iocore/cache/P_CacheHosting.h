@@ -103,7 +103,9 @@ class CacheHostTable
 public:
   // Parameter name must not be deallocated before this
   //  object is
-  CacheHostTable(Cache *c, int typ);
+  // The table is read from the hosting config file unless config_str
+  //  is given
+  CacheHostTable(Cache *c, int typ, char *config_str = NULL);
    ~CacheHostTable();
   int BuildTable();
   int BuildTableFromString(char *str);
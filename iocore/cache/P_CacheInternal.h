@@ -58,8 +58,6 @@ struct EvacuationBlock;
 #endif
 
 #define AIO_SOFT_FAILURE                -100000
-// retry read from writer delay
-#define WRITER_RETRY_DELAY  HRTIME_MSECONDS(50)
 
 #define CACHE_READY(_x) (CacheProcessor::cache_ready & (1 << (_x)))
 
@@ -99,17 +97,33 @@ struct EvacuationBlock;
   do { \
     ink_assert(!trigger); \
     writer_lock_retry++; \
-    ink_hrtime _t = WRITER_RETRY_DELAY; \
+    ink_hrtime _t = HRTIME_MSECONDS(cache_config_read_while_writer_retry_delay); \
     if (writer_lock_retry > 2) \
-      _t = WRITER_RETRY_DELAY * 2; \
-    else if (writer_lock_retry > 5) \
-      _t = WRITER_RETRY_DELAY * 10; \
-    else if (writer_lock_retry > 10) \
-      _t = WRITER_RETRY_DELAY * 100; \
+      _t *= 2; \
     trigger = mutex->thread_holding->schedule_in_local(this, _t); \
     return EVENT_CONT; \
   } while (0)
 
+// Wait on the OpenDirEntry of a writer which is still active for it to
+// commit the next fragment. The writer wakes the reader as soon as the
+// fragment is in the directory; the timeout is only a backstop.
+#define VC_WAIT_FOR_WRITER() \
+  do { \
+    OpenDirEntry *_od = vol->open_read(&first_key); \
+    if (!_od) \
+      VC_SCHED_WRITER_RETRY(); \
+    return _od->wait(this, cache_config_read_while_writer_retry_delay * 2); \
+  } while (0)
+
+// Whether a reader which has not yet got a fragment from a writer should
+// keep waiting on it. The reader gives up after max_retries retries, or
+// with max_wait set, once it has waited that many msec, so that slow
+// origins need not send every reader upstream.
+#define VC_WRITER_WAIT_OK() \
+  (cache_config_read_while_writer_max_wait > 0 ? \
+   ink_get_hrtime() - start_time < HRTIME_MSECONDS(cache_config_read_while_writer_max_wait) : \
+   writer_lock_retry < cache_config_read_while_writer_max_retries)
+
 
   // cache stats definitions
 enum
@@ -120,9 +134,11 @@ enum
   cache_ram_cache_bytes_total_stat,
   cache_direntries_total_stat,
   cache_direntries_used_stat,
+  cache_direntries_hugepage_advised_bytes_stat,
   cache_ram_cache_hits_stat,
   cache_ram_cache_misses_stat,
   cache_pread_count_stat,
+  cache_zero_copy_fragments_stat,
   cache_percent_full_stat,
   cache_lookup_active_stat,
   cache_lookup_success_stat,
@@ -147,6 +163,9 @@ enum
   cache_scan_success_stat,
   cache_scan_failure_stat,
   cache_directory_collision_count_stat,
+  cache_directory_sync_count_stat,
+  cache_directory_sync_bytes_stat,
+  cache_directory_sync_usecs_stat,
   cache_single_fragment_document_count_stat,
   cache_two_fragment_document_count_stat,
   cache_three_plus_plus_fragment_document_count_stat,
@@ -158,6 +177,27 @@ enum
   cache_hdr_vector_marshal_stat,
   cache_hdr_marshal_stat,
   cache_hdr_marshal_bytes_stat,
+  // per RAM cache compression codec, in CACHE_COMPRESSION_* order
+  cache_ram_cache_fastlz_bytes_in_stat,
+  cache_ram_cache_fastlz_bytes_out_stat,
+  cache_ram_cache_fastlz_compress_usecs_stat,
+  cache_ram_cache_fastlz_decompress_usecs_stat,
+  cache_ram_cache_libz_bytes_in_stat,
+  cache_ram_cache_libz_bytes_out_stat,
+  cache_ram_cache_libz_compress_usecs_stat,
+  cache_ram_cache_libz_decompress_usecs_stat,
+  cache_ram_cache_liblzma_bytes_in_stat,
+  cache_ram_cache_liblzma_bytes_out_stat,
+  cache_ram_cache_liblzma_compress_usecs_stat,
+  cache_ram_cache_liblzma_decompress_usecs_stat,
+  cache_ram_cache_lz4_bytes_in_stat,
+  cache_ram_cache_lz4_bytes_out_stat,
+  cache_ram_cache_lz4_compress_usecs_stat,
+  cache_ram_cache_lz4_decompress_usecs_stat,
+  cache_ram_cache_zstd_bytes_in_stat,
+  cache_ram_cache_zstd_bytes_out_stat,
+  cache_ram_cache_zstd_compress_usecs_stat,
+  cache_ram_cache_zstd_decompress_usecs_stat,
   cache_stat_count
 };
 
@@ -215,8 +255,13 @@ extern int cache_config_max_doc_size;
 extern int cache_config_min_average_object_size;
 extern int cache_config_agg_write_backlog;
 extern int cache_config_enable_checksum;
+extern int cache_config_zero_copy_min_fragment;
+extern int cache_config_wait_for_all_volumes;
 extern int cache_config_alt_rewrite_max_size;
 extern int cache_config_read_while_writer;
+extern int cache_config_read_while_writer_max_retries;
+extern int cache_config_read_while_writer_retry_delay;
+extern int cache_config_read_while_writer_max_wait;
 extern char cache_system_config_directory[PATH_NAME_MAX + 1];
 extern int cache_clustering_enabled;
 extern int cache_config_agg_write_backlog;
@@ -230,6 +275,7 @@ extern int cache_config_hit_evacuate_size_limit;
 extern int cache_config_force_sector_size;
 extern int cache_config_target_fragment_size;
 extern int cache_config_mutex_retry_delay;
+extern int cache_config_dir_hugepages;
 
 // CacheVC
 struct CacheVC: public CacheVConnection
@@ -280,6 +326,7 @@ struct CacheVC: public CacheVConnection
   }
 
   bool writer_done();
+  void cancel_writer_wait();
   int calluser(int event);
   int callcont(int event);
   int die();
@@ -357,6 +404,7 @@ struct CacheVC: public CacheVConnection
   virtual void get_http_info(CacheHTTPInfo ** info);
 #endif
   virtual bool is_pread_capable();
+  virtual bool set_zero_copy();
   virtual bool set_pin_in_cache(time_t time_pin);
   virtual time_t get_pin_in_cache();
   virtual bool set_disk_io_priority(int priority);
@@ -453,6 +501,7 @@ struct CacheVC: public CacheVConnection
   int fragment;
   int scan_msec_delay;
   CacheVC *write_vc;
+  OpenDirEntry *wait_od;        // OpenDirEntry of write_vc this reader is waiting on
   char *hostname;
   int host_len;
   int header_to_write_len;
@@ -482,6 +531,7 @@ struct CacheVC: public CacheVConnection
       unsigned int rewrite_resident_alt:1;
       unsigned int readers:1;
       unsigned int doc_from_ram_cache:1;
+      unsigned int zero_copy:1; // large fragments may be sent from the disk
 #ifdef HIT_EVACUATE
       unsigned int hit_evacuate:1;
 #endif
@@ -569,6 +619,7 @@ free_CacheVC(CacheVC *cont)
     cont->trigger->cancel();
   ink_assert(!cont->is_io_in_progress());
   ink_assert(!cont->od);
+  ink_assert(!cont->wait_od);
   /* calling cont->io.action = NULL causes compile problem on 2.6 solaris
      release build....wierd??? For now, null out continuation and mutex
      of the action separately */
@@ -577,6 +628,7 @@ free_CacheVC(CacheVC *cont)
   cont->io.mutex.clear();
   cont->io.aio_result = 0;
   cont->io.aiocb.aio_nbytes = 0;
+  cont->io.prefetch_nbytes = 0;
   cont->io.aiocb.aio_reqprio = AIO_DEFAULT_PRIORITY;
 #ifdef HTTP_CACHE
   cont->request.reset();
@@ -743,6 +795,16 @@ CacheVC::writer_done()
   return false;
 }
 
+TS_INLINE void
+CacheVC::cancel_writer_wait()
+{
+  // the writer unlinks us if it woke us up, otherwise our timeout fired
+  if (wait_od) {
+    wait_od->readers.remove(this);
+    wait_od = NULL;
+  }
+}
+
 TS_INLINE int
 Vol::close_write(CacheVC *cont)
 {
@@ -857,6 +919,19 @@ dir_insert_lock(CacheKey *key, Vol *d, Dir *to_part, ProxyMutex *m)
   return dir_insert(key, d, to_part);
 }
 
+// Start pulling the directory bucket for key into the CPU cache so that
+// it is resident by the time dir_probe() runs under the Vol lock. A
+// bucket is DIR_DEPTH * SIZEOF_DIR bytes and is not line aligned, so
+// touch both ends of it. With a directory much larger than the CPU
+// cache this hides a third to a half of the miss dir_probe() would take.
+TS_INLINE void
+dir_prefetch(CacheKey *key, Vol *d)
+{
+  Dir *b = dir_bucket(key->word(1) % d->buckets, dir_segment(key->word(0) % d->segments, d));
+  __builtin_prefetch(b);
+  __builtin_prefetch((char *) b + DIR_DEPTH * SIZEOF_DIR - 1);
+}
+
 TS_INLINE int
 dir_overwrite_lock(CacheKey *key, Vol *d, Dir *to_part, ProxyMutex *m, Dir *overwrite, bool must_overwrite = true)
 {
@@ -956,6 +1031,8 @@ struct Cache
   int64_t cache_size;             //in store block size
   CacheHostTable *hosttable;
   volatile int total_initialized_vol;
+  bool open_started;
+  bool open_waiting;              // open_done() is waiting for a ready volume for every host
   int scheme;
 
   int open(bool reconfigure, bool fix);
@@ -992,15 +1069,17 @@ struct Cache
   Action *link(Continuation *cont, CacheKey *from, CacheKey *to, CacheFragType type, char *hostname, int host_len);
   Action *deref(Continuation *cont, CacheKey *key, CacheFragType type, char *hostname, int host_len);
 
-  void vol_initialized(bool result);
+  void vol_initialized(Vol *vol, bool result);
 
   int open_done();
+  int open_finish();
 
   Vol *key_to_vol(CacheKey *key, char *hostname, int host_len);
 
   Cache()
     : cache_read_done(0), total_good_nvol(0), total_nvol(0), ready(CACHE_INITIALIZING), cache_size(0),  // in store block size
-      hosttable(NULL), total_initialized_vol(0), scheme(CACHE_NONE_TYPE)
+      hosttable(NULL), total_initialized_vol(0), open_started(false), open_waiting(false),
+      scheme(CACHE_NONE_TYPE)
     { }
 };
 
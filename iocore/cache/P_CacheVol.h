@@ -134,6 +134,7 @@ struct Vol: public Continuation
   char *hash_id;
   INK_MD5 hash_id_md5;
   int fd;
+  int send_fd;
 
   char *raw_dir;
   Dir *dir;
@@ -157,6 +158,10 @@ struct Vol: public Continuation
   char *agg_buffer;
   int agg_todo_size;
   int agg_buf_pos;
+  // bytes the aggregator has claimed since startup, counting a wrap as
+  // the rest of the volume and a clear as all of it: a range is gone
+  // once this passes its distance from header->agg_pos.
+  volatile int64_t agg_written;
 
   Event *trigger;
 
@@ -179,6 +184,16 @@ struct Vol: public Continuation
   bool dir_sync_waiting;
   bool dir_sync_in_progress;
   bool writing_end_marker;
+  // one byte per SYNC_CHUNK_SIZE of directory entries, SYNC_COPY() bits
+  // set for each on disk copy which has not seen the latest change
+  uint8_t *dir_sync_dirty;
+  uint8_t dir_sync_full;    // SYNC_COPY() bits of copies needing a full write
+  bool ready;               // directory read and recovered, in gvol
+  // startup timing, logged by dir_init_done()
+  ink_hrtime init_start;
+  ink_hrtime dir_read_done;
+  ink_hrtime recover_done;
+  uint64_t used_direntries; // counted by dir_init_done()
 
   CacheKey first_fragment_key;
   int64_t first_fragment_offset;
@@ -250,11 +265,12 @@ struct Vol: public Continuation
   uint32_t round_to_approx_size(uint32_t l);
 
   Vol()
-    : Continuation(new_ProxyMutex()), path(NULL), fd(-1),
+    : Continuation(new_ProxyMutex()), path(NULL), fd(-1), send_fd(-1),
       dir(0), buckets(0), recover_pos(0), prev_recover_pos(0), scan_pos(0), skip(0), start(0),
-      len(0), data_blocks(0), hit_evacuate_window(0), agg_todo_size(0), agg_buf_pos(0), trigger(0),
+      len(0), data_blocks(0), hit_evacuate_window(0), agg_todo_size(0), agg_buf_pos(0), agg_written(0), trigger(0),
       evacuate_size(0), disk(NULL), last_sync_serial(0), last_write_serial(0), recover_wrapped(false),
-      dir_sync_waiting(0), dir_sync_in_progress(0), writing_end_marker(0) {
+      dir_sync_waiting(0), dir_sync_in_progress(0), writing_end_marker(0), dir_sync_dirty(0), dir_sync_full(0),
+      ready(false), init_start(0), dir_read_done(0), recover_done(0), used_direntries(0) {
     open_dir.mutex = mutex;
     agg_buffer = (char *)ats_memalign(sysconf(_SC_PAGESIZE), AGG_SIZE);
     memset(agg_buffer, 0, AGG_SIZE);
@@ -347,6 +363,21 @@ vol_direntries(Vol *d)
   return d->buckets * DIR_DEPTH * d->segments;
 }
 
+TS_INLINE int
+vol_dir_sync_chunks(Vol *d)
+{
+  return (int)(ROUND_TO_STORE_BLOCK(((size_t)d->buckets) * DIR_DEPTH * d->segments * SIZEOF_DIR) >> SYNC_CHUNK_SHIFT);
+}
+
+// mark the directory bytes [p, p + n) as changed in both copies on disk
+TS_INLINE void
+vol_dir_dirty(Vol *d, void *p, size_t n = SIZEOF_DIR)
+{
+  size_t o = (char *)p - (char *)d->dir;
+  memset(d->dir_sync_dirty + (o >> SYNC_CHUNK_SHIFT), SYNC_COPY(0) | SYNC_COPY(1),
+         ((o + n - 1) >> SYNC_CHUNK_SHIFT) - (o >> SYNC_CHUNK_SHIFT) + 1);
+}
+
 TS_INLINE int
 vol_out_of_phase_valid(Vol *d, Dir *e)
 {
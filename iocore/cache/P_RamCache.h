@@ -33,6 +33,9 @@ struct RamCache {
   virtual int get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0) = 0;
   virtual int put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0) = 0;
   virtual int fixup(INK_MD5 *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2) = 0;
+  // lookup by key alone without holding the Vol mutex, for keys which are unique to a write;
+  // returns 0 unless the implementation does its own locking
+  virtual int get_unlocked(INK_MD5 *key, Ptr<IOBufferData> *ret_data) { (void)key; (void)ret_data; return 0; }
 
   virtual void init(int64_t max_bytes, Vol *vol) = 0;
   virtual ~RamCache() {};
@@ -40,5 +43,6 @@ struct RamCache {
 
 RamCache *new_RamCacheLRU();
 RamCache *new_RamCacheCLFUS();
+RamCache *new_RamCacheTLFU();
 
 #endif /* _P_RAM_CACHE_H__ */
@@ -32,18 +32,34 @@
 #if TS_HAS_LZMA
 #include <lzma.h>
 #endif
+#if TS_HAS_LZ4
+#include <lz4.h>
+#endif
+#if TS_HAS_ZSTD
+#include <zstd.h>
+#endif
 
 #define REQUIRED_COMPRESSION 0.9 // must get to this size or declared incompressible
 #define REQUIRED_SHRINK 0.8 // must get to this size or keep orignal buffer (with padding)
 #define HISTORY_HYSTERIA 10 // extra temporary history
 #define ENTRY_OVERHEAD 256 // per-entry overhead to consider when computing cache value/size
 #define LZMA_BASE_MEMLIMIT (64 * 1024 * 1024)
+#define ZSTD_COMPRESSION_LEVEL 3
+#define COMPRESS_BATCH 32 // entries compressed per pair of Vol lock holds
 //#define CHECK_ACOUNTING 1 // very expensive double checking of all sizes
 
 #define REQUEUE_HITS(_h) ((_h) ? 1 : 0)
 #define CACHE_VALUE_HITS_SIZE(_h, _s) ((float)((_h)+1) / ((_s) + ENTRY_OVERHEAD))
 #define CACHE_VALUE(_x) CACHE_VALUE_HITS_SIZE((_x)->hits, (_x)->size)
 
+// per codec stats are laid out in CACHE_COMPRESSION_* order, 4 per codec
+#define CODEC_BYTES_IN 0
+#define CODEC_BYTES_OUT 1
+#define CODEC_COMPRESS_USECS 2
+#define CODEC_DECOMPRESS_USECS 3
+#define CODEC_STAT(_ctype, _which) \
+  (cache_ram_cache_fastlz_bytes_in_stat + ((_ctype) - CACHE_COMPRESSION_FASTLZ) * 4 + (_which))
+
 struct RamCacheCLFUSEntry {
   INK_MD5 key;
   uint32_t auxkey1;
@@ -169,6 +185,7 @@ int RamCacheCLFUS::get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxke
       if (!e->flag_bits.lru) { // in memory
         e->hits++;
         if (e->flag_bits.compressed) {
+          ink_hrtime start = ink_get_hrtime_internal();
           b = (char*)ats_malloc(e->len);
           switch (e->flag_bits.compressed) {
             default: goto Lfailed;
@@ -195,8 +212,25 @@ int RamCacheCLFUS::get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxke
                 goto Lfailed;
               break;
             }
+#endif
+#if TS_HAS_LZ4
+            case CACHE_COMPRESSION_LZ4: {
+              if ((int)e->len != LZ4_decompress_safe(e->data->data(), b, (int)e->compressed_len, (int)e->len))
+                goto Lfailed;
+              break;
+            }
+#endif
+#if TS_HAS_ZSTD
+            case CACHE_COMPRESSION_ZSTD: {
+              size_t l = ZSTD_decompress(b, e->len, e->data->data(), e->compressed_len);
+              if (ZSTD_isError(l) || l != e->len)
+                goto Lfailed;
+              break;
+            }
 #endif
           }
+          CACHE_SUM_DYN_STAT_THREAD(CODEC_STAT(e->flag_bits.compressed, CODEC_DECOMPRESS_USECS),
+                                    (ink_get_hrtime_internal() - start) / HRTIME_USECOND);
           IOBufferData *data = new_xmalloc_IOBufferData(b, e->len);
           data->_mem_type = DEFAULT_ALLOC;
           if (!e->flag_bits.copy) { // don't bother if we have to copy anyway
@@ -300,132 +334,213 @@ RamCacheCLFUSEntry *RamCacheCLFUS::destroy(RamCacheCLFUSEntry *e) {
   return ret;
 }
 
-void RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most) {
-  if (!cache_config_ram_cache_compress)
-    return;
-  MUTEX_TAKE_LOCK(vol->mutex, thread);
-  if (!compressed) {
-    compressed = lru[0].head;
-    ncompressed = 0;
-  }
-  float target = (cache_config_ram_cache_compress_percent / 100.0) * objects;
-  int n = 0;
-  char *b = 0, *bb = 0;
-  while (compressed && target > ncompressed) {
-    RamCacheCLFUSEntry *e = compressed;
-    if (e->flag_bits.incompressible || e->flag_bits.compressed)
-      goto Lcontinue;
-    n++;
-    if (do_at_most < n)
-      break;
-    {
-      e->compressed_len = e->size;
-      uint32_t l = 0;
-      int ctype = cache_config_ram_cache_compress;
-      switch (ctype) {
-        default: goto Lcontinue;
-        case CACHE_COMPRESSION_FASTLZ: l = (uint32_t)((double)e->len * 1.05 + 66); break;
+// An entry snapshotted under the Vol lock and compressed without it.
+struct RamCacheCLFUSCompressJob {
+  RamCacheCLFUSEntry *e;
+  INK_MD5 key;
+  Ptr<IOBufferData> data;
+  uint32_t len;
+  uint32_t size;
+  int ctype;
+  char *b;       // exact sized result, NULL if failed
+  uint32_t l;    // result length
+  bool compressed;
+  bool incompressible;
+};
+
+static int ram_cache_compression_type(RamCacheCLFUSEntry *e) {
+  if (cache_config_ram_cache_compress == CACHE_COMPRESSION_TIERED)
+    return e->hits > 1 ? CACHE_COMPRESSION_LZ4 : CACHE_COMPRESSION_ZSTD;
+  return cache_config_ram_cache_compress;
+}
+
+// Compress without holding the Vol lock: everything here works on the
+// snapshot, including the copy into an exact sized buffer.
+static void ram_cache_compress_job(Vol *vol, RamCacheCLFUSCompressJob &j) {
+  uint32_t l = 0;
+  char *b = 0;
+  bool failed = false;
+  ink_hrtime start = ink_get_hrtime_internal();
+  j.b = 0;
+  j.compressed = false;
+  j.incompressible = false;
+  switch (j.ctype) {
+    default: return;
+    case CACHE_COMPRESSION_FASTLZ: l = (uint32_t)((double)j.len * 1.05 + 66); break;
 #if TS_HAS_LIBZ
-        case CACHE_COMPRESSION_LIBZ: l = (uint32_t)compressBound(e->len); break;
+    case CACHE_COMPRESSION_LIBZ: l = (uint32_t)compressBound(j.len); break;
 #endif
 #if TS_HAS_LZMA
-        case CACHE_COMPRESSION_LIBLZMA: l = e->len; break;
+    case CACHE_COMPRESSION_LIBLZMA: l = j.len; break;
 #endif
+#if TS_HAS_LZ4
+    case CACHE_COMPRESSION_LZ4: l = (uint32_t)LZ4_compressBound((int)j.len); break;
+#endif
+#if TS_HAS_ZSTD
+    case CACHE_COMPRESSION_ZSTD: l = (uint32_t)ZSTD_compressBound(j.len); break;
+#endif
+  }
+  b = (char*)ats_malloc(l);
+  switch (j.ctype) {
+    case CACHE_COMPRESSION_FASTLZ:
+      if (j.len < 16) {
+        failed = true;
+        break;
       }
-      // store transient data for lock release
-      Ptr<IOBufferData> edata = e->data;
-      uint32_t elen = e->len;
-      INK_MD5 key = e->key;
-      MUTEX_UNTAKE_LOCK(vol->mutex, thread);
-      b = (char*)ats_malloc(l);
-      bool failed = false;
-      switch (ctype) {
-        default: goto Lfailed;
-        case CACHE_COMPRESSION_FASTLZ:
-          if (e->len < 16) goto Lfailed;
-          if ((l = fastlz_compress(edata->data(), elen, b)) <= 0)
-            failed = true;
-          break;
+      if ((l = fastlz_compress(j.data->data(), j.len, b)) <= 0)
+        failed = true;
+      break;
 #if TS_HAS_LIBZ
-        case CACHE_COMPRESSION_LIBZ: {
-          uLongf ll = l;
-          if ((Z_OK != compress((Bytef*)b, &ll, (Bytef*)edata->data(), elen)))
-            failed = true;
-          l = (int)ll;
-          break;
-        }
+    case CACHE_COMPRESSION_LIBZ: {
+      uLongf ll = l;
+      if ((Z_OK != compress((Bytef*)b, &ll, (Bytef*)j.data->data(), j.len)))
+        failed = true;
+      l = (int)ll;
+      break;
+    }
 #endif
 #if TS_HAS_LZMA
-        case CACHE_COMPRESSION_LIBLZMA: {
-          size_t pos = 0, ll = l;
-          if (LZMA_OK != lzma_easy_buffer_encode(LZMA_PRESET_DEFAULT, LZMA_CHECK_NONE, NULL,
-                                                 (uint8_t*)edata->data(), elen, (uint8_t*)b, &pos, ll))
-            failed = true;
-          l = (int)pos;
-          break;
-        }
+    case CACHE_COMPRESSION_LIBLZMA: {
+      size_t pos = 0, ll = l;
+      if (LZMA_OK != lzma_easy_buffer_encode(LZMA_PRESET_DEFAULT, LZMA_CHECK_NONE, NULL,
+                                             (uint8_t*)j.data->data(), j.len, (uint8_t*)b, &pos, ll))
+        failed = true;
+      l = (int)pos;
+      break;
+    }
+#endif
+#if TS_HAS_LZ4
+    case CACHE_COMPRESSION_LZ4: {
+      int ll = LZ4_compress_default(j.data->data(), b, (int)j.len, (int)l);
+      if (ll <= 0)
+        failed = true;
+      l = (uint32_t)ll;
+      break;
+    }
 #endif
+#if TS_HAS_ZSTD
+    case CACHE_COMPRESSION_ZSTD: {
+      size_t ll = ZSTD_compress(b, l, j.data->data(), j.len, ZSTD_COMPRESSION_LEVEL);
+      if (ZSTD_isError(ll))
+        failed = true;
+      l = (uint32_t)ll;
+      break;
+    }
+#endif
+  }
+  if (!failed) {
+    if (l > REQUIRED_COMPRESSION * j.len)
+      j.incompressible = true;
+    if (l > REQUIRED_SHRINK * j.size)
+      failed = true;
+  }
+  if (failed) {
+    ats_free(b);
+    return;
+  }
+  if (l < j.len) {
+    j.compressed = true;
+    j.b = (char*)ats_malloc(l);
+    memcpy(j.b, b, l);
+    j.l = l;
+  } else {
+    j.b = (char*)ats_malloc(j.len);
+    memcpy(j.b, j.data->data(), j.len);
+    j.l = j.len;
+  }
+  ats_free(b);
+  CACHE_SUM_DYN_STAT_THREAD(CODEC_STAT(j.ctype, CODEC_BYTES_IN), j.len);
+  CACHE_SUM_DYN_STAT_THREAD(CODEC_STAT(j.ctype, CODEC_BYTES_OUT), j.l);
+  CACHE_SUM_DYN_STAT_THREAD(CODEC_STAT(j.ctype, CODEC_COMPRESS_USECS),
+                            (ink_get_hrtime_internal() - start) / HRTIME_USECOND);
+}
+
+void RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most) {
+  if (!cache_config_ram_cache_compress)
+    return;
+  RamCacheCLFUSCompressJob job[COMPRESS_BATCH];
+  int n = 0;
+  bool done = false;
+  while (!done) {
+    int njobs = 0;
+    // collect a batch of candidates under a single lock hold
+    MUTEX_TAKE_LOCK(vol->mutex, thread);
+    if (!compressed) {
+      compressed = lru[0].head;
+      ncompressed = 0;
+    }
+    float target = (cache_config_ram_cache_compress_percent / 100.0) * objects;
+    done = true;
+    while (compressed && target > ncompressed) {
+      RamCacheCLFUSEntry *e = compressed;
+      if (!e->flag_bits.incompressible && !e->flag_bits.compressed) {
+        n++;
+        if (do_at_most < n)
+          break;
+        RamCacheCLFUSCompressJob &j = job[njobs++];
+        e->compressed_len = e->size;
+        j.e = e;
+        j.key = e->key;
+        j.data = e->data;
+        j.len = e->len;
+        j.size = e->size;
+        j.ctype = ram_cache_compression_type(e);
       }
-      MUTEX_TAKE_LOCK(vol->mutex, thread);
-      // see if the entry is till around
-      {
-        uint32_t i = key.word(3) % nbuckets;
-        RamCacheCLFUSEntry *ee = bucket[i].head;
-        while (ee) {
-          if (ee->key == key && ee->data == edata) break;
-          ee = ee->hash_link.next;
-        }
-        if (!ee || ee != e) {
-          e = compressed;
-          goto Lcontinue;
-        }
-        if (failed)
-          goto Lfailed;
+      if (!e->lru_link.next)
+        break;
+      compressed = e->lru_link.next;
+      ncompressed++;
+      if (njobs == COMPRESS_BATCH) {
+        done = false;
+        break;
       }
-      if (l > REQUIRED_COMPRESSION * e->len)
-        e->flag_bits.incompressible = true;
-      if (l > REQUIRED_SHRINK * e->size)
-        goto Lfailed;
-      if (l < e->len) {
-        e->flag_bits.compressed = cache_config_ram_cache_compress;
-        bb = (char*)ats_malloc(l);
-        memcpy(bb, b, l);
-        ats_free(b);
-        e->compressed_len = l;
-        int64_t delta = ((int64_t)l) - (int64_t)e->size;
-        bytes += delta;
-        CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, delta);
-        e->size = l;
-      } else {
-        ats_free(b);
-        e->flag_bits.compressed = 0;
-        bb = (char*)ats_malloc(e->len);
-        memcpy(bb, e->data->data(), e->len);
-        int64_t delta = ((int64_t)e->len) - (int64_t)e->size;
+    }
+    MUTEX_UNTAKE_LOCK(vol->mutex, thread);
+    if (!njobs)
+      break;
+    for (int i = 0; i < njobs; i++)
+      ram_cache_compress_job(vol, job[i]);
+    // install the results under a second lock hold
+    MUTEX_TAKE_LOCK(vol->mutex, thread);
+    for (int i = 0; i < njobs; i++) {
+      RamCacheCLFUSCompressJob &j = job[i];
+      RamCacheCLFUSEntry *e = j.e;
+      // see if the entry is still around
+      uint32_t b = j.key.word(3) % nbuckets;
+      RamCacheCLFUSEntry *ee = bucket[b].head;
+      while (ee) {
+        if (ee->key == j.key && ee->data == j.data) break;
+        ee = ee->hash_link.next;
+      }
+      if (!ee || ee != e) {
+        ats_free(j.b);
+        j.data = NULL;
+        continue;
+      }
+      if (!j.b)
+        e->flag_bits.incompressible = 1;
+      else {
+        if (j.incompressible)
+          e->flag_bits.incompressible = 1;
+        e->flag_bits.compressed = j.compressed ? j.ctype : 0;
+        if (j.compressed)
+          e->compressed_len = j.l;
+        int64_t delta = ((int64_t)j.l) - (int64_t)e->size;
         bytes += delta;
         CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, delta);
-        e->size = e->len;
-        l = e->len;
+        e->size = j.l;
+        e->data = new_xmalloc_IOBufferData(j.b, j.l);
+        e->data->_mem_type = DEFAULT_ALLOC;
+        check_accounting(this);
       }
-      e->data = new_xmalloc_IOBufferData(bb, l);
-      e->data->_mem_type = DEFAULT_ALLOC;
-      check_accounting(this);
+      DDebug("ram_cache", "compress %X %d %d %d %d %d %d %d",
+             e->key.word(3), e->auxkey1, e->auxkey2,
+             e->flag_bits.incompressible, e->flag_bits.compressed,
+             e->len, e->compressed_len, ncompressed);
+      j.data = NULL;
     }
-    goto Lcontinue;
-  Lfailed:
-    ats_free(b);
-    e->flag_bits.incompressible = 1;
-  Lcontinue:;
-    DDebug("ram_cache", "compress %X %d %d %d %d %d %d %d",
-           e->key.word(3), e->auxkey1, e->auxkey2,
-           e->flag_bits.incompressible, e->flag_bits.compressed,
-           e->len, e->compressed_len, ncompressed);
-    if (!e->lru_link.next)
-      break;
-    compressed = e->lru_link.next;
-    ncompressed++;
+    MUTEX_UNTAKE_LOCK(vol->mutex, thread);
   }
-  MUTEX_UNTAKE_LOCK(vol->mutex, thread);
   return;
 }
 
@@ -635,6 +750,21 @@ int RamCacheCLFUSCompressor::mainEvent(int event, Event *e) {
     case CACHE_COMPRESSION_LIBLZMA:
 #if ! TS_HAS_LZMA
       Warning("lzma not available for RAM cache compression");
+#endif
+      break;
+    case CACHE_COMPRESSION_LZ4:
+#if ! TS_HAS_LZ4
+      Warning("lz4 not available for RAM cache compression");
+#endif
+      break;
+    case CACHE_COMPRESSION_ZSTD:
+#if ! TS_HAS_ZSTD
+      Warning("zstd not available for RAM cache compression");
+#endif
+      break;
+    case CACHE_COMPRESSION_TIERED:
+#if ! TS_HAS_LZ4 || ! TS_HAS_ZSTD
+      Warning("lz4 and zstd are both required for tiered RAM cache compression");
 #endif
       break;
   }
@@ -0,0 +1,372 @@
+/** @file
+
+  A brief file description
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+// Window TinyLFU replacement policy, sharded by key.
+//
+// New entries go into a small LRU window.  Entries falling out of the
+// window compete for the main area (a segmented LRU of probation and
+// protected entries) against its next victim, and the one the frequency
+// sketch has seen more often stays.  The sketch is a count-min sketch
+// which is halved periodically so that old popularity fades.
+//
+// Each shard has its own lock, so unlike the other RAM caches this one
+// does not rely on the Vol mutex and can be read without it.
+
+#include "P_Cache.h"
+
+#define TLFU_SHARDS 16                          // at most, power of 2
+#define TLFU_MIN_SHARD_BYTES (16 * 1024 * 1024)
+#define TLFU_WINDOW_PERCENT 1
+#define TLFU_PROTECTED_PERCENT 80               // of the main area
+#define TLFU_SKETCH_DEPTH 4
+#define TLFU_SKETCH_MAX 15
+#define TLFU_SKETCH_OBJECT_SIZE 8192            // average object size assumed when sizing the sketch
+#define TLFU_SKETCH_MIN_WIDTH 1024
+#define TLFU_SAMPLE_FACTOR 10                   // halve the sketch after this many accesses per counter
+
+enum { TLFU_WINDOW, TLFU_PROBATION, TLFU_PROTECTED, TLFU_QUEUES };
+
+struct RamCacheTLFUEntry {
+  INK_MD5 key;
+  uint32_t auxkey1;
+  uint32_t auxkey2;
+  uint32_t size;
+  uint32_t queue;
+  LINK(RamCacheTLFUEntry, lru_link);
+  LINK(RamCacheTLFUEntry, hash_link);
+  Ptr<IOBufferData> data;
+};
+
+struct RamCacheTLFUShard {
+  ink_mutex lock;
+  int64_t max_bytes;
+  int64_t queue_max[TLFU_QUEUES];
+  int64_t queue_bytes[TLFU_QUEUES];
+  int64_t objects;
+  int ibuckets;
+  int nbuckets;
+  DList(RamCacheTLFUEntry, hash_link) *bucket;
+  Que(RamCacheTLFUEntry, lru_link) lru[TLFU_QUEUES];
+  uint8_t *sketch;
+  int sketch_shift;
+  uint32_t sketch_mask;
+  uint32_t accesses;
+  uint32_t sample_size;
+};
+
+struct RamCacheTLFU : public RamCache {
+  int64_t max_bytes;
+
+  // returns 1 on found/stored, 0 on not found/stored, if provided auxkey1 and auxkey2 must match
+  int get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0);
+  int put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0);
+  int fixup(INK_MD5 *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2);
+  int get_unlocked(INK_MD5 *key, Ptr<IOBufferData> *ret_data);
+
+  void init(int64_t max_bytes, Vol *vol);
+
+  // private
+  Vol *vol; // for stats
+  int nshards;
+  RamCacheTLFUShard *shards;
+
+  RamCacheTLFUShard *shard_for(INK_MD5 *key) { return &shards[key->word(2) & (nshards - 1)]; }
+  RamCacheTLFUEntry *find(RamCacheTLFUShard *s, INK_MD5 *key);
+  void resize_hashtable(RamCacheTLFUShard *s);
+  uint32_t frequency(RamCacheTLFUShard *s, INK_MD5 *key);
+  void record(RamCacheTLFUShard *s, INK_MD5 *key);
+  void enqueue(RamCacheTLFUShard *s, RamCacheTLFUEntry *e, uint32_t queue);
+  void dequeue(RamCacheTLFUShard *s, RamCacheTLFUEntry *e);
+  void touch(RamCacheTLFUShard *s, RamCacheTLFUEntry *e);
+  void evict(RamCacheTLFUShard *s);
+  RamCacheTLFUEntry *victim(RamCacheTLFUShard *s);
+  RamCacheTLFUEntry *destroy(RamCacheTLFUShard *s, RamCacheTLFUEntry *e);
+
+  RamCacheTLFU(): max_bytes(0), vol(0), nshards(0), shards(0) { }
+};
+
+ClassAllocator<RamCacheTLFUEntry> ramCacheTLFUEntryAllocator("RamCacheTLFUEntry");
+
+static const int bucket_sizes[] = {
+  127, 251, 509, 1021, 2039, 4093, 8191, 16381, 32749, 65521, 131071, 262139,
+  524287, 1048573, 2097143, 4194301, 8388593, 16777213, 33554393, 67108859,
+  134217689, 268435399, 536870909
+};
+
+void RamCacheTLFU::resize_hashtable(RamCacheTLFUShard *s) {
+  int anbuckets = bucket_sizes[s->ibuckets];
+  DDebug("ram_cache", "resize hashtable %d", anbuckets);
+  int64_t size = anbuckets * sizeof(DList(RamCacheTLFUEntry, hash_link));
+  DList(RamCacheTLFUEntry, hash_link) *new_bucket = (DList(RamCacheTLFUEntry, hash_link) *)ats_malloc(size);
+  memset(new_bucket, 0, size);
+  if (s->bucket) {
+    for (int64_t i = 0; i < s->nbuckets; i++) {
+      RamCacheTLFUEntry *e = 0;
+      while ((e = s->bucket[i].pop()))
+        new_bucket[e->key.word(3) % anbuckets].push(e);
+    }
+    ats_free(s->bucket);
+  }
+  s->bucket = new_bucket;
+  s->nbuckets = anbuckets;
+}
+
+void
+RamCacheTLFU::init(int64_t abytes, Vol *avol) {
+  vol = avol;
+  max_bytes = abytes;
+  DDebug("ram_cache", "initializing ram_cache %" PRId64 " bytes", abytes);
+  if (!max_bytes)
+    return;
+  nshards = TLFU_SHARDS;
+  while (nshards > 1 && max_bytes / nshards < TLFU_MIN_SHARD_BYTES)
+    nshards >>= 1;
+  shards = (RamCacheTLFUShard *)ats_malloc(nshards * sizeof(RamCacheTLFUShard));
+  memset(shards, 0, nshards * sizeof(RamCacheTLFUShard));
+  for (int i = 0; i < nshards; i++) {
+    RamCacheTLFUShard *s = &shards[i];
+    ink_mutex_init(&s->lock, "RamCacheTLFU");
+    s->max_bytes = max_bytes / nshards;
+    s->queue_max[TLFU_WINDOW] = s->max_bytes * TLFU_WINDOW_PERCENT / 100;
+    s->queue_max[TLFU_PROTECTED] = (s->max_bytes - s->queue_max[TLFU_WINDOW]) * TLFU_PROTECTED_PERCENT / 100;
+    s->queue_max[TLFU_PROBATION] = s->max_bytes - s->queue_max[TLFU_WINDOW] - s->queue_max[TLFU_PROTECTED];
+    int64_t width = TLFU_SKETCH_MIN_WIDTH;
+    s->sketch_shift = 32 - 10;
+    while (width < s->max_bytes / TLFU_SKETCH_OBJECT_SIZE && s->sketch_shift > 8) {
+      width <<= 1;
+      s->sketch_shift--;
+    }
+    s->sketch_mask = (uint32_t)width - 1;
+    s->sketch = (uint8_t *)ats_malloc(TLFU_SKETCH_DEPTH * width);
+    memset(s->sketch, 0, TLFU_SKETCH_DEPTH * width);
+    s->sample_size = (uint32_t)(TLFU_SAMPLE_FACTOR * width);
+    resize_hashtable(s);
+  }
+}
+
+// each row of the sketch is indexed by the top bits of a different word of the key
+#define SKETCH_COUNTER(_s, _key, _row) \
+  (_s)->sketch[((_row) << (32 - (_s)->sketch_shift)) + (((_key)->word(_row) * 0x9E3779B1U) >> (_s)->sketch_shift)]
+
+uint32_t RamCacheTLFU::frequency(RamCacheTLFUShard *s, INK_MD5 *key) {
+  uint32_t f = TLFU_SKETCH_MAX;
+  for (int r = 0; r < TLFU_SKETCH_DEPTH; r++) {
+    uint32_t c = SKETCH_COUNTER(s, key, r);
+    if (c < f)
+      f = c;
+  }
+  return f;
+}
+
+void RamCacheTLFU::record(RamCacheTLFUShard *s, INK_MD5 *key) {
+  // conservative update: only the smallest counters move
+  uint32_t f = frequency(s, key);
+  if (f < TLFU_SKETCH_MAX)
+    for (int r = 0; r < TLFU_SKETCH_DEPTH; r++)
+      if (SKETCH_COUNTER(s, key, r) == f)
+        SKETCH_COUNTER(s, key, r) = f + 1;
+  if (++s->accesses >= s->sample_size) {
+    // age: halve every counter
+    uint32_t n = TLFU_SKETCH_DEPTH * (s->sketch_mask + 1);
+    for (uint32_t i = 0; i < n; i++)
+      s->sketch[i] >>= 1;
+    s->accesses >>= 1;
+  }
+}
+
+RamCacheTLFUEntry *RamCacheTLFU::find(RamCacheTLFUShard *s, INK_MD5 *key) {
+  RamCacheTLFUEntry *e = s->bucket[key->word(3) % s->nbuckets].head;
+  while (e && !(e->key == *key))
+    e = e->hash_link.next;
+  return e;
+}
+
+void RamCacheTLFU::enqueue(RamCacheTLFUShard *s, RamCacheTLFUEntry *e, uint32_t queue) {
+  e->queue = queue;
+  s->lru[queue].enqueue(e);
+  s->queue_bytes[queue] += e->size;
+}
+
+void RamCacheTLFU::dequeue(RamCacheTLFUShard *s, RamCacheTLFUEntry *e) {
+  s->lru[e->queue].remove(e);
+  s->queue_bytes[e->queue] -= e->size;
+}
+
+void RamCacheTLFU::touch(RamCacheTLFUShard *s, RamCacheTLFUEntry *e) {
+  uint32_t queue = e->queue;
+  dequeue(s, e);
+  if (queue == TLFU_PROBATION) {
+    queue = TLFU_PROTECTED;
+    // make room by demoting the least recently used protected entries
+    while (s->queue_bytes[TLFU_PROTECTED] + e->size > s->queue_max[TLFU_PROTECTED] && s->lru[TLFU_PROTECTED].head) {
+      RamCacheTLFUEntry *d = s->lru[TLFU_PROTECTED].head;
+      dequeue(s, d);
+      enqueue(s, d, TLFU_PROBATION);
+    }
+  }
+  enqueue(s, e, queue);
+}
+
+RamCacheTLFUEntry *RamCacheTLFU::destroy(RamCacheTLFUShard *s, RamCacheTLFUEntry *e) {
+  RamCacheTLFUEntry *ret = e->hash_link.next;
+  dequeue(s, e);
+  s->bucket[e->key.word(3) % s->nbuckets].remove(e);
+  s->objects--;
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, -(int64_t)e->size);
+  DDebug("ram_cache", "put %X %d %d size %d FREED", e->key.word(3), e->auxkey1, e->auxkey2, e->size);
+  e->data = NULL;
+  THREAD_FREE(e, ramCacheTLFUEntryAllocator, this_ethread());
+  return ret;
+}
+
+// the main area's next victim: least recently used on probation, then protected
+RamCacheTLFUEntry *RamCacheTLFU::victim(RamCacheTLFUShard *s) {
+  if (s->lru[TLFU_PROBATION].head)
+    return s->lru[TLFU_PROBATION].head;
+  return s->lru[TLFU_PROTECTED].head;
+}
+
+// move entries out of the window, admitting each into the main area only
+// if the sketch has seen it more often than the entry it would displace
+void RamCacheTLFU::evict(RamCacheTLFUShard *s) {
+  int64_t main_max = s->max_bytes - s->queue_max[TLFU_WINDOW];
+  while (s->queue_bytes[TLFU_WINDOW] > s->queue_max[TLFU_WINDOW]) {
+    RamCacheTLFUEntry *c = s->lru[TLFU_WINDOW].head;
+    int64_t main_bytes = s->queue_bytes[TLFU_PROBATION] + s->queue_bytes[TLFU_PROTECTED];
+    if (main_bytes + c->size > main_max) {
+      RamCacheTLFUEntry *v = victim(s);
+      if (!v || c->size > main_max || frequency(s, &c->key) <= frequency(s, &v->key)) {
+        DDebug("ram_cache", "put %X %d %d size %d REJECTED", c->key.word(3), c->auxkey1, c->auxkey2, c->size);
+        destroy(s, c);
+        continue;
+      }
+      while (main_bytes + c->size > main_max && (v = victim(s))) {
+        main_bytes -= v->size;
+        destroy(s, v);
+      }
+    }
+    dequeue(s, c);
+    enqueue(s, c, TLFU_PROBATION);
+  }
+}
+
+int RamCacheTLFU::get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1, uint32_t auxkey2) {
+  if (!max_bytes)
+    return 0;
+  RamCacheTLFUShard *s = shard_for(key);
+  ink_mutex_acquire(&s->lock);
+  record(s, key);
+  RamCacheTLFUEntry *e = find(s, key);
+  if (e && e->auxkey1 == auxkey1 && e->auxkey2 == auxkey2) {
+    touch(s, e);
+    (*ret_data) = e->data;
+    ink_mutex_release(&s->lock);
+    DDebug("ram_cache", "get %X %d %d HIT", key->word(3), auxkey1, auxkey2);
+    CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_hits_stat, 1);
+    return 1;
+  }
+  ink_mutex_release(&s->lock);
+  DDebug("ram_cache", "get %X %d %d MISS", key->word(3), auxkey1, auxkey2);
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_misses_stat, 1);
+  return 0;
+}
+
+// keys of fragments after the first are unique to a write, so they can be
+// looked up without the directory entry (and the Vol mutex) to check against
+int RamCacheTLFU::get_unlocked(INK_MD5 *key, Ptr<IOBufferData> *ret_data) {
+  if (!max_bytes)
+    return 0;
+  RamCacheTLFUShard *s = shard_for(key);
+  ink_mutex_acquire(&s->lock);
+  RamCacheTLFUEntry *e = find(s, key);
+  if (e) {
+    record(s, key);
+    touch(s, e);
+    (*ret_data) = e->data;
+  }
+  ink_mutex_release(&s->lock);
+  if (e) {
+    DDebug("ram_cache", "get %X UNLOCKED HIT", key->word(3));
+    CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_hits_stat, 1);
+  }
+  return e ? 1 : 0;
+}
+
+// ignore 'copy' since we don't touch the data
+int RamCacheTLFU::put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool, uint32_t auxkey1, uint32_t auxkey2) {
+  NOWARN_UNUSED(len);
+  if (!max_bytes)
+    return 0;
+  RamCacheTLFUShard *s = shard_for(key);
+  uint32_t size = data->block_size();
+  if (size > s->max_bytes - s->queue_max[TLFU_WINDOW])
+    return 0;
+  ink_mutex_acquire(&s->lock);
+  RamCacheTLFUEntry *e = find(s, key);
+  if (e) {
+    if (e->auxkey1 == auxkey1 && e->auxkey2 == auxkey2) {
+      touch(s, e);
+      ink_mutex_release(&s->lock);
+      return 1;
+    }
+    destroy(s, e); // discard when aux keys conflict
+  }
+  e = THREAD_ALLOC(ramCacheTLFUEntryAllocator, this_ethread());
+  e->key = *key;
+  e->auxkey1 = auxkey1;
+  e->auxkey2 = auxkey2;
+  e->size = size;
+  e->data = data;
+  s->bucket[key->word(3) % s->nbuckets].push(e);
+  enqueue(s, e, TLFU_WINDOW);
+  s->objects++;
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, size);
+  evict(s);
+  if (s->objects > s->nbuckets) {
+    ++s->ibuckets;
+    resize_hashtable(s);
+  }
+  ink_mutex_release(&s->lock);
+  DDebug("ram_cache", "put %X %d %d INSERTED", key->word(3), auxkey1, auxkey2);
+  return 1;
+}
+
+int RamCacheTLFU::fixup(INK_MD5 * key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2) {
+  if (!max_bytes)
+    return 0;
+  RamCacheTLFUShard *s = shard_for(key);
+  ink_mutex_acquire(&s->lock);
+  RamCacheTLFUEntry *e = find(s, key);
+  if (e && e->auxkey1 == old_auxkey1 && e->auxkey2 == old_auxkey2) {
+    e->auxkey1 = new_auxkey1;
+    e->auxkey2 = new_auxkey2;
+    ink_mutex_release(&s->lock);
+    return 1;
+  }
+  ink_mutex_release(&s->lock);
+  return 0;
+}
+
+RamCache *new_RamCacheTLFU() {
+  return new RamCacheTLFU;
+}
@@ -46,6 +46,7 @@ int dns_failover_number = DEFAULT_FAILOVER_NUMBER;
 int dns_failover_period = DEFAULT_FAILOVER_PERIOD;
 int dns_failover_try_period = DEFAULT_FAILOVER_TRY_PERIOD;
 int dns_max_dns_in_flight = MAX_DNS_IN_FLIGHT;
+int dns_per_thread_handlers = 0;
 int dns_validate_qname = 0;
 unsigned int dns_handler_initialized = 0;
 int dns_ns_rr = 0;
@@ -194,6 +195,7 @@ DNSProcessor::start(int) {
   IOCORE_ReadConfigStringAlloc(dns_resolv_conf, "proxy.config.dns.resolv_conf");
   IOCORE_EstablishStaticConfigInt32(dns_thread, "proxy.config.dns.dedicated_thread");
   IOCORE_EstablishStaticConfigInt32(dns_prefer_ipv6, "proxy.config.dns.prefer_ipv6");
+  IOCORE_EstablishStaticConfigInt32(dns_per_thread_handlers, "proxy.config.dns.per_thread_handlers");
 
   if (dns_thread > 0) {
     ET_DNS = eventProcessor.spawn_event_threads(1, "ET_DNS"); // TODO: Hmmm, should we just get a single thread some other way?
@@ -214,6 +216,8 @@ DNSProcessor::start(int) {
   // Setup the default DNSHandler, it's used both by normal DNS, and SplitDNS (for PTR lookups etc.)
   dns_init();
   open();
+  if (dns_per_thread_handlers)
+    open_thread_handlers();
 
   return 0;
 }
@@ -241,6 +245,65 @@ DNSProcessor::open(sockaddr const* target, int aoptions)
   thread->schedule_imm(h);
 }
 
+/**
+  Give each network thread a DNSHandler of its own, with its own
+  connections and query ids.  The thread already running the default
+  handler keeps using it.
+
+*/
+void
+DNSProcessor::open_thread_handlers()
+{
+  thread_handler_offset = eventProcessor.allocate(sizeof(DNSHandler *));
+  if (thread_handler_offset < 0) {
+    Warning("no thread private space left for per thread DNS handlers, using the DNS thread");
+    return;
+  }
+
+  for (int i = 0; i < eventProcessor.n_threads_for_type[ET_NET]; i++) {
+    EThread *t = eventProcessor.eventthread[ET_NET][i];
+    DNSHandler *h = handler;
+
+    if (t != thread) {
+      h = NEW(new DNSHandler);
+      h->thread = t;
+      h->options = handler->options;
+      h->mutex = t->mutex;
+      // a private copy, as ink_res_mkquery() updates the id in it
+      h->m_res = NEW(new ts_imp_res_state);
+      *h->m_res = l_res;
+      ats_ip_copy(&h->local_ipv4.sa, &local_ipv4.sa);
+      ats_ip_copy(&h->local_ipv6.sa, &local_ipv6.sa);
+      ats_ip_invalidate(&h->ip);
+
+      SET_CONTINUATION_HANDLER(h, &DNSHandler::startEvent);
+      t->schedule_imm(h);
+    }
+    *(DNSHandler **)ETHREAD_GET_PTR(t, thread_handler_offset) = h;
+  }
+  Debug("dns", "opened per thread DNS handlers for %d threads", eventProcessor.n_threads_for_type[ET_NET]);
+}
+
+/** The DNSHandler lookups submitted from @a t are sent with. */
+DNSHandler *
+DNSProcessor::thread_handler(EThread *t)
+{
+  if (thread_handler_offset >= 0 && t) {
+    DNSHandler *h = *(DNSHandler **)ETHREAD_GET_PTR(t, thread_handler_offset);
+    if (h)
+      return h;
+  }
+  return handler;
+}
+
+/** The thread a lookup started from @a t should be run on. */
+EThread *
+DNSProcessor::lookup_thread(EThread *t)
+{
+  DNSHandler *h = thread_handler(t);
+  return (h && h->thread) ? h->thread : thread;
+}
+
 //
 // Initialization
 //
@@ -351,7 +414,7 @@ ink_dn_expand(const u_char *msg, const u_char *eom, const u_char *comp_dn, u_cha
 }
 
 DNSProcessor::DNSProcessor()
-  : thread(NULL), handler(NULL)
+  : thread(NULL), handler(NULL), thread_handler_offset(-1)
 {
   memset(&l_res, 0, sizeof(l_res));
   memset(&local_ipv6, 0, sizeof local_ipv6);
@@ -369,13 +432,13 @@ DNSEntry::init(const char *x, int len, int qtype_arg,
 
 #ifdef SPLIT_DNS
   if (SplitDNSConfig::gsplit_dns_enabled) {
-    dnsH = adnsH ? adnsH : dnsProcessor.handler;
+    dnsH = adnsH ? adnsH : dnsProcessor.thread_handler(submit_thread);
   } else {
-    dnsH = dnsProcessor.handler;
+    dnsH = dnsProcessor.thread_handler(submit_thread);
   }
 #else
   INK_NOWARN(adnsH);
-  dnsH = dnsProcessor.handler;
+  dnsH = dnsProcessor.thread_handler(submit_thread);
 #endif // SPLIT_DNS
 
   dnsH->txn_lookup_timeout = dns_lookup_timeout;
@@ -414,7 +477,7 @@ void
 DNSHandler::open_con(sockaddr const* target, bool failed, int icon)
 {
   ip_port_text_buffer ip_text;
-  PollDescriptor *pd = get_PollDescriptor(dnsProcessor.thread);
+  PollDescriptor *pd = get_PollDescriptor(thread ? thread : dnsProcessor.thread);
 
   if (!icon && target) {
     ats_ip_copy(&ip, target);
@@ -485,12 +548,13 @@ DNSHandler::startEvent(int event, Event *e)
 
   this->validate_ip();
 
-  if (!dns_handler_initialized) {
+  if (!dns_handler_initialized || thread) {
     //
-    // If we are THE handler, open connection and configure for
-    // periodic execution.
+    // If we are THE handler, or a per thread one, open connection and
+    // configure for periodic execution.
     //
-    dns_handler_initialized = 1;
+    if (!thread)
+      dns_handler_initialized = 1;
     SET_HANDLER(&DNSHandler::mainEvent);
     if (dns_ns_rr) {
       int max_nscount = m_res->nscount;
@@ -855,33 +919,73 @@ DNSHandler::mainEvent(int event, Event *e)
 inline static DNSEntry *
 get_dns(DNSHandler *h, uint16_t id)
 {
-  for (DNSEntry *e = h->entries.head; e; e = (DNSEntry *) e->link.next) {
-    if (e->once_written_flag) {
-      for (int j = 0; j < MAX_DNS_RETRIES; j++) {
-        if (e->id[j] == id) {
-          return e;
-        } else if (e->id[j] < 0) {
-          goto Lnext;
-        }
-      }
+  DNSEntry *e = h->query_id_entry(id);
+
+  return (e && e->once_written_flag) ? e : NULL;
+}
+
+static inline int
+name_hash_bucket(const char *qname, int qtype)
+{
+  uint32_t hash = 2166136261U ^ (uint32_t)qtype;   // FNV-1a
+
+  while (*qname)
+    hash = (hash ^ (uint8_t)*qname++) * 16777619U;
+  return hash % DNS_NAME_HASH_BUCKETS;
+}
+
+static inline void
+name_hash_unlink(DNSHandler *h, DNSEntry *e)
+{
+  if (e->name_bucket < 0)
+    return;
+  for (DNSEntry **p = &h->name_hash[e->name_bucket]; *p; p = &(*p)->name_next) {
+    if (*p == e) {
+      *p = e->name_next;
+      break;
     }
-  Lnext:;
   }
-  return NULL;
+  e->name_next = NULL;
+  e->name_bucket = -1;
+}
+
+static inline void
+name_hash_link(DNSHandler *h, DNSEntry *e)
+{
+  e->name_bucket = name_hash_bucket(e->qname, e->qtype);
+  e->name_next = h->name_hash[e->name_bucket];
+  h->name_hash[e->name_bucket] = e;
+}
+
+void
+DNSHandler::enqueue_entry(DNSEntry *e)
+{
+  entries.enqueue(e);
+  name_hash_link(this, e);
+}
+
+void
+DNSHandler::remove_entry(DNSEntry *e)
+{
+  entries.remove(e);
+  name_hash_unlink(this, e);
+}
+
+/** Refile an entry whose query name or type was changed. */
+void
+DNSHandler::rehash_entry(DNSEntry *e)
+{
+  name_hash_unlink(this, e);
+  name_hash_link(this, e);
 }
 
 /** Find a DNSEntry by query name and type. */
-inline static DNSEntry *
-get_entry(DNSHandler *h, char *qname, int qtype)
+DNSEntry *
+DNSHandler::find_entry(const char *qname, int qtype)
 {
-  for (DNSEntry *e = h->entries.head; e; e = (DNSEntry *) e->link.next) {
-    if (e->qtype == qtype) {
-      if (is_addr_type_reply(qtype)) {
-        if (!strcmp(qname, e->qname))
-          return e;
-      } else if (0 == memcmp(qname, e->qname, e->qname_len))
-        return e;
-    }
+  for (DNSEntry *e = name_hash[name_hash_bucket(qname, qtype)]; e; e = e->name_next) {
+    if (e->qtype == qtype && !strcmp(qname, e->qname))
+      return e;
   }
   return NULL;
 }
@@ -984,6 +1088,7 @@ write_dns_event(DNSHandler *h, DNSEntry *e)
     h->release_query_id(e->id[dns_retries - e->retries]);
   }
   e->id[dns_retries - e->retries] = i;
+  h->bind_query_id(i, e);
   Debug("dns", "send query (qtype=%d) for %s to fd %d", e->qtype, e->qname, h->con[h->name_server].fd);
 
   int s = socketManager.send(h->con[h->name_server].fd, blob._b, r, 0);
@@ -1060,13 +1165,13 @@ DNSEntry::mainEvent(int event, Event *e)
         ++domains;
       }
       Debug("dns", "enqueing query %s", qname);
-      DNSEntry *dup = get_entry(dnsH, qname, qtype);
+      DNSEntry *dup = dnsH->find_entry(qname, qtype);
       if (dup) {
         Debug("dns", "collapsing NS request");
         dup->dups.enqueue(this);
       } else {
         Debug("dns", "adding first to collapsing queue");
-        dnsH->entries.enqueue(this);
+        dnsH->enqueue_entry(this);
         write_dns(dnsH);
       }
       return EVENT_DONE;
@@ -1101,7 +1206,7 @@ DNSProcessor::getby(const char *x, int len, int type, Continuation *cont, DNSHan
   e->init(x, len, type, cont, adnsH, timeout);
   MUTEX_TRY_LOCK(lock, e->mutex, this_ethread());
   if (!lock)
-    thread->schedule_imm(e);
+    (e->dnsH->thread ? e->dnsH->thread : thread)->schedule_imm(e);
   else
     e->handleEvent(EVENT_IMMEDIATE, 0);
   return &e->action;
@@ -1130,12 +1235,14 @@ dns_result(DNSHandler *h, DNSEntry *e, HostEnt *ent, bool retry) {
       Debug("dns", "Trying A after AAAA failure for %s", e->qname);
       e->retries = dns_retries;
       e->qtype = T_A;
+      h->rehash_entry(e);
       write_dns(h);
       return;
     } else if (!prefer_ipv6_p() && e->qtype == T_A) {
       Debug("dns", "Trying AAAA after A failure for %s", e->qname);
       e->retries = dns_retries;
       e->qtype = T_AAAA;
+      h->rehash_entry(e);
       write_dns(h);
       return;
     } else if (e->domains && *e->domains) {
@@ -1168,6 +1275,7 @@ dns_result(DNSHandler *h, DNSEntry *e, HostEnt *ent, bool retry) {
         ++(e->domains);
         e->retries = dns_retries;
         Debug("dns", "new name = %s retries = %d", e->qname, e->retries);
+        h->rehash_entry(e);
         write_dns(h);
         return;
       LnextDomain:
@@ -1177,6 +1285,7 @@ dns_result(DNSHandler *h, DNSEntry *e, HostEnt *ent, bool retry) {
       e->qname[e->qname_len] = 0;
       if (!strchr(e->qname, '.') && !e->last) {
         e->last = true;
+        h->rehash_entry(e);
         write_dns(h);
         return;
       }
@@ -1194,7 +1303,7 @@ dns_result(DNSHandler *h, DNSEntry *e, HostEnt *ent, bool retry) {
       DNS_SUM_DYN_STAT(dns_success_time_stat, ink_get_hrtime() - e->submit_time);
     }
   }
-  h->entries.remove(e);
+  h->remove_entry(e);
 
   if (is_addr_type_reply(e->qtype)) {
     ip_text_buffer buff;
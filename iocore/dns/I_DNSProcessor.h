@@ -102,6 +102,13 @@ struct DNSProcessor: public Processor
   IpEndpoint local_ipv4;
   Action *getby(const char *x, int len, int type, Continuation *cont, DNSHandler *adnsH = NULL, int timeout = 0);
   void dns_init();
+
+  // Per thread handlers (proxy.config.dns.per_thread_handlers)
+  //
+  off_t thread_handler_offset;
+  void open_thread_handlers();
+  DNSHandler *thread_handler(EThread *t);
+  EThread *lookup_thread(EThread *t);
 };
 
 
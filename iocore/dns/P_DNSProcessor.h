@@ -57,6 +57,7 @@ extern int dns_failover_number;
 extern int dns_failover_period;
 extern int dns_failover_try_period;
 extern int dns_max_dns_in_flight;
+extern int dns_per_thread_handlers;
 extern unsigned int dns_sequence_number;
 
 //
@@ -70,6 +71,7 @@ extern unsigned int dns_sequence_number;
 #define DNS_PRIMARY_REOPEN_PERIOD           HRTIME_SECONDS(60)
 #define BAD_DNS_RESULT                      ((HostEnt*)(uintptr_t)-1)
 #define DEFAULT_NUM_TRY_SERVER              8
+#define DNS_NAME_HASH_BUCKETS               1024
 
 // these are from nameser.h
 #ifndef HFIXEDSZ
@@ -164,6 +166,8 @@ struct DNSEntry: public Continuation
   bool written_flag;
   bool once_written_flag;
   bool last;
+  DNSEntry *name_next;          // chain in DNSHandler::name_hash
+  int name_bucket;
   LINK(DNSEntry, dup_link);
   Que(DNSEntry, dup_link) dups;
 
@@ -178,7 +182,8 @@ struct DNSEntry: public Continuation
        qtype(0),
        retries(DEFAULT_DNS_RETRIES),
        which_ns(NO_NAMESERVER_SELECTED), submit_time(0), send_time(0), qname_len(0), domains(0),
-       timeout(0), result_ent(0), dnsH(0), written_flag(false), once_written_flag(false), last(false)
+       timeout(0), result_ent(0), dnsH(0), written_flag(false), once_written_flag(false), last(false),
+       name_next(0), name_bucket(-1)
   {
     for (int i = 0; i < MAX_DNS_RETRIES; i++)
       id[i] = -1;
@@ -193,7 +198,8 @@ struct DNSEntry;
 
 /**
   One DNSHandler is allocated to handle all DNS traffic by polling a
-  UDP port.
+  UDP port.  With proxy.config.dns.per_thread_handlers, each network
+  thread gets its own, which is then only ever run on that thread.
 
 */
 struct DNSHandler: public Continuation
@@ -202,6 +208,7 @@ struct DNSHandler: public Continuation
   IpEndpoint ip;
   IpEndpoint local_ipv6; ///< Local V6 address if set.
   IpEndpoint local_ipv4; ///< Local V4 address if set.
+  EThread *thread;              ///< Thread polling the connections, NULL for the DNS thread.
   int ifd[MAX_NAMED];
   int n_con;
   DNSConnection con[MAX_NAMED];
@@ -226,6 +233,11 @@ struct DNSHandler: public Continuation
   InkRand generator;
   // bitmap of query ids in use
   uint64_t qid_in_flight[(USHRT_MAX+1)/64];
+  // entry owning each query id in use, in pages of 64 ids matching
+  // qid_in_flight; pages are allocated as the ids are first used
+  DNSEntry **qid_entry[(USHRT_MAX+1)/64];
+  // entries in the queue, hashed by query name
+  DNSEntry *name_hash[DNS_NAME_HASH_BUCKETS];
 
   void received_one(int i)
   {
@@ -273,8 +285,25 @@ struct DNSHandler: public Continuation
 
   void release_query_id(uint16_t qid) {
     qid_in_flight[qid >> 6] &= (uint64_t)~(0x1ULL << (qid & 0x3F));
+    if (qid_entry[qid >> 6])
+      qid_entry[qid >> 6][qid & 0x3F] = NULL;
   };
 
+  void bind_query_id(uint16_t qid, DNSEntry *e) {
+    if (!qid_entry[qid >> 6])
+      qid_entry[qid >> 6] = (DNSEntry **)ats_calloc(64, sizeof(DNSEntry *));
+    qid_entry[qid >> 6][qid & 0x3F] = e;
+  };
+
+  DNSEntry *query_id_entry(uint16_t qid) {
+    return qid_entry[qid >> 6] ? qid_entry[qid >> 6][qid & 0x3F] : NULL;
+  };
+
+  void enqueue_entry(DNSEntry *e);
+  void remove_entry(DNSEntry *e);
+  void rehash_entry(DNSEntry *e);
+  DNSEntry *find_entry(const char *qname, int qtype);
+
   void set_query_id_in_use(uint16_t qid) {
     qid_in_flight[qid >> 6] |= (uint64_t)(0x1ULL << (qid & 0x3F));
   };
@@ -292,7 +321,7 @@ private:
 
 
 TS_INLINE DNSHandler::DNSHandler()
- : Continuation(NULL), n_con(0), options(0), in_flight(0), name_server(0), in_write_dns(0),
+ : Continuation(NULL), thread(NULL), n_con(0), options(0), in_flight(0), name_server(0), in_write_dns(0),
   hostent_cache(0), last_primary_retry(0), last_primary_reopen(0),
   m_res(0), txn_lookup_timeout(0), generator((uint32_t)((uintptr_t)time(NULL) ^ (uintptr_t)this))
 {
@@ -306,6 +335,8 @@ TS_INLINE DNSHandler::DNSHandler()
     con[i].handler = this;
   }
   memset(&qid_in_flight, 0, sizeof(qid_in_flight));  
+  memset(&qid_entry, 0, sizeof(qid_entry));
+  memset(&name_hash, 0, sizeof(name_hash));
   SET_HANDLER(&DNSHandler::startEvent);
   Debug("net_epoll", "inline DNSHandler::DNSHandler()");
 }
@@ -30,6 +30,69 @@
 
 #include "P_EventSystem.h"
 
+RecRawStatBlock *eventsystem_rsb = NULL;
+
+// Sums (or takes the maximum of) the number of events waiting in the
+// external queue of each event thread.
+static int
+eventsystem_queue_depth_cb(const char *name, RecDataT data_type, RecData *data, RecRawStatBlock *rsb, int id)
+{
+  NOWARN_UNUSED(name);
+  NOWARN_UNUSED(data_type);
+  NOWARN_UNUSED(rsb);
+  int64_t depth = 0;
+
+  for (int i = 0; i < eventProcessor.n_ethreads; i++) {
+    // the counts are read unlocked while other threads update them, so
+    // the sum is only a snapshot and may briefly be off
+    int64_t n = eventProcessor.all_ethreads[i]->EventQueueExternal.n_queued_shared;
+    for (int j = 0; j < eventProcessor.n_ethreads; j++)
+      n += eventProcessor.all_ethreads[j]->queued_events[i];
+    if (n < 0)
+      n = 0;
+    if (id == eventsystem_queue_depth_stat)
+      depth += n;
+    else if (n > depth)
+      depth = n;
+  }
+  data->rec_int = depth;
+  return 0;
+}
+
+// Bytes of buffer memory held in the per-thread caches of all event
+// threads, see thread_iobuffer_free().
+static int
+eventsystem_thread_iobuffer_bytes_cb(const char *name, RecDataT data_type, RecData *data, RecRawStatBlock *rsb, int id)
+{
+  NOWARN_UNUSED(name);
+  NOWARN_UNUSED(data_type);
+  NOWARN_UNUSED(rsb);
+  NOWARN_UNUSED(id);
+  int64_t bytes = 0;
+
+  for (int i = 0; i < eventProcessor.n_ethreads; i++)
+    for (int j = 0; j < DEFAULT_BUFFER_SIZES; j++)
+      bytes += (int64_t) eventProcessor.all_ethreads[i]->ioBufAllocator[j].allocated * BUFFER_SIZE_FOR_INDEX(j);
+  data->rec_int = bytes;
+  return 0;
+}
+
+static void
+register_eventsystem_stats()
+{
+  eventsystem_rsb = RecAllocateRawStatBlock((int) EventSystem_Stat_Count);
+
+  RecRegisterRawStat(eventsystem_rsb, RECT_PROCESS, "proxy.process.eventloop.events_stolen",
+                     RECD_INT, RECP_NULL, (int) eventsystem_events_stolen_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(eventsystem_rsb, RECT_PROCESS, "proxy.process.eventloop.queue_depth",
+                     RECD_INT, RECP_NULL, (int) eventsystem_queue_depth_stat, eventsystem_queue_depth_cb);
+  RecRegisterRawStat(eventsystem_rsb, RECT_PROCESS, "proxy.process.eventloop.queue_depth_max",
+                     RECD_INT, RECP_NULL, (int) eventsystem_queue_depth_max_stat, eventsystem_queue_depth_cb);
+  RecRegisterRawStat(eventsystem_rsb, RECT_PROCESS, "proxy.process.allocator.thread_iobuffer_bytes",
+                     RECD_INT, RECP_NULL, (int) eventsystem_thread_iobuffer_bytes_stat,
+                     eventsystem_thread_iobuffer_bytes_cb);
+}
+
 void
 ink_event_system_init(ModuleVersion v)
 {
@@ -37,6 +100,9 @@ ink_event_system_init(ModuleVersion v)
   int config_max_iobuffer_size = DEFAULT_MAX_BUFFER_SIZE;
 
   IOCORE_ReadConfigInteger(config_max_iobuffer_size, "proxy.config.io.max_buffer_size");
+  IOCORE_ReadConfigInteger(thread_iobuffer_bytes, "proxy.config.io.thread_buffer_bytes");
+  if (thread_iobuffer_bytes < 0)
+    thread_iobuffer_bytes = 0;
 
   max_iobuffer_size = buffer_size_to_index(config_max_iobuffer_size, DEFAULT_BUFFER_SIZES - 1);
   if (default_small_iobuffer_size > max_iobuffer_size)
@@ -44,4 +110,5 @@ ink_event_system_init(ModuleVersion v)
   if (default_large_iobuffer_size > max_iobuffer_size)
     default_large_iobuffer_size = max_iobuffer_size;
   init_buffer_allocators();
+  register_eventsystem_stats();
 }
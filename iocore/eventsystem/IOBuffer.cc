@@ -39,6 +39,39 @@ inkcoreapi ClassAllocator<IOBufferBlock> ioBlockAllocator("ioBlockAllocator", DE
 int64_t default_large_iobuffer_size = DEFAULT_LARGE_BUFFER_SIZE;
 int64_t default_small_iobuffer_size = DEFAULT_SMALL_BUFFER_SIZE;
 int64_t max_iobuffer_size = DEFAULT_BUFFER_SIZES - 1;
+int64_t thread_iobuffer_bytes = DEFAULT_THREAD_IOBUFFER_BYTES;
+
+//
+// Copy of the in use area of a file backed block, see load_file().
+// Returns false if the owner of the file has reused the range or it
+// could not be read: the copy is then zeroed, so that nothing else
+// leaks through it, and the caller marks it lost so it is never sent.
+//
+bool
+IOBufferBlock::read_file(char *b)
+{
+  IOBufferData *d = data;
+  int64_t len = size(), done = 0;
+  off_t offset = d->_fd_offset + (_start - d->data());
+
+  Debug("iobuffer", "copying %" PRId64 " file backed bytes at %" PRId64 " into memory", len, (int64_t) offset);
+  if (!d->_fd_check || d->_fd_check(d) >= 0) {
+    while (done < len) {
+      ssize_t r = ::pread(d->_fd, b + done, len - done, offset + done);
+      if (r < 0 && errno == EINTR)
+        continue;
+      if (r <= 0)
+        break;
+      done += r;
+    }
+  }
+  if (done < len || (d->_fd_check && d->_fd_check(d) < 0)) {
+    Warning("file backed buffer of %" PRId64 " bytes at %" PRId64 " could not be read", len, (int64_t) offset);
+    memset(b, 0, len);
+    return false;
+  }
+  return true;
+}
 
 //
 // Initialization
@@ -227,6 +260,8 @@ IOBufferReader::memchr(char c, int64_t len, int64_t offset)
       bytes = max_bytes;
     else
       bytes = len;
+    if (unlikely(b->data->file_backed()))
+      b->load_file();
     char *s = b->start() + offset;
     char *p = (char *) ::memchr(s, c, bytes);
     if (p)
@@ -260,6 +295,8 @@ IOBufferReader::memcpy(const void *ap, int64_t len, int64_t offset)
       bytes = max_bytes;
     else
       bytes = len;
+    if (unlikely(b->data->file_backed()))
+      b->load_file();
     ::memcpy(p, b->start() + offset, bytes);
     p += bytes;
     len -= bytes;
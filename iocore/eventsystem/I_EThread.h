@@ -45,7 +45,7 @@
 struct DiskHandler;
 struct EventIO;
 
-class SessionBucket;
+class ServerSessionPool;
 class Event;
 class Continuation;
 
@@ -273,6 +273,7 @@ public:
   ProxyAllocator openDirEntryAllocator;
   ProxyAllocator ramCacheCLFUSEntryAllocator;
   ProxyAllocator ramCacheLRUEntryAllocator;
+  ProxyAllocator ramCacheTLFUEntryAllocator;
   ProxyAllocator evacuationBlockAllocator;
   ProxyAllocator ioDataAllocator;
   ProxyAllocator ioBlockAllocator;
@@ -311,6 +312,14 @@ public:
   EThread **ethreads_to_be_signalled;
   int n_ethreads_to_be_signalled;
 
+  /**
+    Indexed by event thread id, the number of events this thread pushed
+    onto the external queue of that thread, less those it took off it.
+    Written only by this thread; see ProtectedQueue::count().
+
+  */
+  int64_t *queued_events;
+
   Event *accept_event[MAX_ACCEPT_EVENTS];
   int main_accept_index;
 
@@ -325,6 +334,7 @@ public:
 
   void execute();
   void process_event(Event *e, int calling_code);
+  int steal_events();
   void free_event(Event *e);
   void (*signal_hook)(EThread *);
 
@@ -339,7 +349,10 @@ public:
   Event *oneevent;              // For dedicated event thread
   ink_sem *eventsem;            // For dedicated event thread
 
-  SessionBucket* l1_hash;
+  ServerSessionPool* server_session_pool;
+
+  /** Thread group this thread steals immediate events from when idle, or -1. */
+  EventType steal_etype;
 };
 
 /**
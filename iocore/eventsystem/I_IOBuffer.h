@@ -53,6 +53,7 @@ class VIO;
 inkcoreapi extern int64_t max_iobuffer_size;
 extern int64_t default_small_iobuffer_size;
 extern int64_t default_large_iobuffer_size; // matched to size of OS buffers
+extern int64_t thread_iobuffer_bytes; // held per size class per thread
 
 #define TRACK_BUFFER_USER
 
@@ -254,6 +255,51 @@ public:
   */
   char *_data;
 
+  /**
+    File the contents come from, or -1. When set, '_data' only holds
+    the first bytes of the contents and blocks may extend past the
+    allocated memory: such blocks are sent from the file by a
+    NetVConnection which is_zero_copy_capable() and are not
+    dereferenceable (see file_backed()). Their file offset is
+    '_fd_offset' plus their offset from '_data'.
+
+  */
+  int _fd;
+  off_t _fd_offset;
+
+  /**
+    Called by the sender before and after each send from '_fd', since
+    the owner of the file may reuse the range later. Returns 1 if the
+    range may be sent from the file, 0 if it is about to be reused and
+    must be copied through memory now, and -1 if it is gone. NULL if
+    the range is never reused. '_fd_owner' and '_fd_limit' are for the
+    use of the function.
+
+  */
+  int (*_fd_check) (IOBufferData *);
+  void *_fd_owner;
+  int64_t _fd_limit;
+
+  /**
+    Set on the copy of a file backed block whose range was reused or
+    could not be read (see IOBufferBlock::load_file()). Its bytes are
+    not the contents, so NetVConnections fail the write rather than
+    send them.
+
+  */
+  bool _lost;
+
+  /**
+    True if the contents come from '_fd'. Blocks of such data are meant
+    to be sent, not read through their pointers: readers that need the
+    bytes copy the block into memory first (IOBufferBlock::load_file()).
+
+  */
+  bool file_backed() const
+  {
+    return _fd >= 0;
+  }
+
 #ifdef TRACK_BUFFER_USER
   const char *_location;
 #endif
@@ -264,7 +310,8 @@ public:
 
   */
   IOBufferData()
-:  _size_index(BUFFER_SIZE_NOT_ALLOCATED), _mem_type(NO_ALLOC), _data(NULL)
+:  _size_index(BUFFER_SIZE_NOT_ALLOCATED), _mem_type(NO_ALLOC), _data(NULL), _fd(-1), _fd_offset(0),
+    _fd_check(NULL), _fd_owner(NULL), _fd_limit(0), _lost(false)
 #ifdef TRACK_BUFFER_USER
     , _location(NULL)
 #endif
@@ -475,6 +522,17 @@ public:
   void realloc_xmalloc(void *b, int64_t buf_size);
   void realloc_xmalloc(int64_t buf_size);
 
+  /**
+    Replaces the contents of a block whose data is file_backed() by a
+    copy in memory. Readers of such blocks fall back to this rather
+    than dereference them, should one ever reach a consumer other than
+    a zero copy send. The copy is read from the file synchronously. If
+    the range is gone the copy is zeroed and marked IOBufferData::_lost.
+
+  */
+  void load_file();
+  bool read_file(char *b);
+
   /**
     Frees the IOBufferBlock object and its underlying memory.
     Removes the reference to the IOBufferData object and then frees
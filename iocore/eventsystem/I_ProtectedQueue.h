@@ -46,11 +46,16 @@ struct ProtectedQueue
   void remove(Event * e);
   Event *dequeue_local();
   void dequeue_timed(ink_hrtime cur_time, ink_hrtime timeout, bool sleep);
+  int steal(EThread * victim, EThread * thief);
+  static void count(EThread * target, int64_t n);
 
   InkAtomicList al;
   ink_mutex lock;
   ink_cond might_have_data;
   Que(Event, link) localQueue;
+  // events pushed onto less those taken off the external queue by
+  // threads without their own counts (see EThread::queued_events)
+  volatile int64_t n_queued_shared;
 
   ProtectedQueue();
 };
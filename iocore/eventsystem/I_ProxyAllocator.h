@@ -37,51 +37,98 @@ class EThread;
 
 #define MAX_ON_THREAD_FREELIST 512
 
+/**
+  Per-thread cache of free objects in front of a global Allocator.
+  When a thread frees more than its limit, the older half of the cache
+  goes back to the global free pool as a single batch; a thread that
+  runs dry takes a whole batch back the same way, so objects produced
+  on one thread and released on another cost one atomic operation per
+  batch instead of one per object.
+
+*/
 struct ProxyAllocator
 {
   int allocated;
   void *freelist;
+  Allocator *global;            // set the first time the cache misses or spills
+  uint64_t hits, misses, refills, spills;
 
-  ProxyAllocator():allocated(0), freelist(0) { }
+  ProxyAllocator():allocated(0), freelist(0), global(0), hits(0), misses(0), refills(0), spills(0) { }
 };
 
+// take a batch from the global depot, returning its first item
+inline void *
+thread_refill(Allocator &a, ProxyAllocator & l)
+{
+  uint32_t n;
+  void *v = a.alloc_void_batch(&n);
+
+  l.global = &a;
+  if (!v) {
+    l.misses++;
+    return NULL;
+  }
+  l.refills++;
+  l.freelist = *(void **) v;
+  l.allocated = n - 1;
+  return v;
+}
+
 template<class C> inline C * thread_alloc(ClassAllocator<C> &a, ProxyAllocator & l)
 {
   if (l.freelist) {
     C *v = (C *) l.freelist;
     l.freelist = *(C **) l.freelist;
     l.allocated--;
+    l.hits++;
     *(void **) v = *(void **) &a.proto.typeObject;
     return v;
   }
+  if (C *v = (C *) thread_refill(a, l)) {
+    // the batch header overwrote the first words of the first item
+    memcpy((void *) v, (void *) &a.proto.typeObject,
+           sizeof(C) < 3 * sizeof(void *) ? sizeof(C) : 3 * sizeof(void *));
+    return v;
+  }
   return a.alloc();
 }
 
 template<class C> inline C * thread_alloc_init(ClassAllocator<C> &a, ProxyAllocator & l)
 {
-  if (l.freelist) {
-    C *v = (C *) l.freelist;
+  C *v = (C *) l.freelist;
+
+  if (v) {
     l.freelist = *(C **) l.freelist;
     l.allocated--;
-    memcpy((void *) v, (void *) &a.proto.typeObject, sizeof(C));
-    return v;
-  }
-  return a.alloc();
+    l.hits++;
+  } else if (!(v = (C *) thread_refill(a, l)))
+    return a.alloc();
+  memcpy((void *) v, (void *) &a.proto.typeObject, sizeof(C));
+  return v;
 }
 
-template<class C> inline void
-thread_freeup(ClassAllocator<C> &a, ProxyAllocator & l)
+inline void *
+thread_alloc(Allocator &a, ProxyAllocator & l)
 {
-  while (l.freelist) {
-    C *v = (C *) l.freelist;
-    l.freelist = *(C **) l.freelist;
+  if (l.freelist) {
+    void *v = l.freelist;
+    l.freelist = *(void **) l.freelist;
     l.allocated--;
-    a.free(v);                  // we could use a bulk free here
+    l.hits++;
+    return v;
   }
-  ink_assert(!l.allocated);
+  if (void *v = thread_refill(a, l))
+    return v;
+  return a.alloc_void();
 }
 
-#if defined(TS_USE_FREELIST)
+/** Keep the first keep items on the thread and return the rest as one batch. */
+void thread_freeup(Allocator &a, ProxyAllocator & l, int keep = 0);
+
+/** Print per-thread allocator cache statistics. */
+void thread_freelists_dump(FILE * f);
+
+#if TS_USE_FREELIST
 #define THREAD_ALLOC(_a, _t) thread_alloc(::_a, _t->_a)
 #define THREAD_ALLOC_INIT(_a, _t) thread_alloc_init(::_a, _t->_a)
 #define THREAD_FREE_TO(_p, _a, _t, _m) do { \
@@ -89,7 +136,7 @@ thread_freeup(ClassAllocator<C> &a, ProxyAllocator & l)
   _t->_a.freelist = _p;                     \
   _t->_a.allocated++;                       \
   if (_t->_a.allocated > _m)                \
-    thread_freeup(::_a, _t->_a);            \
+    thread_freeup(::_a, _t->_a, (_m) / 2);  \
 } while (0)
 #else
 #define THREAD_ALLOC(_a, _t) ::_a.alloc()
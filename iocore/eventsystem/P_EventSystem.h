@@ -57,6 +57,18 @@
                                        PRIVATE_MODULE_HEADER)
 
 
+// Stats
+enum EventSystem_Stats
+{
+  eventsystem_events_stolen_stat,
+  eventsystem_queue_depth_stat,
+  eventsystem_queue_depth_max_stat,
+  eventsystem_thread_iobuffer_bytes_stat,
+  EventSystem_Stat_Count
+};
+
+extern RecRawStatBlock *eventsystem_rsb;
+
 // Macro definitions
 
 // error signalling macros
@@ -54,6 +54,72 @@ iobuffer_size_to_index(int64_t size, int64_t max)
   return buffer_size_to_index(size, max);
 }
 
+//////////////////////////////////////////////////////////////
+//
+// Buffer memory, IOBufferData and IOBufferBlock objects are
+// cached per thread.  A size class keeps at most
+// thread_iobuffer_bytes (proxy.config.io.thread_buffer_bytes)
+// bytes before the older half goes back to the global allocator
+// as one batch.  Without freelists (--disable-freelist) nothing
+// is cached, so that memory checkers see every buffer.
+//
+//////////////////////////////////////////////////////////////
+#define DEFAULT_THREAD_IOBUFFER_BYTES   (1 << 20)
+
+TS_INLINE void *
+thread_iobuffer_alloc(int64_t i)
+{
+#if TS_USE_FREELIST
+  EThread *t = this_ethread();
+
+  if (t)
+    return thread_alloc(ioBufAllocator[i], t->ioBufAllocator[i]);
+#endif
+  return ioBufAllocator[i].alloc_void();
+}
+
+TS_INLINE void
+thread_iobuffer_free(void *b, int64_t i)
+{
+#if TS_USE_FREELIST
+  EThread *t = this_ethread();
+
+  if (t) {
+    ProxyAllocator & l = t->ioBufAllocator[i];
+    int64_t max = thread_iobuffer_bytes / BUFFER_SIZE_FOR_INDEX(i);
+
+    if (max > MAX_ON_THREAD_FREELIST)
+      max = MAX_ON_THREAD_FREELIST;
+    *(void **) b = l.freelist;
+    l.freelist = b;
+    if (++l.allocated > max)
+      thread_freeup(ioBufAllocator[i], l, max / 2);
+    return;
+  }
+#endif
+  ioBufAllocator[i].free_void(b);
+}
+
+TS_INLINE IOBufferData *
+thread_iobuffer_data_alloc()
+{
+  EThread *t = this_ethread();
+
+  if (t)
+    return THREAD_ALLOC_INIT(ioDataAllocator, t);
+  return ioDataAllocator.alloc();
+}
+
+TS_INLINE IOBufferBlock *
+thread_iobuffer_block_alloc()
+{
+  EThread *t = this_ethread();
+
+  if (t)
+    return THREAD_ALLOC_INIT(ioBlockAllocator, t);
+  return ioBlockAllocator.alloc();
+}
+
 TS_INLINE int64_t
 index_to_buffer_size(int64_t idx)
 {
@@ -203,7 +269,7 @@ new_IOBufferData_internal(
                            void *b, int64_t size, int64_t asize_index)
 {
   (void) size;
-  IOBufferData *d = ioDataAllocator.alloc();
+  IOBufferData *d = thread_iobuffer_data_alloc();
   d->_size_index = asize_index;
   ink_assert(BUFFER_SIZE_INDEX_IS_CONSTANT(asize_index)
              || size <= d->block_size());
@@ -263,7 +329,7 @@ new_IOBufferData_internal(
 #endif
                            int64_t size_index, AllocType type)
 {
-  IOBufferData *d = ioDataAllocator.alloc();
+  IOBufferData *d = thread_iobuffer_data_alloc();
 #ifdef TRACK_BUFFER_USER
   d->_location = loc;
 #endif
@@ -288,7 +354,7 @@ IOBufferData::alloc(int64_t size_index, AllocType type)
   switch (type) {
   case MEMALIGNED:
     if (BUFFER_SIZE_INDEX_IS_FAST_ALLOCATED(size_index))
-      _data = (char *) ioBufAllocator[size_index].alloc_void();
+      _data = (char *) thread_iobuffer_alloc(size_index);
     // coverity[dead_error_condition]
     else if (BUFFER_SIZE_INDEX_IS_XMALLOCED(size_index))
       _data = (char *)ats_memalign(sysconf(_SC_PAGESIZE), index_to_buffer_size(size_index));
@@ -296,7 +362,7 @@ IOBufferData::alloc(int64_t size_index, AllocType type)
   default:
   case DEFAULT_ALLOC:
     if (BUFFER_SIZE_INDEX_IS_FAST_ALLOCATED(size_index))
-      _data = (char *) ioBufAllocator[size_index].alloc_void();
+      _data = (char *) thread_iobuffer_alloc(size_index);
     else if (BUFFER_SIZE_INDEX_IS_XMALLOCED(size_index))
       _data = (char *)ats_malloc(BUFFER_SIZE_FOR_XMALLOC(size_index));
     break;
@@ -315,14 +381,14 @@ IOBufferData::dealloc()
   switch (_mem_type) {
   case MEMALIGNED:
     if (BUFFER_SIZE_INDEX_IS_FAST_ALLOCATED(_size_index))
-      ioBufAllocator[_size_index].free_void(_data);
+      thread_iobuffer_free(_data, _size_index);
     else if (BUFFER_SIZE_INDEX_IS_XMALLOCED(_size_index))
       ::free((void *) _data);
     break;
   default:
   case DEFAULT_ALLOC:
     if (BUFFER_SIZE_INDEX_IS_FAST_ALLOCATED(_size_index))
-      ioBufAllocator[_size_index].free_void(_data);
+      thread_iobuffer_free(_data, _size_index);
     else if (BUFFER_SIZE_INDEX_IS_XMALLOCED(_size_index))
       ats_free(_data);
     break;
@@ -330,13 +396,22 @@ IOBufferData::dealloc()
   _data = 0;
   _size_index = BUFFER_SIZE_NOT_ALLOCATED;
   _mem_type = NO_ALLOC;
+  _fd = -1;
+  _fd_check = NULL;
+  _fd_owner = NULL;
+  _lost = false;
 }
 
 TS_INLINE void
 IOBufferData::free()
 {
+  EThread *t = this_ethread();
+
   dealloc();
-  ioDataAllocator.free(this);
+  if (t)
+    THREAD_FREE(this, ioDataAllocator, t);
+  else
+    ioDataAllocator.free(this);
 }
 
 //////////////////////////////////////////////////////////////////
@@ -352,7 +427,7 @@ new_IOBufferBlock_internal(
 #endif
   )
 {
-  IOBufferBlock *b = ioBlockAllocator.alloc();
+  IOBufferBlock *b = thread_iobuffer_block_alloc();
 #ifdef TRACK_BUFFER_USER
   b->_location = location;
 #endif
@@ -366,7 +441,7 @@ new_IOBufferBlock_internal(
 #endif
                             IOBufferData * d, int64_t len, int64_t offset)
 {
-  IOBufferBlock *b = ioBlockAllocator.alloc();
+  IOBufferBlock *b = thread_iobuffer_block_alloc();
 #ifdef TRACK_BUFFER_USER
   b->_location = location;
 #endif
@@ -467,8 +542,13 @@ IOBufferBlock::dealloc()
 TS_INLINE void
 IOBufferBlock::free()
 {
+  EThread *t = this_ethread();
+
   dealloc();
-  ioBlockAllocator.free(this);
+  if (t)
+    THREAD_FREE(this, ioBlockAllocator, t);
+  else
+    ioBlockAllocator.free(this);
 }
 
 TS_INLINE void
@@ -501,9 +581,14 @@ TS_INLINE void
 IOBufferBlock::realloc_set_internal(void *b, int64_t buf_size, int64_t asize_index)
 {
   int64_t data_size = size();
-  memcpy(b, _start, size());
+  bool lost = data->_lost;
+  if (unlikely(data->file_backed()))
+    lost = !read_file(b);
+  else
+    memcpy(b, _start, size());
   dealloc();
   set_internal(b, buf_size, asize_index);
+  data->_lost = lost;
   _end = _start + data_size;
 }
 
@@ -525,6 +610,13 @@ IOBufferBlock::realloc_xmalloc(int64_t buf_size)
   realloc_set_internal(ats_malloc(buf_size), buf_size, -buf_size);
 }
 
+TS_INLINE void
+IOBufferBlock::load_file()
+{
+  if (size())
+    realloc_xmalloc(size());
+}
+
 TS_INLINE void
 IOBufferBlock::realloc(int64_t i)
 {
@@ -534,7 +626,7 @@ IOBufferBlock::realloc(int64_t i)
     return;
 
   ink_release_assert(i > data->_size_index && i != BUFFER_SIZE_NOT_ALLOCATED);
-  void *b = ioBufAllocator[i].alloc_void();
+  void *b = thread_iobuffer_alloc(i);
   realloc_set_internal(b, BUFFER_SIZE_FOR_INDEX(i), i);
 }
 
@@ -583,6 +675,8 @@ IOBufferReader::start()
   if (block == 0)
     return 0;
   skip_empty_blocks();
+  if (unlikely(block->data->file_backed()))
+    block->load_file();
   return block->start() + start_offset;
 }
 
@@ -35,6 +35,7 @@
 
 TS_INLINE
 ProtectedQueue::ProtectedQueue()
+  : n_queued_shared(0)
 {
   Event e;
   ink_mutex_init(&lock, "ProtectedQueue");
@@ -77,7 +78,9 @@ TS_INLINE void
 ProtectedQueue::remove(Event * e)
 {
   ink_assert(e->in_the_prot_queue);
-  if (!ink_atomiclist_remove(&al, e))
+  if (ink_atomiclist_remove(&al, e))
+    count(e->ethread, -1);
+  else
     localQueue.remove(e);
   e->in_the_prot_queue = 0;
 }
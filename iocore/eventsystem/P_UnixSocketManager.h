@@ -223,6 +223,26 @@ SocketManager::pwrite(int fd, void *buf, int size, off_t offset, char *tag)
   return r;
 }
 
+TS_INLINE int64_t
+SocketManager::sendfile(int fd, int in_fd, off_t offset, int64_t size)
+{
+#if TS_HAVE_SYS_SENDFILE_H
+  int64_t r;
+  do {
+    if (likely((r =::sendfile(fd, in_fd, &offset, size)) >= 0))
+      break;
+    r = -errno;
+  } while (r == -EINTR);
+  return r;
+#else
+  NOWARN_UNUSED(fd);
+  NOWARN_UNUSED(in_fd);
+  NOWARN_UNUSED(offset);
+  NOWARN_UNUSED(size);
+  return -ENOTSUP;
+#endif
+}
+
 TS_INLINE int64_t
 SocketManager::writev(int fd, struct iovec *vector, size_t count)
 {
@@ -40,39 +40,55 @@
 // Defining EAGER_SIGNALLING disables this behavior and causes
 // threads to be made runnable immediately.
 //
+// Threads with a signal_hook (the net threads) never sleep on the
+// condition variable; they block in the poll on their eventfd. They are
+// woken directly through the hook as soon as their queue turns non-empty,
+// without the condition variable and without deferring the signal.
+//
 // #define EAGER_SIGNALLING
 
 extern ClassAllocator<Event> eventAllocator;
 
+// Counts n events pushed onto (n > 0) or taken off (n < 0) the external
+// queue of target. Each event thread keeps its own counts, so this is a
+// plain add on memory no other thread writes; their sum over all threads
+// is the depth of the queue. Threads without counts share an atomic one.
+void
+ProtectedQueue::count(EThread *target, int64_t n)
+{
+  EThread *t = this_ethread();
+  if (t && t->queued_events && target->id >= 0 && target->id < MAX_EVENT_THREADS)
+    t->queued_events[target->id] += n;
+  else
+    ink_atomic_increment(&target->EventQueueExternal.n_queued_shared, n);
+}
+
 void
 ProtectedQueue::enqueue(Event *e , bool fast_signal)
 {
   ink_assert(!e->in_the_prot_queue && !e->in_the_priority_queue);
   EThread *e_ethread = e->ethread;
   e->in_the_prot_queue = 1;
+  count(e_ethread, 1);
   bool was_empty = (ink_atomiclist_push(&al, e) == NULL);
 
+  NOWARN_UNUSED(fast_signal);
+
   if (was_empty) {
     EThread *inserting_thread = this_ethread();
     // queue e->ethread in the list of threads to be signalled
     // inserting_thread == 0 means it is not a regular EThread
     if (inserting_thread != e_ethread) {
-      if (!inserting_thread || !inserting_thread->ethreads_to_be_signalled) {
+      if (e_ethread->signal_hook) {
+        e_ethread->signal_hook(e_ethread);
+      } else if (!inserting_thread || !inserting_thread->ethreads_to_be_signalled) {
         signal();
-        if (fast_signal) {
-          if (e_ethread->signal_hook)
-            e_ethread->signal_hook(e_ethread);
-        }
       } else {
 #ifdef EAGER_SIGNALLING
         // Try to signal now and avoid deferred posting.
         if (e_ethread->EventQueueExternal.try_signal())
           return;
 #endif
-        if (fast_signal) {
-          if (e_ethread->signal_hook)
-            e_ethread->signal_hook(e_ethread);
-        }
         int &t = inserting_thread->n_ethreads_to_be_signalled;
         EThread **sig_e = inserting_thread->ethreads_to_be_signalled;
         if ((t + 1) >= eventProcessor.n_ethreads) {
@@ -127,10 +143,12 @@ flush_signals(EThread * thr)
   }
 #endif
   for (i = 0; i < n; i++) {
-    if (thr->ethreads_to_be_signalled[i]) {
-      thr->ethreads_to_be_signalled[i]->EventQueueExternal.signal();
-      if (thr->ethreads_to_be_signalled[i]->signal_hook)
-        thr->ethreads_to_be_signalled[i]->signal_hook(thr->ethreads_to_be_signalled[i]);
+    EThread *t = thr->ethreads_to_be_signalled[i];
+    if (t) {
+      if (t->signal_hook)
+        t->signal_hook(t);
+      else
+        t->EventQueueExternal.signal();
       thr->ethreads_to_be_signalled[i] = 0;
     }
   }
@@ -158,7 +176,9 @@ ProtectedQueue::dequeue_timed(ink_hrtime cur_time, ink_hrtime timeout, bool slee
   while ((e = t.pop()))
     l.push(e);
   // insert into localQueue
+  int n = 0;
   while ((e = l.pop())) {
+    n++;
     if (!e->cancelled)
       localQueue.enqueue(e);
     else {
@@ -166,4 +186,74 @@ ProtectedQueue::dequeue_timed(ink_hrtime cur_time, ink_hrtime timeout, bool slee
       eventAllocator.free(e);
     }
   }
+  if (n)
+    count(this_ethread(), -n);
+}
+
+// int ProtectedQueue::steal(EThread *victim, EThread *thief)
+//
+//   Moves up to half of the immediate events waiting in the external
+//   queue of victim into this (the thief's) local queue, oldest first.
+//   Events locked by the victim's thread mutex are bound to that thread
+//   and are put back in their original order, underneath anything
+//   queued meanwhile, so the victim still runs them before those.
+//   Returns the number of events stolen.
+//
+int
+ProtectedQueue::steal(EThread *victim, EThread *thief)
+{
+  ProtectedQueue *q = &victim->EventQueueExternal;
+  Event *e = (Event *) ink_atomiclist_popall(&q->al);
+
+  if (!e)
+    return 0;
+
+  // invert the list, to preserve order
+  SLL<Event, Event::Link_link> l, t;
+  int n = 0;
+  t.head = e;
+  while ((e = t.pop())) {
+    l.push(e);
+    n++;
+  }
+
+  Que(Event, link) keep;
+  int stolen = 0;
+  while ((e = l.pop())) {
+    if (stolen < (n + 1) / 2 && !e->cancelled && !e->timeout_at && e->mutex.m_ptr != victim->mutex) {
+      e->ethread = thief;
+      localQueue.enqueue(e);
+      stolen++;
+    } else
+      keep.enqueue(e);
+  }
+
+  if (stolen)
+    count(victim, -stolen);
+  if (keep.head) {
+    // rebuild the chain newest first, as the list holds it
+    Event *chain = NULL;
+    while ((e = keep.dequeue())) {
+      e->link.next = chain;
+      chain = e;
+    }
+    for (;;) {
+      Event *newer = (Event *) ink_atomiclist_popall(&q->al);
+      if (newer) {
+        Event *last = newer;
+        while (last->link.next)
+          last = last->link.next;
+        last->link.next = chain;
+        chain = newer;
+      }
+      if (ink_atomiclist_pushall_if_empty(&q->al, chain))
+        break;
+    }
+    // The victim may have gone to sleep while its queue was empty.
+    if (victim->signal_hook)
+      victim->signal_hook(victim);
+    else
+      q->signal();
+  }
+  return stolen;
 }
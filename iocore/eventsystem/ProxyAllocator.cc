@@ -0,0 +1,100 @@
+/** @file
+
+  Per-thread allocator caches
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "P_EventSystem.h"
+
+void
+thread_freeup(Allocator &a, ProxyAllocator & l, int keep)
+{
+  void **last = &l.freelist;
+
+  // the most recently freed items are at the front and still warm
+  for (int i = 0; i < keep && *last; i++)
+    last = (void **) *last;
+  if (void *head = *last) {
+    uint32_t n = l.allocated - keep;
+    *last = NULL;
+    l.allocated -= n;
+    l.global = &a;
+    l.spills++;
+    a.free_void_batch(head, n);
+  }
+}
+
+static ProxyAllocator EThread::*const thread_allocators[] = {
+  &EThread::eventAllocator,
+  &EThread::netVCAllocator,
+  &EThread::sslNetVCAllocator,
+  &EThread::httpClientSessionAllocator,
+  &EThread::httpServerSessionAllocator,
+  &EThread::cacheVConnectionAllocator,
+  &EThread::openDirEntryAllocator,
+  &EThread::ramCacheCLFUSEntryAllocator,
+  &EThread::ramCacheLRUEntryAllocator,
+  &EThread::ramCacheTLFUEntryAllocator,
+  &EThread::evacuationBlockAllocator,
+  &EThread::ioDataAllocator,
+  &EThread::ioBlockAllocator
+};
+
+static void
+thread_freelist_dump(FILE * f, const char *thread, ProxyAllocator & l)
+{
+  // caches that never missed or spilled have not learned their allocator yet
+  if (!l.global)
+    return;
+  uint64_t total = l.hits + l.misses + l.refills;
+  fprintf(f, " %-8s | %12" PRIu64 " | %10" PRIu64 " | %8" PRIu64 " | %8" PRIu64 " | %5.1f%% | %7d | %12" PRIu64 " | %s\n",
+          thread, l.hits, l.misses, l.refills, l.spills, total ? 100.0 * (total - l.misses) / total : 0.0,
+          l.allocated, (uint64_t) l.allocated * l.global->element_size(),
+          l.global->name() ? l.global->name() : "<unknown>");
+}
+
+static void
+thread_freelists_dump(FILE * f, const char *thread, EThread * t)
+{
+  for (unsigned i = 0; i < sizeof(thread_allocators) / sizeof(thread_allocators[0]); i++)
+    thread_freelist_dump(f, thread, t->*thread_allocators[i]);
+  for (int i = 0; i < DEFAULT_BUFFER_SIZES; i++)
+    thread_freelist_dump(f, thread, t->ioBufAllocator[i]);
+}
+
+void
+thread_freelists_dump(FILE * f)
+{
+  char thread[16];
+
+  if (f == NULL)
+    f = stderr;
+
+  fprintf(f, "  thread  |     hits     |   misses   | refills  |  spills  | hit %%  |  held   |  held bytes  | allocator\n");
+  fprintf(f, "----------|--------------|------------|----------|----------|--------|---------|--------------|----------------------\n");
+  for (int i = 0; i < eventProcessor.n_ethreads; i++) {
+    snprintf(thread, sizeof(thread), "ET %d", i);
+    thread_freelists_dump(f, thread, eventProcessor.all_ethreads[i]);
+  }
+  for (int i = 0; i < eventProcessor.n_dthreads; i++) {
+    snprintf(thread, sizeof(thread), "DT %d", i);
+    thread_freelists_dump(f, thread, eventProcessor.dthreads[i]);
+  }
+}
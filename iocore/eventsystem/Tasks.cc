@@ -30,7 +30,17 @@ TasksProcessor tasksProcessor;
 int
 TasksProcessor::start(int task_threads)
 {
-  if (task_threads > 0)
+  if (task_threads > 0) {
+    int work_stealing = 0;
+
     ET_TASK = eventProcessor.spawn_event_threads(task_threads, "ET_TASK");
+    // Task events are not tied to a thread, so idle task threads may
+    // take them over from busy ones.
+    REC_ReadConfigInteger(work_stealing, "proxy.config.task_threads.work_stealing");
+    if (work_stealing && task_threads > 1) {
+      for (int i = 0; i < task_threads; i++)
+        eventProcessor.eventthread[ET_TASK][i]->steal_etype = ET_TASK;
+    }
+  }
   return 0;
 }
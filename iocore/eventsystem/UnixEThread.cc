@@ -44,29 +44,38 @@ EThread::EThread()
   : generator((uint64_t)ink_get_hrtime_internal() ^ (uint64_t)(uintptr_t)this),
    ethreads_to_be_signalled(NULL),
    n_ethreads_to_be_signalled(0),
+   queued_events(NULL),
    main_accept_index(-1),
    id(NO_ETHREAD_ID), event_types(0),
    signal_hook(0),
-   tt(REGULAR), eventsem(NULL)
+   tt(REGULAR), eventsem(NULL),
+   server_session_pool(NULL),
+   steal_etype(-1)
 {
   memset(thread_private, 0, PER_THREAD_DATA);
+  diskHandler = NULL;
 }
 
 EThread::EThread(ThreadType att, int anid)
   : generator((uint64_t)ink_get_hrtime_internal() ^ (uint64_t)(uintptr_t)this),
     ethreads_to_be_signalled(NULL),
     n_ethreads_to_be_signalled(0),
+    queued_events(NULL),
     main_accept_index(-1),
     id(anid),
     event_types(0),
     signal_hook(0),
     tt(att),
     eventsem(NULL),
-    l1_hash(NULL)
+    server_session_pool(NULL),
+    steal_etype(-1)
 {
   ethreads_to_be_signalled = (EThread **)ats_malloc(MAX_EVENT_THREADS * sizeof(EThread *));
   memset((char *) ethreads_to_be_signalled, 0, MAX_EVENT_THREADS * sizeof(EThread *));
+  queued_events = (int64_t *)ats_malloc(MAX_EVENT_THREADS * sizeof(int64_t));
+  memset((char *) queued_events, 0, MAX_EVENT_THREADS * sizeof(int64_t));
   memset(thread_private, 0, PER_THREAD_DATA);
+  diskHandler = NULL;
 #if TS_HAS_EVENTFD
   evfd = eventfd(0, O_NONBLOCK | FD_CLOEXEC);
   if (evfd < 0) {
@@ -92,13 +101,17 @@ EThread::EThread(ThreadType att, Event * e, ink_sem * sem)
  : generator((uint32_t)((uintptr_t)time(NULL) ^ (uintptr_t) this)),
    ethreads_to_be_signalled(NULL),
    n_ethreads_to_be_signalled(0),
+   queued_events(NULL),
    main_accept_index(-1),
    id(NO_ETHREAD_ID), event_types(0),
    signal_hook(0),
-   tt(att), oneevent(e), eventsem(sem)
+   tt(att), oneevent(e), eventsem(sem),
+   server_session_pool(NULL),
+   steal_etype(-1)
 {
   ink_assert(att == DEDICATED);
   memset(thread_private, 0, PER_THREAD_DATA);
+  diskHandler = NULL;
 }
 
 
@@ -109,8 +122,9 @@ EThread::~EThread()
   if (n_ethreads_to_be_signalled > 0)
     flush_signals(this);
   ats_free(ethreads_to_be_signalled);
+  ats_free(queued_events);
   // TODO: This can't be deleted ....
-  // delete[]l1_hash;
+  // delete server_session_pool;
 }
 
 bool
@@ -160,6 +174,33 @@ EThread::process_event(Event * e, int calling_code)
   }
 }
 
+//
+// int EThread::steal_events()
+//
+// Called by an idle thread before it sleeps. Looks for a peer in its
+// thread group with events waiting and takes over part of the
+// immediate events that are not bound to the peer's thread mutex.
+//
+int
+EThread::steal_events()
+{
+  int n = eventProcessor.n_threads_for_type[steal_etype];
+  int start = generator.random() % n;
+
+  for (int i = 0; i < n; i++) {
+    EThread *victim = eventProcessor.eventthread[steal_etype][(start + i) % n];
+
+    if (victim == this || INK_ATOMICLIST_EMPTY(victim->EventQueueExternal.al))
+      continue;
+    int stolen = EventQueueExternal.steal(victim, this);
+    if (stolen) {
+      RecIncrRawStat(eventsystem_rsb, this, (int) eventsystem_events_stolen_stat, stolen);
+      return stolen;
+    }
+  }
+  return 0;
+}
+
 //
 // void  EThread::execute()
 //
@@ -273,6 +314,9 @@ EThread::execute() {
             next_time = cur_time + THREAD_MAX_HEARTBEAT_MSECONDS * HRTIME_MSECOND;
             sleep_time = THREAD_MAX_HEARTBEAT_MSECONDS * HRTIME_MSECOND;
           }
+          // if idle, try to take some work off a busy peer first
+          if (steal_etype >= 0 && INK_ATOMICLIST_EMPTY(EventQueueExternal.al) && steal_events())
+            continue;
           // dequeue all the external events and put them in a local
           // queue. If there are no external events available, do a
           // cond_timedwait.
@@ -60,8 +60,11 @@ unsigned int hostdb_ip_stale_interval = HOST_DB_IP_STALE;
 unsigned int hostdb_ip_timeout_interval = HOST_DB_IP_TIMEOUT;
 unsigned int hostdb_ip_fail_timeout_interval = HOST_DB_IP_FAIL_TIMEOUT;
 unsigned int hostdb_serve_stale_but_revalidate = 0;
+unsigned int hostdb_refresh_ahead = 0;
+unsigned int hostdb_refresh_ahead_hits = 3;
 char hostdb_filename[PATH_NAME_MAX + 1] = DEFAULT_HOST_DB_FILENAME;
 int hostdb_size = DEFAULT_HOST_DB_SIZE;
+int hostdb_negative_size = 0;
 //int hostdb_timestamp = 0;
 int hostdb_sync_frequency = 60;
 int hostdb_disable_reverse_lookup = 0;
@@ -135,6 +138,18 @@ HostDBCache::HostDBCache()
   max_hits = (1 << HOST_DB_HITS_BITS) - 1;
   version.ink_major = HOST_DB_CACHE_MAJOR_VERSION;
   version.ink_minor = HOST_DB_CACHE_MINOR_VERSION;
+  memset(negative, 0, sizeof(negative));
+  negative_per_partition = 0;
+}
+
+
+void
+HostDBCache::alloc_negative(int size)
+{
+  negative_per_partition = (size + MULTI_CACHE_PARTITIONS - 1) / MULTI_CACHE_PARTITIONS;
+  for (int i = 0; i < MULTI_CACHE_PARTITIONS; i++)
+    negative[i] = NEW(new HostDBInfo[negative_per_partition]);
+  Debug("hostdb", "negative store of %d entries per partition", negative_per_partition);
 }
 
 
@@ -319,6 +334,7 @@ HostDBCache::start(int flags)
   IOCORE_ReadConfigInt32(hostdb_size, "proxy.config.hostdb.size");
   IOCORE_ReadConfigString(storage_path, "proxy.config.hostdb.storage_path", PATH_NAME_MAX);
   IOCORE_ReadConfigInt32(storage_size, "proxy.config.hostdb.storage_size");
+  IOCORE_ReadConfigInt32(hostdb_negative_size, "proxy.config.hostdb.negative_size");
 
   if (storage_path[0] != '/') {
     Layout::relative_to(storage_path, PATH_NAME_MAX,
@@ -364,6 +380,8 @@ HostDBCache::start(int flags)
     }
   }
   HOSTDB_SET_DYN_COUNT(hostdb_bytes_stat, totalsize);
+  if (hostdb_negative_size > 0)
+    alloc_negative(hostdb_negative_size);
   //  XXX I don't see this being reference in the previous function calls, so I am going to delete it -bcall
   delete hostDBStore;
   return 0;
@@ -410,6 +428,8 @@ HostDBProcessor::start(int)
   IOCORE_EstablishStaticConfigInt32U(hostdb_ip_stale_interval, "proxy.config.hostdb.verify_after");
   IOCORE_EstablishStaticConfigInt32U(hostdb_ip_fail_timeout_interval, "proxy.config.hostdb.fail.timeout");
   IOCORE_EstablishStaticConfigInt32U(hostdb_serve_stale_but_revalidate, "proxy.config.hostdb.serve_stale_for");
+  IOCORE_EstablishStaticConfigInt32U(hostdb_refresh_ahead, "proxy.config.hostdb.refresh_ahead");
+  IOCORE_EstablishStaticConfigInt32U(hostdb_refresh_ahead_hits, "proxy.config.hostdb.refresh_ahead_hits");
 
   //
   // Set up hostdb_current_interval
@@ -550,6 +570,19 @@ Ldelete:
 }
 
 
+// Is a DNS lookup for md5 already on its way?
+static bool
+dns_pending(INK_MD5 & md5)
+{
+  Queue<HostDBContinuation> &q = hostDB.pending_dns_for_hash(md5);
+  for (HostDBContinuation *c = q.head; c; c = (HostDBContinuation *) c->link.next) {
+    if (md5 == c->md5)
+      return true;
+  }
+  return false;
+}
+
+
 HostDBInfo *
 probe(ProxyMutex *mutex, INK_MD5 & md5, const char *hostname, int len, sockaddr const* ip, void *pDS, bool ignore_timeout,
       bool is_srv_lookup)
@@ -572,10 +605,13 @@ probe(ProxyMutex *mutex, INK_MD5 & md5, const char *hostname, int len, sockaddr
           Debug("hostdb", "fail timeout %u", r->ip_interval());
           return NULL;
         }
-      } else if (!ignore_timeout && r->is_ip_timeout() && !r->serve_stale_but_revalidate()) {
-        Debug("hostdb", "timeout %u %u %u", r->ip_interval(), r->ip_timestamp, r->ip_timeout_interval);
-        HOSTDB_INCREMENT_DYN_STAT(hostdb_ttl_expires_stat);
-        return NULL;
+      } else if (!ignore_timeout && r->is_ip_timeout()) {
+        HOSTDB_INCREMENT_DYN_STAT(hostdb_expired_lookups_stat);
+        if (!r->serve_stale_but_revalidate()) {
+          Debug("hostdb", "timeout %u %u %u", r->ip_interval(), r->ip_timestamp, r->ip_timeout_interval);
+          HOSTDB_INCREMENT_DYN_STAT(hostdb_ttl_expires_stat);
+          return NULL;
+        }
       }
 //error conditions
       if (r->reverse_dns && !r->hostname()) {
@@ -600,10 +636,20 @@ probe(ProxyMutex *mutex, INK_MD5 & md5, const char *hostname, int len, sockaddr
               r->ip_timestamp, r->ip_timeout_interval);
         r->refresh_ip();
         if (!is_dotted_form_hostname(hostname)) {
+          HOSTDB_INCREMENT_DYN_STAT(hostdb_total_refreshes_stat);
           HostDBContinuation *c = hostDBContAllocator.alloc();
           c->init(hostname, len, ip, md5, NULL, pDS, is_srv_lookup, 0);
           c->do_dns();
         }
+      } else if (!ignore_timeout && !r->failed() && !r->reverse_dns && r->is_ip_refresh_ahead()
+                 && !is_dotted_form_hostname(hostname) && !dns_pending(md5)) {
+        // a popular record about to expire: fetch the next answer now,
+        // so lookups never find it timed out
+        Debug("hostdb", "refresh ahead %s, %d seconds left, hits %u", hostname, r->ip_time_remaining(), r->hits);
+        HOSTDB_INCREMENT_DYN_STAT(hostdb_total_refreshes_stat);
+        HostDBContinuation *c = hostDBContAllocator.alloc();
+        c->init(hostname, len, ip, md5, NULL, pDS, is_srv_lookup, 0);
+        c->do_dns();
       }
 
       r->hits++;
@@ -611,6 +657,19 @@ probe(ProxyMutex *mutex, INK_MD5 & md5, const char *hostname, int len, sockaddr
         r->hits--;
       return r;
     }
+
+    if (hostDB.negative_per_partition) {
+      HostDBInfo *n = hostDB.negative_slot(folded_md5);
+      if (n->full && n->tag() == hostDB.make_tag(folded_md5) && md5[1] == n->md5_high) {
+        if (n->is_ip_fail_timeout()) {
+          Debug("hostdb", "negative entry for %s timed out %u", hostname, n->ip_interval());
+          return NULL;
+        }
+        Debug("hostdb", "negative entry for %s", hostname);
+        HOSTDB_INCREMENT_DYN_STAT(hostdb_negative_hits_stat);
+        return n;
+      }
+    }
   }
   return NULL;
 }
@@ -642,6 +701,32 @@ HostDBContinuation::insert(unsigned int attl)
 }
 
 
+//
+// Record a failed lookup in the negative store, taking the name out of
+// the main table.
+//
+HostDBInfo *
+HostDBContinuation::insert_negative(unsigned int attl)
+{
+  ink_debug_assert(this_ethread() == hostDB.lock_for_bucket((int) (fold_md5(md5) % hostDB.buckets))->thread_holding);
+  uint64_t folded_md5 = fold_md5(md5);
+  HostDBInfo *old_r = hostDB.lookup_block(folded_md5, 3);
+  if (old_r)
+    hostDB.delete_block(old_r);
+  HostDBInfo *r = hostDB.negative_slot(folded_md5);
+  r->reset();
+  r->set_empty();
+  r->set_full(folded_md5, hostDB.buckets);
+  r->md5_high = md5[1];
+  if (attl > HOST_DB_MAX_TTL)
+    attl = HOST_DB_MAX_TTL;
+  r->ip_timeout_interval = attl;
+  r->ip_timestamp = hostdb_current_interval;
+  Debug("hostdb", "inserting negative entry for: %s: (md5: %" PRIx64") now: %u", name, folded_md5, r->ip_timestamp);
+  return r;
+}
+
+
 //
 // Get an entry by either name or IP
 //
@@ -750,7 +835,7 @@ Lretry:
   if (thread->mutex == cont->mutex) {
     thread->schedule_in(c, MUTEX_RETRY_DELAY);
   } else {
-    dnsProcessor.thread->schedule_imm(c);
+    dnsProcessor.lookup_thread(thread)->schedule_imm(c);
   }
 
   return &c->action;
@@ -846,7 +931,7 @@ HostDBProcessor::getSRVbyname_imm(Continuation * cont, process_srv_info_pfn proc
   if (thread->mutex == cont->mutex) {
     thread->schedule_in(c, MUTEX_RETRY_DELAY);
   } else {
-    dnsProcessor.thread->schedule_imm(c);
+    dnsProcessor.lookup_thread(thread)->schedule_imm(c);
   }
 
   return &c->action;
@@ -920,7 +1005,8 @@ HostDBProcessor::getbyname_imm(Continuation * cont, process_hostdb_info_pfn proc
       if (r) {
         Debug("hostdb", "immediate answer for %s", hostname ? hostname : "<addr>");
         HOSTDB_INCREMENT_DYN_STAT(hostdb_total_hits_stat);
-        (cont->*process_hostdb_info) (r);
+        // a cached failure (negative store or fail.timeout) answers like reply_to_cont()
+        (cont->*process_hostdb_info) (r->failed() ? NULL : r);
         return ACTION_RESULT_DONE;
       }
     }
@@ -1172,7 +1258,10 @@ HostDBContinuation::lookup_done(sockaddr const* aip, char *aname, bool around_ro
       ip_text_buffer b;
       Debug("hostdb", "failed for %s", ats_ip_ntop(&ip.sa, b, sizeof b));
     }
-    i = insert(hostdb_ip_fail_timeout_interval);        // currently ... 0
+    if (hostDB.negative_per_partition)
+      i = insert_negative(hostdb_ip_fail_timeout_interval);
+    else
+      i = insert(hostdb_ip_fail_timeout_interval);      // currently ... 0
     i->round_robin = false;
     i->reverse_dns = !is_byname() && !is_srv();
   } else {
@@ -1345,6 +1434,21 @@ HostDBContinuation::dnsEvent(int event, HostEnt * e)
     int ttl_seconds = failed ? 0 : e->ttl;      //ebalsa: moving to second accuracy
 
     HostDBInfo *old_r = probe(mutex, md5, name, namelen, &ip.sa, m_pDS, true);
+
+    // A background refresh that failed does not replace an answer
+    // which has not timed out yet
+    if (failed && !action.continuation && old_r && !old_r->failed() && !old_r->is_ip_timeout()
+#ifdef NON_MODULAR
+        && !from_cont
+#endif
+      ) {
+      Debug("hostdb", "refresh of %s failed, keeping the current answer for %d seconds", name,
+            old_r->ip_time_remaining());
+      remove_trigger_pending_dns();
+      hostdb_cont_free(this);
+      return EVENT_DONE;
+    }
+
     HostDBInfo old_info;
     if (old_r)
       old_info = *old_r;
@@ -2363,4 +2467,130 @@ ink_hostdb_init(ModuleVersion v)
 
   RecRegisterRawStat(hostdb_rsb, RECT_PROCESS,
                      "proxy.process.hostdb.bytes", RECD_INT, RECP_NULL, (int) hostdb_bytes_stat, RecRawStatSyncCount);
+
+  RecRegisterRawStat(hostdb_rsb, RECT_PROCESS,
+                     "proxy.process.hostdb.total_refreshes",
+                     RECD_INT, RECP_NULL, (int) hostdb_total_refreshes_stat, RecRawStatSyncSum);
+
+  RecRegisterRawStat(hostdb_rsb, RECT_PROCESS,
+                     "proxy.process.hostdb.expired_lookups",
+                     RECD_INT, RECP_NULL, (int) hostdb_expired_lookups_stat, RecRawStatSyncSum);
+
+  RecRegisterRawStat(hostdb_rsb, RECT_PROCESS,
+                     "proxy.process.hostdb.negative_hits",
+                     RECD_INT, RECP_NULL, (int) hostdb_negative_hits_stat, RecRawStatSyncSum);
+}
+
+
+#if TS_HAS_TESTS
+static inline uint64_t
+hostdb_regression_key(uint64_t i)
+{
+  uint64_t z = (i + 1) * 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+//
+// Builds a scratch table with the host database layout, checks that the
+// fingerprint lookup agrees with a full element scan across inserts and
+// deletes, and prints the time taken by each.
+//
+REGRESSION_TEST(HostDB_lookup) (RegressionTest * t, int atype, int *pstatus)
+{
+  NOWARN_UNUSED(atype);
+  *pstatus = REGRESSION_TEST_PASSED;
+
+  const int n_elements = 250000;
+  const int n_keys = 2 * n_elements;    // every other key misses
+  const int passes = 4;
+  char dir[PATH_NAME_MAX + 1];
+  char filename[] = "hostdb_regression.db";
+  char path[PATH_NAME_MAX + 1];
+  Store store;
+  Span *span = NEW(new Span);
+
+  ink_strlcpy(dir, system_runtime_dir, sizeof(dir));
+  snprintf(path, sizeof(path), "%s/%s", dir, filename);
+  if (span->init(dir, 128 * 1024 * 1024)) {
+    rprintf(t, "unable to use '%s' for the scratch table\n", dir);
+    delete span;
+    *pstatus = REGRESSION_TEST_FAILED;
+    return;
+  }
+  store.add(span);
+
+  HostDBCache *mc = NEW(new HostDBCache);
+  ink_hrtime start = ink_get_hrtime_internal();
+  int mapped = -1;
+  if (mc->initialize(&store, filename, n_elements) > 0)
+    mapped = mc->mmap_data(false, false, true);
+  if (mapped < 0) {
+    rprintf(t, "unable to map '%s'\n", path);
+    delete mc;
+    unlink(path);
+    *pstatus = REGRESSION_TEST_FAILED;
+    return;
+  }
+  if (mapped)
+    mc->clear_header();
+  else
+    mc->clear();
+  ink_hrtime opened = ink_get_hrtime_internal() - start;
+  start = ink_get_hrtime_internal();
+  mc->clear();
+  ink_hrtime cleared = ink_get_hrtime_internal() - start;
+
+  uint64_t *keys = (uint64_t *)ats_malloc(n_keys * sizeof(uint64_t));
+  for (int i = 0; i < n_keys; i++)
+    keys[i] = hostdb_regression_key(i);
+  for (int i = 0; i < n_elements; i++) {
+    HostDBInfo *r = mc->insert_block(keys[i], NULL, 0);
+    r->md5_high = i;
+  }
+
+  int level = mc->levels - 1;
+  int found_scan = 0, found_lines = 0;
+  start = ink_get_hrtime_internal();
+  for (int p = 0; p < passes; p++)
+    for (int i = 0; i < n_keys; i++)
+      if (mc->scan_block(keys[i], level))
+        found_scan++;
+  ink_hrtime scanned = ink_get_hrtime_internal() - start;
+
+  start = ink_get_hrtime_internal();
+  for (int p = 0; p < passes; p++)
+    for (int i = 0; i < n_keys; i++)
+      if (mc->lookup_block(keys[i], level))
+        found_lines++;
+  ink_hrtime looked_up = ink_get_hrtime_internal() - start;
+
+  if (found_scan != found_lines) {
+    rprintf(t, "element scan found %d, fingerprint lines found %d\n", found_scan, found_lines);
+    *pstatus = REGRESSION_TEST_FAILED;
+  }
+
+  for (int i = 0; i < n_elements; i += 3) {
+    HostDBInfo *r = mc->lookup_block(keys[i], level);
+    if (r)
+      mc->delete_block(r);
+  }
+  for (int i = 0; i < n_keys && *pstatus == REGRESSION_TEST_PASSED; i++) {
+    if (mc->scan_block(keys[i], level) != mc->lookup_block(keys[i], level)) {
+      rprintf(t, "lookups of key %d disagree after deletes\n", i);
+      *pstatus = REGRESSION_TEST_FAILED;
+    }
+  }
+
+  rprintf(t, "%d lookups over %d elements (%d found): element scan %d us, fingerprint lines %d us\n",
+          passes * n_keys, mc->totalelements, found_lines, (int)(scanned / HRTIME_USECOND),
+          (int)(looked_up / HRTIME_USECOND));
+  rprintf(t, "%d byte table opened in %d us, clearing it takes %d us\n",
+          (int)mc->totalsize, (int)(opened / HRTIME_USECOND), (int)(cleared / HRTIME_USECOND));
+
+  ats_free(keys);
+  delete mc;
+  unlink(path);
 }
+#endif
@@ -57,6 +57,8 @@ extern unsigned int hostdb_ip_stale_interval;
 extern unsigned int hostdb_ip_timeout_interval;
 extern unsigned int hostdb_ip_fail_timeout_interval;
 extern unsigned int hostdb_serve_stale_but_revalidate;
+extern unsigned int hostdb_refresh_ahead;
+extern unsigned int hostdb_refresh_ahead_hits;
 
 
 //
@@ -210,6 +212,17 @@ struct HostDBInfo
     return false;
   }
 
+  /// Popular enough and close enough to its TTL to be refreshed now.
+  bool is_ip_refresh_ahead() {
+    if (hostdb_refresh_ahead <= 0 || hits < hostdb_refresh_ahead_hits)
+      return false;
+
+    unsigned int window = ip_timeout_interval / 2;
+    if (window > hostdb_refresh_ahead)
+      window = hostdb_refresh_ahead;
+    return ip_interval() + window >= ip_timeout_interval;
+  }
+
 
   /**
     These are the only fields which will be inserted into the
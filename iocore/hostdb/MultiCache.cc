@@ -70,7 +70,8 @@ store_verify(Store *store)
 MultiCacheHeader::MultiCacheHeader()
   : magic(MULTI_CACHE_MAGIC_NUMBER), levels(0),
     tag_bits(0), max_hits(0), elementsize(0),
-    buckets(0), totalelements(0), totalsize(0), nominal_elements(0), heap_size(0), heap_halfspace(0)
+    buckets(0), tag_stride(0), tag_offset(0), totalelements(0), totalsize(0), nominal_elements(0), heap_size(0),
+    heap_halfspace(0)
 {
   memset(level_offset, 0, sizeof(level_offset));
   memset(bucketsize, 0, sizeof(bucketsize));
@@ -188,6 +189,16 @@ MultiCacheBase::initialize(Store *astore, char *afilename,
 
   unsigned int blocks = (size + (STORE_BLOCK_SIZE - 1)) / STORE_BLOCK_SIZE;
 
+  //
+  //  Fingerprint lines follow the levels
+  //
+  int slots = 0;
+  for (int l = 0; l < levels; l++)
+    slots += elements[l];
+  tag_stride = INK_ALIGN(slots, MULTI_CACHE_TAG_LINE_SIZE);
+  tag_offset = blocks * STORE_BLOCK_SIZE;
+  blocks += bytes_to_blocks(tag_lines_size());
+
   heap_size = int ((float)totalelements * estimated_heap_bytes_per_entry());
   blocks += bytes_to_blocks(heap_size);
 
@@ -339,7 +350,7 @@ _zorch_file(void *arg)
 }
 
 static int
-zorch_file(char *path, int fd, int64_t size, int val)
+zorch_file(char *path, int fd, int64_t size, int val, bool discard)
 {
   struct stat stat;
   int64_t fsize;
@@ -354,10 +365,25 @@ zorch_file(char *path, int fd, int64_t size, int val)
     Note("file '%s' size changed from %0.2fMB to %0.2fMB", path, fsize / (1024.0 * 1024.0), size / (1024.0 * 1024.0));
   }
 
+  // dropping the old blocks is much cheaper than zeroing them
+  if (discard && fsize) {
+    if (ftruncate(fd, 0) < 0) {
+      return -1;
+    }
+    fsize = 0;
+  }
+
   if (ftruncate(fd, size) < 0) {
     return -1;
   }
 
+#if TS_HAS_POSIX_FALLOCATE
+  // reserve the blocks without writing them, the extension reads as zero
+  if (fsize < size && !val && !posix_fallocate(fd, fsize, size - fsize)) {
+    return 0;
+  }
+#endif
+
   if (fsize < size) {
     zorch_info *info;
 
@@ -376,11 +402,12 @@ zorch_file(char *path, int fd, int64_t size, int val)
 }
 
 int
-MultiCacheBase::mmap_data(bool private_flag, bool zero_fill)
+MultiCacheBase::mmap_data(bool private_flag, bool zero_fill, bool discard)
 {
   int fds[MULTI_CACHE_MAX_FILES] = { 0 };
   int n_fds = 0;
   int i = 0;
+  bool zeroed = discard;
 
   // open files
   //
@@ -405,12 +432,13 @@ MultiCacheBase::mmap_data(bool private_flag, bool zero_fill)
         fds[n_fds] = 0;
       }
       if (!d->file_pathname) {
-        if (zorch_file(path, fds[n_fds], (int64_t) d->blocks * (int64_t) STORE_BLOCK_SIZE, 0)) {
+        if (zorch_file(path, fds[n_fds], (int64_t) d->blocks * (int64_t) STORE_BLOCK_SIZE, 0, discard)) {
           Warning("unable to set file '%s' size to %" PRId64 ": %d, %s",
                   path, (int64_t) d->blocks * STORE_BLOCK_SIZE, errno, strerror(errno));
           goto Lalloc;
         }
-      }
+      } else
+        zeroed = false;
       n_fds++;
     }
   }
@@ -485,6 +513,12 @@ MultiCacheBase::mmap_data(bool private_flag, bool zero_fill)
       store = saved;
       goto Labort;
     }
+    ink_assert(cur == data + tag_offset);
+    cur = mmap_region(bytes_to_blocks(tag_lines_size()), fds, cur, private_flag, fd);
+    if (!cur) {
+      store = saved;
+      goto Labort;
+    }
 
     if (heap_size) {
       heap = cur;
@@ -509,7 +543,7 @@ MultiCacheBase::mmap_data(bool private_flag, bool zero_fill)
   for (i = 0; i < n_fds; i++)
     if (fds[i] >= 0)
       ink_assert(!socketManager.close(fds[i]));
-  return 0;
+  return zeroed ? 1 : 0;
 Lalloc:
   {
     if (data)
@@ -517,11 +551,7 @@ Lalloc:
     char *cur = 0;
 
     data = (char *)ats_memalign(sysconf(_SC_PAGESIZE), totalsize);
-    cur = data + STORE_BLOCK_SIZE * blocks_in_level(0);
-    if (levels > 1)
-      cur = data + STORE_BLOCK_SIZE * blocks_in_level(1);
-    if (levels > 2)
-      cur = data + STORE_BLOCK_SIZE * blocks_in_level(2);
+    cur = data + tag_offset + STORE_BLOCK_SIZE * bytes_to_blocks(tag_lines_size());
     if (heap_size) {
       heap = cur;
       cur += bytes_to_blocks(heap_size) * STORE_BLOCK_SIZE;
@@ -543,16 +573,23 @@ void
 MultiCacheBase::clear()
 {
   memset(data, 0, totalsize);
-  heap_used[0] = 8;
-  heap_used[1] = 8;
-  heap_halfspace = 0;
-  *mapped_header = *(MultiCacheHeader *) this;
+  clear_header();
 }
 
 void
 MultiCacheBase::clear_but_heap()
 {
   memset(data, 0, totalelements * elementsize);
+  memset(tag_line(0), 0, tag_lines_size());
+  *mapped_header = *(MultiCacheHeader *) this;
+}
+
+void
+MultiCacheBase::clear_header()
+{
+  heap_used[0] = 8;
+  heap_used[1] = 8;
+  heap_halfspace = 0;
   *mapped_header = *(MultiCacheHeader *) this;
 }
 
@@ -647,9 +684,13 @@ MultiCacheBase::open(Store *s, const char *config_filename, char *db_filename, i
       if (initialize(s, db_filename, db_size) <= 0)
         goto LfailInit;
       write_config(config_filename, db_size, buckets);
-      if (mmap_data() < 0)
+      int mapped = mmap_data(false, false, true);
+      if (mapped < 0)
         goto LfailMap;
-      clear();
+      if (mapped)
+        clear_header();
+      else
+        clear();
     } else {
 
       // don't know how to rebuild from this problem
@@ -829,6 +870,8 @@ MultiCacheBase::verify_header()
     mapped_header->bucketsize[0] == bucketsize[0] &&
     mapped_header->bucketsize[1] == bucketsize[1] &&
     mapped_header->bucketsize[2] == bucketsize[2] &&
+    mapped_header->tag_stride == tag_stride &&
+    mapped_header->tag_offset == tag_offset &&
     mapped_header->totalelements == totalelements &&
     mapped_header->totalsize == totalsize && mapped_header->nominal_elements == nominal_elements;
 }
@@ -997,8 +1040,7 @@ MultiCacheBase::sync_heap(int part)
 {
   if (heap_size) {
     int b_per_part = heap_size / MULTI_CACHE_PARTITIONS;
-    if (safe_msync(data + level_offset[2] + buckets * bucketsize[2] +
-                   b_per_part * part, b_per_part, data + totalsize, MS_SYNC) < 0)
+    if (safe_msync(heap + b_per_part * part, b_per_part, data + totalsize, MS_SYNC) < 0)
       return -1;
   }
   return 0;
@@ -1017,6 +1059,9 @@ MultiCacheBase::sync_partition(int partition)
   int res = 0;
   int b = first_bucket_of_partition(partition);
   int n = buckets_of_partition(partition);
+  // fingerprints first, a stale one on disk may only cause an extra probe
+  if (safe_msync((char *) tag_line(b), n * tag_stride, data + totalsize, MS_SYNC) < 0)
+    res = -1;
   // L3
   if (levels > 2) {
     if (safe_msync(data + level_offset[2] + b * bucketsize[2], n * bucketsize[2], data + totalsize, MS_SYNC) < 0)
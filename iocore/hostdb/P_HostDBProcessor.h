@@ -62,7 +62,7 @@ inline unsigned int HOSTDB_CLIENT_IP_HASH(
 
 // Bump this any time hostdb format is changed
 #define HOST_DB_CACHE_MAJOR_VERSION         2
-#define HOST_DB_CACHE_MINOR_VERSION         1
+#define HOST_DB_CACHE_MINOR_VERSION         2
 // 2.1 : IPv6
 
 #define DEFAULT_HOST_DB_FILENAME             "host.db"
@@ -109,6 +109,9 @@ enum HostDB_Stats
   hostdb_ttl_expires_stat,      // D == TTL Expires
   hostdb_re_dns_on_reload_stat,
   hostdb_bytes_stat,
+  hostdb_total_refreshes_stat,  // background refreshes started
+  hostdb_expired_lookups_stat,  // lookups finding a record past its TTL
+  hostdb_negative_hits_stat,
   HostDB_Stat_Count
 };
 
@@ -162,6 +165,15 @@ struct HostDBCache: public MultiCache<HostDBInfo>
 
   Queue<HostDBContinuation, Continuation::Link_link> pending_dns[MULTI_CACHE_PARTITIONS];
   Queue<HostDBContinuation, Continuation::Link_link> &pending_dns_for_hash(INK_MD5 & md5);
+
+  // Failed lookups, when kept out of the main table (hostdb.negative_size).
+  // Each partition has its own direct mapped slots, guarded by the
+  // partition lock like the buckets.
+  HostDBInfo *negative[MULTI_CACHE_PARTITIONS];
+  int negative_per_partition;
+  void alloc_negative(int size);
+  HostDBInfo *negative_slot(uint64_t folded_md5);
+
   HostDBCache();
 };
 
@@ -349,6 +361,7 @@ struct HostDBContinuation: public Continuation
   ClusterMachine *master_machine(ClusterConfiguration * cc);
 
   HostDBInfo *insert(unsigned int attl);
+  HostDBInfo *insert_negative(unsigned int attl);
 
   void init(const char *hostname, int len, sockaddr const* ip, INK_MD5 & amd5,
             Continuation * cont, void *pDS = 0, bool is_srv = false, int timeout = 0);
@@ -390,6 +403,7 @@ extern unsigned int hostdb_ip_stale_interval;
 extern unsigned int hostdb_ip_timeout_interval;
 extern unsigned int hostdb_ip_fail_timeout_interval;
 extern int hostdb_size;
+extern int hostdb_negative_size;
 extern char hostdb_filename[PATH_NAME_MAX + 1];
 
 //extern int hostdb_timestamp;
@@ -419,6 +433,13 @@ HostDBCache::pending_dns_for_hash(INK_MD5 & md5)
   return pending_dns[partition_of_bucket((int) (fold_md5(md5) % hostDB.buckets))];
 }
 
+inline HostDBInfo *
+HostDBCache::negative_slot(uint64_t folded_md5)
+{
+  int bucket = (int) (folded_md5 % buckets);
+  return &negative[partition_of_bucket(bucket)][(folded_md5 / buckets) % negative_per_partition];
+}
+
 inline int
 HostDBContinuation::key_partition()
 {
@@ -55,7 +55,7 @@
 // Update these if there is a change to MultiCacheBase
 // There is a separate HOST_DB_CACHE_[MAJOR|MINOR]_VERSION
 #define MULTI_CACHE_MAJOR_VERSION    2
-#define MULTI_CACHE_MINOR_VERSION    1
+#define MULTI_CACHE_MINOR_VERSION    2
 // 2.1 - IPv6 compatible
 
 #define MULTI_CACHE_HEAP_HIGH_WATER  0.8
@@ -63,6 +63,9 @@
 #define MULTI_CACHE_HEAP_INITIAL     sizeof(uint32_t)
 #define MULTI_CACHE_HEAP_ALIGNMENT   8
 
+// fingerprint lines are padded to whole cache lines
+#define MULTI_CACHE_TAG_LINE_SIZE    64
+
 // unused.. possible optimization
 #define MULTI_CACHE_OFFSET_PARITION(_x)  ((_x)%MULTI_CACHE_PARTITIONS)
 #define MULTI_CACHE_OFFSET_INDEX(_x)     ((_x)/MULTI_CACHE_PARTITIONS)
@@ -132,6 +135,10 @@ struct MultiCacheHeader
   int elements[MULTI_CACHE_MAX_LEVELS];
   int bucketsize[MULTI_CACHE_MAX_LEVELS];
 
+  // one fingerprint byte per element of a bucket, see tag_line()
+  int tag_stride;
+  int tag_offset;
+
   int totalelements;
   unsigned int totalsize;
 
@@ -222,6 +229,30 @@ struct MultiCacheBase: public MultiCacheHeader
   int hit_stat[MULTI_CACHE_MAX_LEVELS];
   int miss_stat;
 
+  // Each bucket has a line of one byte fingerprints, one per element
+  // slot with level 0 first.  A lookup reads the line and only touches
+  // the elements whose fingerprint matches.  Empty slots are 0.
+  //
+  unsigned char *tag_line(int bucket)
+  {
+    return (unsigned char *) data + tag_offset + (int64_t) bucket * tag_stride;
+  }
+  int64_t tag_lines_size()
+  {
+    return (int64_t) buckets * tag_stride;
+  }
+  int tag_slot(int level, int index)
+  {
+    for (int l = 0; l < level; l++)
+      index += elements[l];
+    return index;
+  }
+  static unsigned char tag_fingerprint(uint64_t tag)
+  {
+    unsigned char f = (unsigned char) ((tag * 0x9E3779B97F4A7C15ULL) >> 56);
+    return f ? f : 1;
+  }
+
   int lowest_level_data_size()
   {
     return (buckets + 3) / 4;
@@ -269,7 +300,8 @@ struct MultiCacheBase: public MultiCacheHeader
                  int buckets = 0, int levels = 2,
                  int level0_elements_per_bucket = 4,
                  int level1_elements_per_bucket = 32, int level2_elements_per_bucket = 0);
-  int mmap_data(bool private_flag = false, bool zero_fill = false);
+  // returns 1 if discard left the whole mapping zero filled
+  int mmap_data(bool private_flag = false, bool zero_fill = false, bool discard = false);
   char *mmap_region(int blocks, int *fds, char *cur, bool private_flag, int zero_fill = 0);
   int blocks_in_level(int level);
 
@@ -279,6 +311,7 @@ struct MultiCacheBase: public MultiCacheHeader
   void reset();
   void clear();                 // this zeros the data
   void clear_but_heap();
+  void clear_header();          // resets the heap, for already zero data
 
   virtual MultiCacheBase *dup()
   {
@@ -443,6 +476,7 @@ template<class C> struct MultiCache: public MultiCacheBase
   void flush(C * b, int bucket, int level);
   void delete_block(C * block);
   C *lookup_block(uint64_t folded_md5, int level);
+  C *scan_block(uint64_t folded_md5, int level);
   void copy_heap(int paritition, MultiCacheHeapGC *);
 };
 
@@ -534,6 +568,7 @@ Lfound:
     block->reset();
   block->set_full(folded_md5, buckets);
   ink_assert(block->tag() == tag);
+  tag_line(bucket)[tag_slot(level, block - b)] = tag_fingerprint(tag);
   return block;
 }
 
@@ -574,23 +609,62 @@ template<class C> inline bool MultiCache<C>::match(uint64_t folded_md5, C * bloc
 //
 template<class C> inline void MultiCache<C>::delete_block(C * b)
 {
+  int l = level_of_block(b);
+  int bucket = (((char *) b - data) - level_offset[l]) / bucketsize[l];
   if (b->backed) {
-    int l = level_of_block(b);
     if (l < levels - 1) {
-      int bucket = (((char *) b - data) - level_offset[l]) / bucketsize[l];
       C *x = (C *) (data + level_offset[l + 1] + bucket * bucketsize[l + 1]);
       for (C * y = x; y < x + elements[l + 1]; y++)
         if (b->tag() == y->tag())
           delete_block(y);
     }
   }
+  C *first = (C *) (data + level_offset[l] + bucket * bucketsize[l]);
+  tag_line(bucket)[tag_slot(l, b - first)] = 0;
   b->set_empty();
 }
 
 //
 // Lookup an entry up to some level in the cache
 //
+// The fingerprint line is compared eight bytes at a time.  The zero byte
+// test can flag a byte after a real match, so flagged words are rechecked
+// a byte at a time, and every candidate is confirmed against the full tag.
+//
 template<class C> inline C * MultiCache<C>::lookup_block(uint64_t folded_md5, int level)
+{
+  int bucket = (int) (folded_md5 % buckets);
+  uint64_t tag = make_tag(folded_md5);
+  unsigned char fp = tag_fingerprint(tag);
+  unsigned char *line = tag_line(bucket);
+  uint64_t pattern = fp * 0x0101010101010101ULL;
+  int n = 0;
+
+  for (int l = 0; l <= level && l < levels; l++)
+    n += elements[l];
+  for (int w = 0; w < n; w += 8) {
+    uint64_t x = *(uint64_t *) (line + w) ^ pattern;
+    if (!((x - 0x0101010101010101ULL) & ~x & 0x8080808080808080ULL))
+      continue;
+    for (int i = w; i < w + 8 && i < n; i++) {
+      if (line[i] == fp) {
+        int l = 0, e = i;
+        while (e >= elements[l])
+          e -= elements[l++];
+        C *b = (C *) (data + level_offset[l] + bucket * bucketsize[l]) + e;
+        if (tag == b->tag())
+          return b;
+      }
+    }
+  }
+  return NULL;
+}
+
+//
+// Lookup by reading every element of the bucket, without the fingerprint
+// line.  This is the reference the fingerprint lookup is checked against.
+//
+template<class C> inline C * MultiCache<C>::scan_block(uint64_t folded_md5, int level)
 {
   C *b = cache_bucket(folded_md5, 0);
   uint64_t tag = make_tag(folded_md5);
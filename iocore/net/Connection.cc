@@ -43,6 +43,11 @@
 
 #define ROUNDUP(x, y) ((((x)+((y)-1))/(y))*(y))
 
+// Sockets created by Server::reserve_reuseport_sockets(), by family.
+static ink_mutex reuseport_lock = INK_MUTEX_INIT;
+static Vec<int> reuseport_fds4;
+static Vec<int> reuseport_fds6;
+
 int
 get_listen_backlog(void)
 {
@@ -262,6 +267,24 @@ Lerror:
 }
 
 
+void
+Server::reserve_reuseport_sockets(int family, int n)
+{
+  Vec<int> &fds = (AF_INET6 == family) ? reuseport_fds6 : reuseport_fds4;
+
+  ink_mutex_acquire(&reuseport_lock);
+  for (int i = 0; i < n; i++) {
+    int res = socketManager.socket(family, SOCK_STREAM, IPPROTO_TCP);
+    if (res < 0) {
+      Warning("unable to reserve per thread listen sockets: %d, %s", res, strerror(-res));
+      break;
+    }
+    fds.push_back(res);
+  }
+  ink_mutex_release(&reuseport_lock);
+}
+
+
 int
 Server::listen(bool non_blocking, int recv_bufsize, int send_bufsize, bool transparent)
 {
@@ -275,7 +298,16 @@ Server::listen(bool non_blocking, int recv_bufsize, int send_bufsize, bool trans
     ats_ip_copy(&addr, &accept_addr);
   }
 
-  res = socketManager.socket(addr.sa.sa_family, SOCK_STREAM, IPPROTO_TCP);
+  res = NO_FD;
+  if (f_reuseport) {
+    Vec<int> &fds = (AF_INET6 == addr.sa.sa_family) ? reuseport_fds6 : reuseport_fds4;
+    ink_mutex_acquire(&reuseport_lock);
+    if (fds.length())
+      res = fds.pop();
+    ink_mutex_release(&reuseport_lock);
+  }
+  if (res == NO_FD)
+    res = socketManager.socket(addr.sa.sa_family, SOCK_STREAM, IPPROTO_TCP);
 
   if (res < 0)
     return res;
@@ -346,6 +378,11 @@ Server::listen(bool non_blocking, int recv_bufsize, int send_bufsize, bool trans
   if ((res = safe_setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, SOCKOPT_ON, sizeof(int))) < 0)
     goto Lerror;
 
+#ifdef SO_REUSEPORT
+  if (f_reuseport && (res = safe_setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, SOCKOPT_ON, sizeof(int))) < 0)
+    goto Lerror;
+#endif
+
   if ((res = socketManager.ink_bind(fd, &addr.sa, ats_ip_size(&addr.sa), IPPROTO_TCP)) < 0) {
     goto Lerror;
   }
@@ -470,6 +470,11 @@ public:
   /** Set remote sock addr struct. */
   virtual void set_remote_addr() = 0;
 
+  /** Test if the write side can send blocks whose IOBufferData
+      refers to a file (IOBufferData::_fd) straight from that file.
+  */
+  virtual bool is_zero_copy_capable() { return false; }
+
   // for InkAPI
   bool get_is_internal_request() const {
     return is_internal_request;
@@ -210,6 +210,17 @@ struct Server: public Connection
   /// If set, a kernel HTTP accept filter
   bool http_accept_filter;
 
+  /// If set, the listen socket is opened with SO_REUSEPORT so that
+  /// several sockets (one per net thread) can share the port.
+  bool f_reuseport;
+
+  /** Create @a n sockets of @a family for later listen() calls with
+      f_reuseport to take. Linux only lets sockets created by the same
+      user share a port, so to join the port the manager opened these
+      must be created before the process changes its user.
+  */
+  static void reserve_reuseport_sockets(int family, int n);
+
   //
   // Use this call for the main proxy accept
   //
@@ -234,6 +245,7 @@ struct Server: public Connection
   Server()
     : Connection()
     , f_inbound_transparent(false)
+    , f_reuseport(false)
   {
     ink_zero(accept_addr);
   }
@@ -113,6 +113,8 @@ struct NetAccept:public Continuation
   virtual void init_accept_per_thread();
   // 0 == success
   int do_listen(bool non_blocking, bool transparent = false);
+  int do_listen_per_thread();
+  void set_listen_sockopts();
 
   int do_blocking_accept(EThread * t);
   virtual int acceptEvent(int event, void *e);
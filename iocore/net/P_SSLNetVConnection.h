@@ -90,6 +90,7 @@ public:
   int sslClientHandShakeEvent(int &err);
   virtual void net_read_io(NetHandler * nh, EThread * lthread);
   virtual int64_t load_buffer_and_write(int64_t towrite, int64_t &wattempted, int64_t &total_wrote, MIOBufferAccessor & buf);
+  virtual bool is_zero_copy_capable() { return false; }
 
   void registerNextProtocolSet(const SSLNextProtocolSet *);
 
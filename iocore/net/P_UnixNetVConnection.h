@@ -247,6 +247,7 @@ public:
   virtual void set_remote_addr();
   virtual int set_tcp_init_cwnd(int init_cwnd);
   virtual void apply_options();
+  virtual bool is_zero_copy_capable();
 };
 
 extern ClassAllocator<UnixNetVConnection> netVCAllocator;
@@ -384,6 +385,15 @@ UnixNetVConnection::get_socket() {
   return con.fd;
 }
 
+TS_INLINE bool
+UnixNetVConnection::is_zero_copy_capable() {
+#if TS_HAVE_SYS_SENDFILE_H
+  return true;
+#else
+  return false;
+#endif
+}
+
 // declarations for local use (within the net module)
 
 void close_UnixNetVConnection(UnixNetVConnection * vc, EThread * t);
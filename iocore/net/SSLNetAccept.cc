@@ -68,17 +68,20 @@ SSLNetAccept::init_accept_per_thread()
     SET_HANDLER((SSLNetAcceptHandler) & SSLNetAccept::acceptEvent);
   period = ACCEPT_PERIOD;
   NetAccept *a = this;
+  bool per_thread_socket = server.f_reuseport;
   n = eventProcessor.n_threads_for_type[SSLNetProcessor::ET_SSL];
   for (i = 0; i < n; i++) {
     if (i < n - 1) {
       a = NEW(new SSLNetAccept);
       *a = *this;
+      if (per_thread_socket && a->do_listen_per_thread())
+        per_thread_socket = false;
     } else
       a = this;
     EThread *t = eventProcessor.eventthread[SSLNetProcessor::ET_SSL][i];
 
     PollDescriptor *pd = get_PollDescriptor(t);
-    if (ep.start(pd, this, EVENTIO_READ) < 0)
+    if (a->ep.start(pd, a, EVENTIO_READ) < 0)
       Debug("iocore_net", "error starting EventIO");
     a->mutex = get_NetHandler(t)->mutex;
     t->schedule_every(a, period, etype);
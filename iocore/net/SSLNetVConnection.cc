@@ -348,6 +348,12 @@ SSLNetVConnection::load_buffer_and_write(int64_t towrite, int64_t &wattempted, i
       break;
     wattempted = l;
     total_wrote += l;
+    // blocks sent from a file are never handed to SSL, but copy one
+    // rather than read past its memory if it is
+    if (unlikely(b->data->file_backed()))
+      b->load_file();
+    if (unlikely(b->data->_lost))
+      return -EIO;
     Debug("ssl", "SSLNetVConnection::loadBufferAndCallWrite, before do_SSL_write, l=%" PRId64", towrite=%" PRId64", b=%p",
           l, towrite, b);
     r = do_SSL_write(ssl, b->start() + offset, (int)l);
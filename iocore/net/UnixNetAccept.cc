@@ -218,11 +218,14 @@ NetAccept::init_accept_per_thread()
   period = ACCEPT_PERIOD;
 
   NetAccept *a;
+  bool per_thread_socket = server.f_reuseport;
   n = eventProcessor.n_threads_for_type[ET_NET];
   for (i = 0; i < n; i++) {
     if (i < n - 1) {
       a = NEW(new NetAccept);
       *a = *this;
+      if (per_thread_socket && a->do_listen_per_thread())
+        per_thread_socket = false;
     } else
       a = this;
     EThread *t = eventProcessor.eventthread[ET_NET][i];
@@ -262,6 +265,60 @@ NetAccept::do_listen(bool non_blocking, bool transparent)
 }
 
 
+//
+// Options set on each listen socket once it is open, whether shared or
+// per thread.
+//
+void
+NetAccept::set_listen_sockopts()
+{
+#ifdef TCP_DEFER_ACCEPT
+  // set tcp defer accept timeout if it is configured, this will not trigger an accept until there is
+  // data on the socket ready to be read
+  int should_filter_int = 0;
+  IOCORE_ReadConfigInteger(should_filter_int, "proxy.config.net.defer_accept");
+  if (should_filter_int > 0) {
+    setsockopt(server.fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &should_filter_int, sizeof(int));
+  }
+#endif
+#ifdef TCP_INIT_CWND
+  int tcp_init_cwnd = 0;
+  IOCORE_ReadConfigInteger(tcp_init_cwnd, "proxy.config.http.server_tcp_init_cwnd");
+  if (tcp_init_cwnd > 0) {
+    Debug("net", "Setting initial congestion window to %d", tcp_init_cwnd);
+    if (setsockopt(server.fd, IPPROTO_TCP, TCP_INIT_CWND, &tcp_init_cwnd, sizeof(int)) != 0) {
+      Error("Cannot set initial congestion window to %d", tcp_init_cwnd);
+    }
+  }
+#endif
+}
+
+
+//
+// Replace the shared listen socket of a per-thread copy with a private
+// SO_REUSEPORT socket bound to the same address, so the kernel spreads
+// incoming connections over the net threads. On failure the copy keeps
+// polling the shared socket.
+//
+int
+NetAccept::do_listen_per_thread()
+{
+  int res = 0;
+  int shared_fd = server.fd;
+
+  server.fd = NO_FD;
+  if ((res = server.listen(NON_BLOCKING, recv_bufsize, send_bufsize, server.f_inbound_transparent))) {
+    Warning("unable to open per thread listen socket on port %d, using the shared socket: %d, %s",
+            ntohs(server.accept_addr.port()), res, strerror(-res));
+    server.fd = shared_fd;
+    return res;
+  }
+  set_listen_sockopts();
+  Debug("iocore_net_accept", "Opened per thread listen socket %d for port %d", server.fd, ntohs(server.accept_addr.port()));
+  return 0;
+}
+
+
 int
 NetAccept::do_blocking_accept(EThread * t)
 {
@@ -96,6 +96,7 @@ UnixNetProcessor::accept_internal(
   EThread *thread = this_ethread();
   ProxyMutex *mutex = thread->mutex;
   int accept_threads = opt.accept_threads; // might be changed.
+  int listen_per_thread = 0;
   IpEndpoint accept_ip; // local binding address.
 
   // Potentially upgrade to SSL.
@@ -105,6 +106,15 @@ UnixNetProcessor::accept_internal(
   if (opt.accept_threads < 0)
     IOCORE_ReadConfigInteger(accept_threads, "proxy.config.accept_threads");
 
+  // Per thread SO_REUSEPORT listen sockets replace the accept threads.
+  IOCORE_ReadConfigInteger(listen_per_thread, "proxy.config.net.listen_per_thread");
+#ifndef SO_REUSEPORT
+  if (listen_per_thread) {
+    Warning("proxy.config.net.listen_per_thread requires SO_REUSEPORT, which this platform does not support");
+    listen_per_thread = 0;
+  }
+#endif
+
   NET_INCREMENT_DYN_STAT(net_accepts_currently_open_stat);
 
   // We've handled the config stuff at start up, but there are a few cases
@@ -149,7 +159,10 @@ UnixNetProcessor::accept_internal(
   if (na->callback_on_open)
     na->mutex = cont->mutex;
   if (opt.frequent_accept) { // true
-    if (accept_threads > 0)  {
+    if (listen_per_thread) {
+      na->server.f_reuseport = true;
+      na->init_accept_per_thread();
+    } else if (accept_threads > 0)  {
       if (0 == na->do_listen(BLOCKING, opt.f_inbound_transparent)) {
         NetAccept *a;
 
@@ -169,23 +182,8 @@ UnixNetProcessor::accept_internal(
   } else
     na->init_accept();
 
-#ifdef TCP_DEFER_ACCEPT
-  // set tcp defer accept timeout if it is configured, this will not trigger an accept until there is
-  // data on the socket ready to be read
-  if (should_filter_int > 0) {
-    setsockopt(na->server.fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &should_filter_int, sizeof(int));
-  }
-#endif
-#ifdef TCP_INIT_CWND
- int tcp_init_cwnd = 0;
- IOCORE_ReadConfigInteger(tcp_init_cwnd, "proxy.config.http.server_tcp_init_cwnd");
- if(tcp_init_cwnd > 0) {
-    Debug("net", "Setting initial congestion window to %d", tcp_init_cwnd);
-    if(setsockopt(na->server.fd, IPPROTO_TCP, TCP_INIT_CWND, &tcp_init_cwnd, sizeof(int)) != 0) {
-      Error("Cannot set initial congestion window to %d", tcp_init_cwnd);
-    }
- }
-#endif
+  // the per thread listen sockets have theirs set as they are opened
+  na->set_listen_sockopts();
   return na->action_;
 }
 
@@ -37,6 +37,7 @@ typedef struct iovec IOVec;
 #else
 #define NET_MAX_IOV UIO_MAXIOV
 #endif
+#define NET_FILE_BLOCK_COPY_SIZE 32768  // chunk for file blocks close to reuse
 
 // Global
 ClassAllocator<UnixNetVConnection> netVCAllocator("netVCAllocator");
@@ -820,6 +821,37 @@ UnixNetVConnection::net_read_io(NetHandler *nh, EThread *lthread)
   read_from_net(nh, this, lthread);
 }
 
+// Sends up to len bytes of a block backed by a file. The owner of the
+// file may reuse the range while the block waits for a slow client, so
+// it is checked around each send: close to reuse the bytes are copied
+// through memory, and once reused the write fails rather than send
+// whatever replaced them. The owner has the range read into the page
+// cache before it hands the block out, but pages evicted since are read
+// on this thread, so a copy is limited to NET_FILE_BLOCK_COPY_SIZE per
+// call (a sendfile() is limited by the socket buffer).
+static int64_t
+write_file_block(int fd, IOBufferData *d, off_t offset, int64_t len)
+{
+  int64_t r;
+  int state = d->_fd_check ? d->_fd_check(d) : 1;
+  if (state < 0)
+    return -EIO;
+  if (state > 0)
+    r = socketManager.sendfile(fd, d->_fd, offset, len);
+  else {
+    char tmp[NET_FILE_BLOCK_COPY_SIZE];
+    int64_t n = len < (int64_t)sizeof(tmp) ? len : (int64_t)sizeof(tmp);
+    if ((r = socketManager.pread(d->_fd, tmp, (int)n, offset)) <= 0)
+      return r ? r : -EIO;
+    if (d->_fd_check(d) < 0)
+      return -EIO;
+    r = socketManager.write(fd, tmp, r);
+  }
+  if (r > 0 && d->_fd_check && d->_fd_check(d) < 0)
+    return -EIO;
+  return r;
+}
+
 // This code was pulled out of write_to_net so
 // I could overwrite it for the SSL implementation
 // (SSL read does not support overlapped i/o)
@@ -834,6 +866,9 @@ UnixNetVConnection::load_buffer_and_write(int64_t towrite, int64_t &wattempted,
     IOVec tiovec[NET_MAX_IOV];
     int niov = 0;
     int64_t total_wrote_last = total_wrote;
+    IOBufferData *file_data = NULL;
+    off_t file_offset = 0;
+    bool lost = false;
     while (b && niov < NET_MAX_IOV) {
       // check if we have done this block
       int64_t l = b->read_avail();
@@ -849,6 +884,18 @@ UnixNetVConnection::load_buffer_and_write(int64_t towrite, int64_t &wattempted,
         l = wavail;
       if (!l)
         break;
+      // a file backed block copied too late has lost its contents
+      if (unlikely(b->data->_lost)) {
+        lost = !niov;
+        break;
+      }
+      // a block backed by a file goes out by itself with sendfile()
+      if (b->data->_fd >= 0) {
+        if (niov)
+          break;
+        file_data = b->data;
+        file_offset = file_data->_fd_offset + (b->start() + offset - file_data->data());
+      }
       total_wrote += l;
       // build an iov entry
       tiovec[niov].iov_len = l;
@@ -857,9 +904,15 @@ UnixNetVConnection::load_buffer_and_write(int64_t towrite, int64_t &wattempted,
       // on to the next block
       offset = 0;
       b = b->next;
+      if (file_data)
+        break;
     }
     wattempted = total_wrote - total_wrote_last;
-    if (niov == 1)
+    if (lost)
+      r = -EIO;
+    else if (file_data)
+      r = write_file_block(con.fd, file_data, file_offset, tiovec[0].iov_len);
+    else if (niov == 1)
       r = socketManager.write(con.fd, tiovec[0].iov_base, tiovec[0].iov_len);
     else
       r = socketManager.writev(con.fd, &tiovec[0], niov);
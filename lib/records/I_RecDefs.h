@@ -150,13 +150,28 @@ struct RecRawStat
 
 // WARNING!  It's advised that developers do not modify the contents of
 // the RecRawStatBlock.  ^_^
+// Thread local part of a raw stat.  Each thread gets its own slab of
+// these for a RecRawStatBlock the first time it updates one of its stats.
+// A slab is a table of chunks of REC_RAW_STAT_CHUNK_SIZE stats, each
+// allocated the first time the thread updates a stat in it.
+struct RecRawStatLocal
+{
+  int64_t sum;
+  int64_t count;
+};
+
+#define REC_RAW_STAT_CHUNK_SHIFT  8
+#define REC_RAW_STAT_CHUNK_SIZE   (1 << REC_RAW_STAT_CHUNK_SHIFT)
+
 struct RecRawStatBlock
 {
-  off_t ethr_stat_offset;   // thread local raw-stat storage
+  off_t ethr_stat_offset;   // thread local pointer to the thread's slab
   RecRawStat **global;      // global raw-stat storage (ptr to RecRecord)
-  int num_stats;            // number of stats in this block
+  int num_stats;            // one past the highest id registered so far
   int max_stats;            // maximum number of stats for this block
   ink_mutex mutex;
+  RecRawStatLocal *totals;  // sum of all the slabs as of the last sync pass
+  RecRawStatBlock *next;    // next block in the sync pass
 };
 
 
@@ -113,22 +113,29 @@ int64_t *RecGetGlobalRawStatCountPtr(RecRawStatBlock * rsb, int id);
 //-------------------------------------------------------------------------
 // RecIncrRawStatXXX
 //-------------------------------------------------------------------------
+RecRawStatLocal *RecAllocateRawStatChunk(RecRawStatBlock * rsb, EThread * ethread, int id);
+
 // inlined functions that are used very frequently.
 // FIXME: move it to Inline.cc
-inline RecRawStat *
+inline RecRawStatLocal *
 raw_stat_get_tlp(RecRawStatBlock * rsb, int id, EThread * ethread)
 {
   ink_debug_assert((id >= 0) && (id < rsb->max_stats));
   if (ethread == NULL) {
     ethread = this_ethread();
   }
-  return (((RecRawStat *) ((char *) (ethread) + rsb->ethr_stat_offset)) + id);
+  RecRawStatLocal **slab = *(RecRawStatLocal ***) ((char *) (ethread) + rsb->ethr_stat_offset);
+  RecRawStatLocal *chunk;
+  if (unlikely(slab == NULL || (chunk = slab[id >> REC_RAW_STAT_CHUNK_SHIFT]) == NULL)) {
+    chunk = RecAllocateRawStatChunk(rsb, ethread, id);
+  }
+  return chunk + (id & (REC_RAW_STAT_CHUNK_SIZE - 1));
 }
 
 inline int
 RecIncrRawStat(RecRawStatBlock * rsb, EThread * ethread, int id, int64_t incr)
 {
-  RecRawStat *tlp = raw_stat_get_tlp(rsb, id, ethread);
+  RecRawStatLocal *tlp = raw_stat_get_tlp(rsb, id, ethread);
   tlp->sum += incr;
   tlp->count += 1;
   return REC_ERR_OKAY;
@@ -138,7 +145,7 @@ RecIncrRawStat(RecRawStatBlock * rsb, EThread * ethread, int id, int64_t incr)
 inline int
 RecDecrRawStat(RecRawStatBlock * rsb, EThread * ethread, int id, int64_t decr)
 {
-  RecRawStat *tlp = raw_stat_get_tlp(rsb, id, ethread);
+  RecRawStatLocal *tlp = raw_stat_get_tlp(rsb, id, ethread);
   if (decr <= tlp->sum) {       // Assure that we stay positive
     tlp->sum -= decr;
     tlp->count += 1;
@@ -149,7 +156,7 @@ RecDecrRawStat(RecRawStatBlock * rsb, EThread * ethread, int id, int64_t decr)
 inline int
 RecIncrRawStatSum(RecRawStatBlock * rsb, EThread * ethread, int id, int64_t incr)
 {
-  RecRawStat *tlp = raw_stat_get_tlp(rsb, id, ethread);
+  RecRawStatLocal *tlp = raw_stat_get_tlp(rsb, id, ethread);
   tlp->sum += incr;
   return REC_ERR_OKAY;
 }
@@ -157,7 +164,7 @@ RecIncrRawStatSum(RecRawStatBlock * rsb, EThread * ethread, int id, int64_t incr
 inline int
 RecIncrRawStatCount(RecRawStatBlock * rsb, EThread * ethread, int id, int64_t incr)
 {
-  RecRawStat *tlp = raw_stat_get_tlp(rsb, id, ethread);
+  RecRawStatLocal *tlp = raw_stat_get_tlp(rsb, id, ethread);
   tlp->count += incr;
   return REC_ERR_OKAY;
 }
@@ -62,6 +62,82 @@ RecProcess_set_remote_sync_interval_ms(int ms) {
   g_rec_remote_sync_interval_ms = ms;
 }
 
+//-------------------------------------------------------------------------
+// Thread slabs
+//-------------------------------------------------------------------------
+// A thread's slab pointer lives in its EThread at ethr_stat_offset and is
+// NULL until the thread first touches the block.  The slab is a table of
+// chunk pointers, and a chunk of REC_RAW_STAT_CHUNK_SIZE stats is only
+// allocated once the thread updates one of them, so blocks sized for
+// thousands of plugin stats cost little on threads that update a few
+// and are not limited by PER_THREAD_DATA.  Chunks are never moved or
+// freed, so the sync pass can read them without locking.  They are
+// cache line aligned so that no two threads' counters ever share one.
+#define RAW_STAT_SLAB_ALIGN 64
+
+static RecRawStatBlock * volatile g_rsb_list = NULL;
+
+static inline RecRawStatLocal **
+raw_stat_get_slab(RecRawStatBlock *rsb, EThread *ethread)
+{
+  return *(RecRawStatLocal ** volatile *) ((char *) ethread + rsb->ethr_stat_offset);
+}
+
+static inline int
+raw_stat_slab_chunks(int num_stats)
+{
+  return (num_stats + REC_RAW_STAT_CHUNK_SIZE - 1) >> REC_RAW_STAT_CHUNK_SHIFT;
+}
+
+// The thread's counters for stat id, or NULL if it never updated any
+// stat in that chunk.
+static inline RecRawStatLocal *
+raw_stat_get_local(RecRawStatBlock *rsb, EThread *ethread, int id)
+{
+  RecRawStatLocal **slab = raw_stat_get_slab(rsb, ethread);
+  RecRawStatLocal *chunk;
+
+  if (slab == NULL || (chunk = ((RecRawStatLocal * volatile *) slab)[id >> REC_RAW_STAT_CHUNK_SHIFT]) == NULL)
+    return NULL;
+  return chunk + (id & (REC_RAW_STAT_CHUNK_SIZE - 1));
+}
+
+
+//-------------------------------------------------------------------------
+// raw_stat_sync_totals
+//-------------------------------------------------------------------------
+// Sums the thread slabs of a block into its totals in one pass, up to
+// the highest stat registered.  The writers are never blocked: each only
+// ever touches its own slab, and the sync thread only reads them.
+static void
+raw_stat_sync_totals(RecRawStatBlock *rsb)
+{
+  RecRawStatLocal *totals = rsb->totals;
+  RecRawStatLocal **slab, *chunk;
+  int num_stats = rsb->num_stats;
+  int chunks = raw_stat_slab_chunks(num_stats);
+  int i, c, id, n;
+
+  memset(totals, 0, num_stats * sizeof(RecRawStatLocal));
+  for (i = 0; i < eventProcessor.n_ethreads; i++) {
+    if ((slab = raw_stat_get_slab(rsb, eventProcessor.all_ethreads[i])) == NULL)
+      continue;
+    for (c = 0; c < chunks; c++) {
+      if ((chunk = ((RecRawStatLocal * volatile *) slab)[c]) == NULL)
+        continue;
+      n = num_stats - (c << REC_RAW_STAT_CHUNK_SHIFT);
+      if (n > REC_RAW_STAT_CHUNK_SIZE)
+        n = REC_RAW_STAT_CHUNK_SIZE;
+      RecRawStatLocal *t = totals + (c << REC_RAW_STAT_CHUNK_SHIFT);
+      for (id = 0; id < n; id++) {
+        t[id].sum += chunk[id].sum;
+        t[id].count += chunk[id].count;
+      }
+    }
+  }
+}
+
+
 //-------------------------------------------------------------------------
 // raw_stat_get_total
 //-------------------------------------------------------------------------
@@ -69,7 +145,7 @@ static int
 raw_stat_get_total(RecRawStatBlock *rsb, int id, RecRawStat *total)
 {
   int i;
-  RecRawStat *tlp;
+  RecRawStatLocal *tlp;
 
   total->sum = 0;
   total->count = 0;
@@ -80,7 +156,8 @@ raw_stat_get_total(RecRawStatBlock *rsb, int id, RecRawStat *total)
 
   // get thread local values
   for (i = 0; i < eventProcessor.n_ethreads; i++) {
-    tlp = ((RecRawStat *) ((char *) (eventProcessor.all_ethreads[i]) + rsb->ethr_stat_offset)) + id;
+    if ((tlp = raw_stat_get_local(rsb, eventProcessor.all_ethreads[i], id)) == NULL)
+      continue;
     total->sum += tlp->sum;
     total->count += tlp->count;
   }
@@ -95,19 +172,11 @@ raw_stat_get_total(RecRawStatBlock *rsb, int id, RecRawStat *total)
 static int
 raw_stat_sync_to_global(RecRawStatBlock *rsb, int id)
 {
-  int i;
-  RecRawStat *tlp;
   RecRawStat total;
 
-  total.sum = 0;
-  total.count = 0;
-
-  // sum the thread local values
-  for (i = 0; i < eventProcessor.n_ethreads; i++) {
-    tlp = ((RecRawStat *) ((char *) (eventProcessor.all_ethreads[i]) + rsb->ethr_stat_offset)) + id;
-    total.sum += tlp->sum;
-    total.count += tlp->count;
-  }
+  // the thread local values, as summed by the last sync pass
+  total.sum = rsb->totals[id].sum;
+  total.count = rsb->totals[id].count;
 
   // lock so the setting of the globals and last values are atomic
   ink_mutex_acquire(&(rsb->mutex));
@@ -151,10 +220,10 @@ raw_stat_clear_sum(RecRawStatBlock *rsb, int id)
   ink_mutex_release(&(rsb->mutex));
 
   // reset the local stats
-  RecRawStat *tlp;
+  RecRawStatLocal *tlp;
   for (int i = 0; i < eventProcessor.n_ethreads; i++) {
-    tlp = ((RecRawStat *) ((char *) (eventProcessor.all_ethreads[i]) + rsb->ethr_stat_offset)) + id;
-    ink_atomic_swap(&(tlp->sum), (int64_t)0);
+    if ((tlp = raw_stat_get_local(rsb, eventProcessor.all_ethreads[i], id)) != NULL)
+      ink_atomic_swap(&(tlp->sum), (int64_t)0);
   }
   return REC_ERR_OKAY;
 }
@@ -176,10 +245,10 @@ raw_stat_clear_count(RecRawStatBlock *rsb, int id)
   ink_mutex_release(&(rsb->mutex));
 
   // reset the local stats
-  RecRawStat *tlp;
+  RecRawStatLocal *tlp;
   for (int i = 0; i < eventProcessor.n_ethreads; i++) {
-    tlp = ((RecRawStat *) ((char *) (eventProcessor.all_ethreads[i]) + rsb->ethr_stat_offset)) + id;
-    ink_atomic_swap(&(tlp->count), (int64_t)0);
+    if ((tlp = raw_stat_get_local(rsb, eventProcessor.all_ethreads[i], id)) != NULL)
+      ink_atomic_swap(&(tlp->count), (int64_t)0);
   }
   return REC_ERR_OKAY;
 }
@@ -410,8 +479,8 @@ RecAllocateRawStatBlock(int num_stats)
   off_t ethr_stat_offset;
   RecRawStatBlock *rsb;
 
-  // allocate thread-local raw-stat memory
-  if ((ethr_stat_offset = eventProcessor.allocate(num_stats * sizeof(RecRawStat))) == -1) {
+  // allocate the thread-local slab pointer
+  if ((ethr_stat_offset = eventProcessor.allocate(sizeof(RecRawStatLocal **))) == -1) {
     return NULL;
   }
   // create the raw-stat-block structure
@@ -422,11 +491,55 @@ RecAllocateRawStatBlock(int num_stats)
   memset(rsb->global, 0, num_stats * sizeof(RecRawStat *));
   rsb->num_stats = 0;
   rsb->max_stats = num_stats;
+  rsb->totals = (RecRawStatLocal *)ats_malloc(num_stats * sizeof(RecRawStatLocal));
+  memset(rsb->totals, 0, num_stats * sizeof(RecRawStatLocal));
   ink_mutex_init(&(rsb->mutex),"net stat mutex");
+
+  // add it to the blocks summed by the sync pass
+  do {
+    rsb->next = g_rsb_list;
+  } while (!ink_atomic_cas(&g_rsb_list, rsb->next, rsb));
+
   return rsb;
 }
 
 
+//-------------------------------------------------------------------------
+// RecAllocateRawStatChunk
+//-------------------------------------------------------------------------
+// Returns the first counters of the chunk holding stat id in the slab of
+// ethread, allocating the slab and the chunk as needed.
+RecRawStatLocal *
+RecAllocateRawStatChunk(RecRawStatBlock *rsb, EThread *ethread, int id)
+{
+  RecRawStatLocal ** volatile *slot = (RecRawStatLocal ** volatile *) ((char *) ethread + rsb->ethr_stat_offset);
+  RecRawStatLocal **slab = *slot;
+
+  // ethread need not be the calling thread, so another thread may
+  // have installed a slab or a chunk in the meantime
+  if (slab == NULL) {
+    size_t size = raw_stat_slab_chunks(rsb->max_stats) * sizeof(RecRawStatLocal *);
+    slab = (RecRawStatLocal **)ats_malloc(size);
+    memset(slab, 0, size);
+    if (!ink_atomic_cas(slot, (RecRawStatLocal **) NULL, slab)) {
+      ats_free(slab);
+      slab = *slot;
+    }
+  }
+
+  RecRawStatLocal * volatile *chunk_slot = (RecRawStatLocal * volatile *) &slab[id >> REC_RAW_STAT_CHUNK_SHIFT];
+  if (*chunk_slot == NULL) {
+    size_t size = REC_RAW_STAT_CHUNK_SIZE * sizeof(RecRawStatLocal);
+    RecRawStatLocal *chunk = (RecRawStatLocal *)ats_memalign(RAW_STAT_SLAB_ALIGN, size);
+    memset(chunk, 0, size);
+    if (!ink_atomic_cas(chunk_slot, (RecRawStatLocal *) NULL, chunk)) {
+      ats_memalign_free(chunk);
+    }
+  }
+  return *chunk_slot;
+}
+
+
 //-------------------------------------------------------------------------
 // RecRegisterRawStat
 //-------------------------------------------------------------------------
@@ -462,6 +575,12 @@ RecRegisterRawStat(RecRawStatBlock *rsb, RecT rec_type, const char *name, RecDat
   rsb->global[id]->last_sum = 0;
   rsb->global[id]->last_count = 0;
 
+  // let the sync pass cover this stat; plugins may register concurrently
+  for (int n = rsb->num_stats; n <= id; n = rsb->num_stats) {
+    if (ink_atomic_cas(&rsb->num_stats, n, id + 1))
+      break;
+  }
+
   // setup the periodic sync callback
   RecRegisterRawStatSyncCb(name, sync_cb, rsb, id);
 
@@ -773,8 +892,13 @@ int
 RecExecRawStatSyncCbs()
 {
   RecRecord *r;
+  RecRawStatBlock *rsb;
   int i, num_records;
 
+  for (rsb = g_rsb_list; rsb != NULL; rsb = rsb->next) {
+    raw_stat_sync_totals(rsb);
+  }
+
   num_records = g_num_records;
   for (i = 0; i < num_records; i++) {
     r = &(g_records[i]);
@@ -68,6 +68,40 @@ public:
     ink_freelist_free(&this->fl, ptr);
   }
 
+  /**
+    Take a batch of blocks returned by free_void_batch(), if there is
+    one.  The blocks are linked through their first word.
+
+    @param num_item set to the number of blocks in the batch.
+  */
+  void *
+  alloc_void_batch(uint32_t *num_item)
+  {
+    return ink_freelist_new_batch(&this->fl, num_item);
+  }
+
+  /**
+    Deallocate num_item blocks, linked through their first word, in
+    one atomic operation.
+  */
+  void
+  free_void_batch(void *head, uint32_t num_item)
+  {
+    ink_freelist_free_batch(&this->fl, head, num_item);
+  }
+
+  const char *
+  name() const
+  {
+    return fl.name;
+  }
+
+  unsigned int
+  element_size() const
+  {
+    return fl.type_size;
+  }
+
   Allocator()
   {
     memset(&fl, 0, sizeof fl);
@@ -187,3 +187,43 @@ ats_mallopt(int param, int value)
 #endif // ! TS_HAS_JEMALLOC
   return 0;
 }
+
+#define HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+// Map size bytes of anonymous memory and try to get it backed by huge
+// pages. With ATS_HUGEPAGE_EXPLICIT we ask for pages from the hugetlb
+// pool first; otherwise (or when the pool is empty) we map a 2MB aligned
+// region and madvise it for transparent huge pages. *huge is set when
+// the kernel accepted either request. Returns NULL if nothing could be
+// mapped so the caller can fall back to ats_memalign.
+void *
+ats_alloc_hugepage(size_t size, int mode, int *huge)
+{
+  *huge = 0;
+  if (mode == ATS_HUGEPAGE_NONE)
+    return NULL;
+  size = INK_ALIGN(size, HUGEPAGE_SIZE);
+#ifdef MAP_HUGETLB
+  if (mode == ATS_HUGEPAGE_EXPLICIT) {
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (ptr != MAP_FAILED) {
+      *huge = 1;
+      return ptr;
+    }
+  }
+#endif
+  char *map = (char *) mmap(NULL, size + HUGEPAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (map == (char *) MAP_FAILED)
+    return NULL;
+  // trim the mapping so that it starts and ends on a huge page boundary
+  char *ptr = (char *) INK_ALIGN((uintptr_t) map, HUGEPAGE_SIZE);
+  if (ptr > map)
+    munmap(map, ptr - map);
+  if (map + HUGEPAGE_SIZE > ptr)
+    munmap(ptr + size, map + HUGEPAGE_SIZE - ptr);
+#ifdef MADV_HUGEPAGE
+  if (madvise(ptr, size, MADV_HUGEPAGE) == 0)
+    *huge = 1;
+#endif
+  return ptr;
+}
@@ -52,6 +52,12 @@ extern "C"
   void ats_memalign_free(void *ptr);
   int ats_mallopt(int param, int value);
 
+  // Huge page modes for ats_alloc_hugepage
+#define ATS_HUGEPAGE_NONE         0     // don't use huge pages
+#define ATS_HUGEPAGE_TRANSPARENT  1     // madvise(MADV_HUGEPAGE)
+#define ATS_HUGEPAGE_EXPLICIT     2     // MAP_HUGETLB, falling back to transparent
+  void *ats_alloc_hugepage(size_t size, int mode, int *huge);
+
 #define ats_strdup(p)        _xstrdup((p), -1, NULL)
 #define ats_strndup(p,n)     _xstrdup((p), n, NULL)
 
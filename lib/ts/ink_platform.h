@@ -187,6 +187,9 @@ typedef unsigned int in_addr_t;
 #ifdef HAVE_SYS_SYSTEMINFO_H
 # include <sys/systeminfo.h>
 #endif
+#if TS_HAVE_SYS_SENDFILE_H
+# include <sys/sendfile.h>
+#endif
 
 #ifdef HAVE_DLFCN_H
 # include <dlfcn.h>
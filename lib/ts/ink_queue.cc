@@ -113,6 +113,7 @@ ink_freelist_init(InkFreeList * f,
   f->allocated = 0;
   f->allocated_base = 0;
   f->count_base = 0;
+  ink_atomiclist_init(&f->batches, name, sizeof(void *));
 }
 
 InkFreeList *
@@ -132,6 +133,55 @@ int fake_global_for_ink_queue = 0;
 
 int fastmemtotal = 0;
 
+typedef volatile void *volatile_void_p;
+
+/*
+ * A batch parked by ink_freelist_free_batch() is linked through word 0
+ * of each item; the first item also carries the link on f->batches in
+ * word 1 and the length of the batch in word 2.
+ */
+#define BATCH_NEXT(_x) (*(void **)(_x))
+#define BATCH_COUNT(_x) (((uintptr_t *)(_x))[2])
+
+#if TS_USE_FREELIST
+/* push items already linked through f->offset with one CAS */
+static void
+freelist_push_chain(InkFreeList * f, void *first, void *last)
+{
+  volatile_void_p *adr_of_next = (volatile_void_p *) ADDRESS_OF_NEXT(last, f->offset);
+  head_p h;
+  head_p item_pair;
+  int result = 0;
+
+  do {
+    INK_QUEUE_LD64(h, f->head);
+    *adr_of_next = FREELIST_POINTER(h);
+    SET_FREELIST_POINTER_VERSION(item_pair, FROM_PTR(first), FREELIST_VERSION(h));
+    INK_MEMORY_BARRIER;
+    result = ink_atomic_cas((int64_t *) & f->head, h.data, item_pair.data);
+  }
+  while (result == 0);
+}
+
+/* move a parked batch onto the free list, returns 0 if there was none */
+static int
+freelist_unpark_batch(InkFreeList * f)
+{
+  void *first = ink_atomiclist_pop(&f->batches);
+  void *last = first;
+
+  if (!first)
+    return 0;
+  for (uint32_t i = 1; i < BATCH_COUNT(first); i++) {
+    void *next = BATCH_NEXT(last);
+    *ADDRESS_OF_NEXT(last, f->offset) = FROM_PTR(next);
+    last = next;
+  }
+  freelist_push_chain(f, first, last);
+  return 1;
+}
+#endif
+
 void *
 ink_freelist_new(InkFreeList * f)
 {
@@ -146,6 +196,9 @@ ink_freelist_new(InkFreeList * f)
       uint32_t type_size = f->type_size;
       uint32_t i;
 
+      if (freelist_unpark_batch(f))
+        continue;
+
 #ifdef MEMPROTECT
       if (type_size >= MEMPROTECT_SIZE) {
         if (f->alignment < page_size)
@@ -174,7 +227,7 @@ ink_freelist_new(InkFreeList * f)
       ink_atomic_increment((int *) &f->allocated, f->chunk_size);
       ink_atomic_increment(&fastalloc_mem_total, (int64_t) f->chunk_size * f->type_size);
 
-      /* free each of the new elements */
+      /* link the new elements together and free them all at once */
       for (i = 0; i < f->chunk_size; i++) {
         char *a = ((char *) FREELIST_POINTER(item)) + i * type_size;
 #ifdef DEADBEEF
@@ -182,7 +235,8 @@ ink_freelist_new(InkFreeList * f)
         for (int j = 0; j < (int)type_size; j++)
           a[j] = str[j % 4];
 #endif
-        ink_freelist_free(f, a);
+        if (i + 1 < f->chunk_size)
+          *ADDRESS_OF_NEXT(a, f->offset) = FROM_PTR(a + type_size);
 #ifdef MEMPROTECT
         if (f->type_size >= MEMPROTECT_SIZE) {
           a += type_size - page_size;
@@ -192,8 +246,8 @@ ink_freelist_new(InkFreeList * f)
 #endif /* MEMPROTECT */
 
       }
-      ink_atomic_increment((int *) &f->count, f->chunk_size);
-      ink_atomic_increment(&fastalloc_mem_in_use, (int64_t) f->chunk_size * f->type_size);
+      freelist_push_chain(f, FREELIST_POINTER(item),
+                          (char *) FREELIST_POINTER(item) + (f->chunk_size - 1) * type_size);
 
     } else {
       SET_FREELIST_POINTER_VERSION(next, *ADDRESS_OF_NEXT(TO_PTR(FREELIST_POINTER(item)), f->offset),
@@ -230,7 +284,6 @@ ink_freelist_new(InkFreeList * f)
   return newp;
 #endif
 }
-typedef volatile void *volatile_void_p;
 
 void
 ink_freelist_free(InkFreeList * f, void *item)
@@ -281,6 +334,56 @@ ink_freelist_free(InkFreeList * f, void *item)
 #endif
 }
 
+void
+ink_freelist_free_batch(InkFreeList * f, void *head, uint32_t num_item)
+{
+#if TS_USE_FREELIST
+  ink_assert(num_item > 0 && f->offset == 0);
+  if (f->type_size < 3 * sizeof(void *)) {
+    // too small to carry the batch header, free the items one by one
+    while (num_item--) {
+      void *next = BATCH_NEXT(head);
+      ink_freelist_free(f, head);
+      head = next;
+    }
+    return;
+  }
+  ((void **) head)[1] = NULL;
+  BATCH_COUNT(head) = num_item;
+  ink_atomiclist_push(&f->batches, head);
+
+  ink_atomic_increment((int *) &f->count, -(int) num_item);
+  ink_atomic_increment(&fastalloc_mem_in_use, -(int64_t) num_item * f->type_size);
+#else
+  while (num_item--) {
+    void *next = BATCH_NEXT(head);
+    ink_freelist_free(f, head);
+    head = next;
+  }
+#endif
+}
+
+void *
+ink_freelist_new_batch(InkFreeList * f, uint32_t * num_item)
+{
+#if TS_USE_FREELIST
+  void *head = ink_atomiclist_pop(&f->batches);
+
+  if (!head) {
+    *num_item = 0;
+    return NULL;
+  }
+  *num_item = BATCH_COUNT(head);
+  ink_atomic_increment((int *) &f->count, (int) *num_item);
+  ink_atomic_increment(&fastalloc_mem_in_use, (int64_t) *num_item * f->type_size);
+  return head;
+#else
+  (void) f;
+  *num_item = 0;
+  return NULL;
+#endif
+}
+
 void
 ink_freelists_snap_baseline()
 {
@@ -431,6 +534,40 @@ ink_atomiclist_popall(InkAtomicList * l)
   }
 }
 
+#if defined(INK_USE_MUTEX_FOR_ATOMICLISTS)
+int
+ink_atomiclist_pushall_if_empty_wrap(InkAtomicList * l, void *item)
+#else /* !INK_USE_MUTEX_FOR_ATOMICLISTS */
+int
+ink_atomiclist_pushall_if_empty(InkAtomicList * l, void *item)
+#endif                          /* !INK_USE_MUTEX_FOR_ATOMICLISTS */
+{
+  head_p head;
+  head_p item_pair;
+  void *e;
+  int result = 0;
+
+  INK_QUEUE_LD64(head, l->head);
+  if (TO_PTR(FREELIST_POINTER(head)) != NULL)
+    return 0;
+  /* the list keeps its forward pointers swizzled */
+  for (e = item; e; e = TO_PTR(*ADDRESS_OF_NEXT(e, l->offset)))
+    *ADDRESS_OF_NEXT(e, l->offset) = FROM_PTR(*ADDRESS_OF_NEXT(e, l->offset));
+  SET_FREELIST_POINTER_VERSION(item_pair, FROM_PTR(item), FREELIST_VERSION(head));
+  INK_MEMORY_BARRIER;
+#if !defined(INK_USE_MUTEX_FOR_ATOMICLISTS)
+  result = ink_atomic_cas((int64_t *) & l->head, head.data, item_pair.data);
+#else
+  l->head.data = item_pair.data;
+  result = 1;
+#endif
+  if (!result) {
+    for (e = item; e; e = *ADDRESS_OF_NEXT(e, l->offset))
+      *ADDRESS_OF_NEXT(e, l->offset) = TO_PTR(*ADDRESS_OF_NEXT(e, l->offset));
+  }
+  return result;
+}
+
 #if defined(INK_USE_MUTEX_FOR_ATOMICLISTS)
 void *
 ink_atomiclist_push_wrap(InkAtomicList * l, void *item)
@@ -124,12 +124,23 @@ extern "C"
 
   typedef void *void_p;
 
+  typedef struct
+  {
+#if defined(INK_USE_MUTEX_FOR_ATOMICLISTS)
+    ink_mutex inkatomiclist_mutex;
+#endif
+    volatile head_p head;
+    const char *name;
+    uint32_t offset;
+  } InkAtomicList;
+
   typedef struct
   {
     volatile head_p head;
     const char *name;
     uint32_t type_size, chunk_size, count, allocated, offset, alignment;
     uint32_t allocated_base, count_base;
+    InkAtomicList batches;      /* see ink_freelist_free_batch() */
   } InkFreeList, *PInkFreeList;
 
   inkcoreapi extern volatile int64_t fastalloc_mem_in_use;
@@ -147,20 +158,19 @@ extern "C"
                                     uint32_t offset_to_next, uint32_t alignment);
   inkcoreapi void *ink_freelist_new(InkFreeList * f);
   inkcoreapi void ink_freelist_free(InkFreeList * f, void *item);
+
+/*
+ * Batches of free items, for the per-thread caches.  A batch is a list
+ * of items linked through their first word, and is pushed or popped in
+ * one atomic operation whatever its length.  Only for free lists with
+ * the next pointer at offset 0 and items of at least three pointers.
+ */
+  inkcoreapi void ink_freelist_free_batch(InkFreeList * f, void *head, uint32_t num_item);
+  inkcoreapi void *ink_freelist_new_batch(InkFreeList * f, uint32_t * num_item);
   void ink_freelists_dump(FILE * f);
   void ink_freelists_dump_baselinerel(FILE * f);
   void ink_freelists_snap_baseline();
 
-  typedef struct
-  {
-#if defined(INK_USE_MUTEX_FOR_ATOMICLISTS)
-    ink_mutex inkatomiclist_mutex;
-#endif
-    volatile head_p head;
-    const char *name;
-    uint32_t offset;
-  } InkAtomicList;
-
 #if !defined(INK_QUEUE_NT)
 #define INK_ATOMICLIST_EMPTY(_x) (!(TO_PTR(FREELIST_POINTER((_x.head)))))
 #else
@@ -180,6 +190,12 @@ extern "C"
  * WARNING WARNING WARNING WARNING WARNING WARNING WARNING
  */
   void *ink_atomiclist_remove(InkAtomicList * l, void *item);
+/*
+ * Pushes a NULL terminated chain of items, linked through their next
+ * pointers, in one atomic operation, but only onto an empty list.
+ * Returns 0 and leaves the chain as it was if the list is not empty.
+ */
+  int ink_atomiclist_pushall_if_empty(InkAtomicList * l, void *item);
 #else /* INK_USE_MUTEX_FOR_ATOMICLISTS */
   void *ink_atomiclist_push_wrap(InkAtomicList * l, void *item);
   static inline void *ink_atomiclist_push(InkAtomicList * l, void *item)
@@ -220,6 +236,16 @@ extern "C"
     ink_mutex_release(&(l->inkatomiclist_mutex));
     return ret_value;
   }
+
+  int ink_atomiclist_pushall_if_empty_wrap(InkAtomicList * l, void *item);
+  static inline int ink_atomiclist_pushall_if_empty(InkAtomicList * l, void *item)
+  {
+    int ret_value = 0;
+    ink_mutex_acquire(&(l->inkatomiclist_mutex));
+    ret_value = ink_atomiclist_pushall_if_empty_wrap(l, item);
+    ink_mutex_release(&(l->inkatomiclist_mutex));
+    return ret_value;
+  }
 #endif /* INK_USE_MUTEX_FOR_ATOMICLISTS */
 #ifdef __cplusplus
 }
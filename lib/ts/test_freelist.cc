@@ -63,6 +63,26 @@ test(void *d)
     ink_freelist_free(flist, m2);
     ink_freelist_free(flist, m3);
 
+    // park a small batch, then take back whichever batch is on top
+    if (count % 16 == 0) {
+      void *b = NULL;
+      uint32_t n;
+
+      for (int i = 0; i < 4; i++) {
+        void *m = ink_freelist_new(flist);
+        *(void **) m = b;
+        b = m;
+      }
+      ink_freelist_free_batch(flist, b, 4);
+      if ((b = ink_freelist_new_batch(flist, &n)) != NULL) {
+        while (n--) {
+          void *next = *(void **) b;
+          ink_freelist_free(flist, b);
+          b = next;
+        }
+      }
+    }
+
     // break out of the test if we have run more then 60 seconds
     if (++count % 1000 == 0 && (start + 60) < time(NULL)) {
       return NULL;
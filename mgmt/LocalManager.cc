@@ -1220,6 +1220,16 @@ LocalManager::bindProxyPort(HttpProxyPort& port)
     mgmt_elog(stderr, "[bindProxyPort] Unable to set socket options: %d : %s\n", port.m_port, strerror(errno));
     _exit(1);
   }
+#ifdef SO_REUSEPORT
+  {
+    // The per thread listen sockets of traffic_server join this one.
+    bool found;
+    if (REC_readInteger("proxy.config.net.listen_per_thread", &found) > 0 && found &&
+        setsockopt(port.m_fd, SOL_SOCKET, SO_REUSEPORT, (char *) &one, sizeof(int)) < 0) {
+      mgmt_elog(stderr, "[bindProxyPort] Unable to set SO_REUSEPORT: %d : %s\n", port.m_port, strerror(errno));
+    }
+  }
+#endif
 
   if (port.m_inbound_transparent_p) {
 #if TS_USE_TPROXY
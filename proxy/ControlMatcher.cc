@@ -82,6 +82,235 @@ HttpRequestData::get_client_ip()
   return &src_ip.sa;
 }
 
+// FNV-1a, keys the match cache by the string matched
+static inline uint64_t
+matcher_hash(const char *str, int len)
+{
+  uint64_t h = 0xcbf29ce484222325ULL;
+
+  for (int i = 0; i < len; i++) {
+    h ^= (uint8_t) str[i];
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+// const char* HttpRequestData::get_match_string(int* length, uint64_t* key)
+//
+//   Prints and unescapes the URL the first time a regex table
+//     asks for it and hands the same string to every later table
+//     of the request.  It is rebuilt only if the URL or the target
+//     host it came from has changed since, as remap does between
+//     lookups
+//
+const char *
+HttpRequestData::get_match_string(int *length, uint64_t *key)
+{
+  const char *url, *host;
+  int url_len, host_len, port;
+
+  if (hdr == NULL || !hdr->valid()) {
+    return NULL;
+  }
+  url = hdr->url_get()->string_get_ref(&url_len);
+  if (url == NULL) {
+    return NULL;
+  }
+  host = hdr->host_get(&host_len);
+  port = hdr->port_get();
+
+  if (match_buf == NULL || url_len != match_url_len || host_len != match_host_len || port != match_port ||
+      memcmp(match_buf, url, url_len) != 0 || memcmp(match_buf + url_len, host, host_len) != 0) {
+    char *str = hdr->url_string_get(NULL);
+
+    if (str == NULL) {
+      return NULL;
+    }
+    unescapifyStr(str);
+
+    int len = strlen(str);
+    ats_free(match_buf);
+    match_buf = (char *)ats_malloc(url_len + host_len + len + 1);
+    memcpy(match_buf, url, url_len);
+    memcpy(match_buf + url_len, host, host_len);
+    memcpy(match_buf + url_len + host_len, str, len + 1);
+    match_url_len = url_len;
+    match_host_len = host_len;
+    match_port = port;
+    match_len = len;
+    match_key = matcher_hash(str, len);
+    ats_free(str);
+  }
+
+  *length = match_len;
+  *key = match_key;
+  return match_buf + match_url_len + match_host_len;
+}
+
+/*************************************************************
+ *   Begin per thread regex match cache
+ *************************************************************/
+
+// Running every regex of a table is the expensive part of a lookup
+//   and the same URLs and hosts come up again and again.  Each
+//   thread keeps a small set associative LRU recording which rules
+//   of a table matched a string, keyed by the table id and the hash
+//   of the string.  Each entry keeps a copy of its string (strings
+//   are client controlled, so long ones are not cached), and a hit
+//   needs the whole string to compare equal, so a colliding hash can
+//   never pick up the rules of another string.  Tables get a new id
+//   every time a config is (re)loaded, so entries of a replaced table
+//   are never hit again and just age out.  UpdateMatch() still runs for each
+//   request since its modifiers (method, port, time, ...) can reject
+//   a rule whose regex matched
+//
+#define MATCH_CACHE_SETS        512
+#define MATCH_CACHE_WAYS        4
+#define MATCH_CACHE_MAX_RULES   6       // strings matching more rules are not cached
+#define MATCH_CACHE_MIN_TABLE   4       // smaller tables are just as fast to scan
+#define MATCH_CACHE_MAX_LEN     1024    // longer strings are not cached, so copies stay under 2MB a thread
+
+struct MatchCacheEntry
+{
+  uint64_t key;
+  uint32_t table_id;            // zero if the entry is unused
+  int len;
+  char *str;                    // copy of the string, len bytes
+  int num_rules;
+  int rules[MATCH_CACHE_MAX_RULES];
+};
+
+struct MatchCache
+{
+  MatchCacheEntry sets[MATCH_CACHE_SETS][MATCH_CACHE_WAYS];
+};
+
+static vint32 match_table_ids = 0;
+static ink_thread_key match_cache_key;
+
+static void
+match_cache_free(void *ptr)
+{
+  MatchCache *cache = (MatchCache *) ptr;
+
+  for (int s = 0; s < MATCH_CACHE_SETS; s++)
+    for (int i = 0; i < MATCH_CACHE_WAYS; i++)
+      ats_free(cache->sets[s][i].str);
+  ats_free(cache);
+}
+
+struct MatchCacheKeyInit
+{
+  MatchCacheKeyInit() { ink_thread_key_create(&match_cache_key, match_cache_free); }
+};
+static MatchCacheKeyInit match_cache_key_init;
+
+static inline MatchCacheEntry *
+match_cache_set(uint32_t table_id, uint64_t key)
+{
+  MatchCache *cache = (MatchCache *) ink_thread_getspecific(match_cache_key);
+
+  if (unlikely(cache == NULL)) {
+    cache = (MatchCache *)ats_malloc(sizeof(MatchCache));
+    memset(cache, 0, sizeof(MatchCache));
+    ink_thread_setspecific(match_cache_key, cache);
+  }
+  return cache->sets[(key ^ (key >> 32) ^ table_id * 0x9e3779b1U) & (MATCH_CACHE_SETS - 1)];
+}
+
+// Returns the entry for the string, moved to the front of its set,
+//   or NULL if it is not cached
+static MatchCacheEntry *
+match_cache_get(uint32_t table_id, uint64_t key, const char *str, int len)
+{
+  if (len > MATCH_CACHE_MAX_LEN)
+    return NULL;
+
+  MatchCacheEntry *set = match_cache_set(table_id, key);
+
+  for (int i = 0; i < MATCH_CACHE_WAYS; i++) {
+    if (set[i].table_id == table_id && set[i].key == key && set[i].len == len && memcmp(set[i].str, str, len) == 0) {
+      if (i > 0) {
+        MatchCacheEntry e = set[i];
+        memmove(set + 1, set, i * sizeof(MatchCacheEntry));
+        set[0] = e;
+      }
+      return set;
+    }
+  }
+  return NULL;
+}
+
+// Caches the rules that matched the string, evicting the least
+//   recently used entry of its set
+static void
+match_cache_put(uint32_t table_id, uint64_t key, const char *str, int len, int *rules, int num_rules)
+{
+  if (len > MATCH_CACHE_MAX_LEN)
+    return;
+
+  MatchCacheEntry *set = match_cache_set(table_id, key);
+  char *copy = set[MATCH_CACHE_WAYS - 1].str;
+
+  if (copy == NULL || set[MATCH_CACHE_WAYS - 1].len < len)
+    copy = (char *)ats_realloc(copy, len + 1);
+  memcpy(copy, str, len);
+  memmove(set + 1, set, (MATCH_CACHE_WAYS - 1) * sizeof(MatchCacheEntry));
+  set[0].key = key;
+  set[0].table_id = table_id;
+  set[0].len = len;
+  set[0].str = copy;
+  set[0].num_rules = num_rules;
+  memcpy(set[0].rules, rules, num_rules * sizeof(int));
+}
+
+#if TS_HAS_TESTS
+REGRESSION_TEST(ControlMatcher_MatchCache) (RegressionTest * t, int atype, int *pstatus)
+{
+  NOWARN_UNUSED(atype);
+  static const char a[] = "http://a.example.com/";
+  static const char b[] = "http://b.example.com/";
+  int rules[] = { 3, 7 };
+  uint32_t table_id = (uint32_t) ink_atomic_increment(&match_table_ids, 1) + 1;
+  MatchCacheEntry *e;
+
+  *pstatus = REGRESSION_TEST_PASSED;
+  match_cache_put(table_id, matcher_hash(a, sizeof(a) - 1), a, sizeof(a) - 1, rules, 2);
+  e = match_cache_get(table_id, matcher_hash(a, sizeof(a) - 1), a, sizeof(a) - 1);
+  if (e == NULL || e->num_rules != 2 || e->rules[1] != 7) {
+    rprintf(t, "cached rules not found\n");
+    *pstatus = REGRESSION_TEST_FAILED;
+  }
+  // another string of the same length under the same hash, as a collision would be
+  if (match_cache_get(table_id, matcher_hash(a, sizeof(a) - 1), b, sizeof(b) - 1) != NULL) {
+    rprintf(t, "colliding string hit the cache\n");
+    *pstatus = REGRESSION_TEST_FAILED;
+  }
+  if (match_cache_get(table_id + 1, matcher_hash(a, sizeof(a) - 1), a, sizeof(a) - 1) != NULL) {
+    rprintf(t, "other table hit the cache\n");
+    *pstatus = REGRESSION_TEST_FAILED;
+  }
+  // strings over the limit are never kept
+  char *l = (char *)ats_malloc(MATCH_CACHE_MAX_LEN + 1);
+  memset(l, 'a', MATCH_CACHE_MAX_LEN + 1);
+  match_cache_put(table_id, matcher_hash(l, MATCH_CACHE_MAX_LEN + 1), l, MATCH_CACHE_MAX_LEN + 1, rules, 2);
+  if (match_cache_get(table_id, matcher_hash(l, MATCH_CACHE_MAX_LEN + 1), l, MATCH_CACHE_MAX_LEN + 1) != NULL) {
+    rprintf(t, "string over the limit cached\n");
+    *pstatus = REGRESSION_TEST_FAILED;
+  }
+  match_cache_put(table_id, matcher_hash(l, MATCH_CACHE_MAX_LEN), l, MATCH_CACHE_MAX_LEN, rules, 2);
+  if (match_cache_get(table_id, matcher_hash(l, MATCH_CACHE_MAX_LEN), l, MATCH_CACHE_MAX_LEN) == NULL) {
+    rprintf(t, "string at the limit not cached\n");
+    *pstatus = REGRESSION_TEST_FAILED;
+  }
+  ats_free(l);
+}
+#endif
+
+/*************************************************************
+ *   End per thread regex match cache
+ *************************************************************/
+
 /*************************************************************
  *   Begin class HostMatcher
  *************************************************************/
@@ -230,7 +459,8 @@ template<class Data, class Result> char *HostMatcher<Data, Result>::NewEntry(mat
 // RegexMatcher<Data,Result>::RegexMatcher()
 //
 template<class Data, class Result> RegexMatcher<Data, Result>::RegexMatcher(const char *name, const char *filename):
-re_array(NULL), re_str(NULL), data_array(NULL), array_len(-1), num_el(-1), matcher_name(name), file_name(filename)
+table_id((uint32_t) ink_atomic_increment(&match_table_ids, 1) + 1), re_array(NULL), re_str(NULL), data_array(NULL), array_len(-1),
+num_el(-1), matcher_name(name), file_name(filename)
 {
 }
 
@@ -347,8 +577,10 @@ template<class Data, class Result> char *RegexMatcher<Data, Result>::NewEntry(ma
 //
 template<class Data, class Result> void RegexMatcher<Data, Result>::Match(RD * rdata, Result * result)
 {
-  char *url_str;
-  int r;
+  const char *url_str;
+  char *str = NULL;
+  int len;
+  uint64_t key;
 
   // Check to see there is any work to before we copy the
   //   URL
@@ -356,31 +588,75 @@ template<class Data, class Result> void RegexMatcher<Data, Result>::Match(RD * r
     return;
   }
 
-  url_str = rdata->get_string();
-
-  // Can't do a regex match with a NULL string so
-  //  use an empty one instead
-  if (url_str == NULL) {
-    url_str = ats_strdup("");
-  }
   // INKqa12980
   // The function unescapifyStr() is already called in
-  // HttpRequestData::get_string(); therefore, no need to call again here.
-  // unescapifyStr(url_str);
+  // HttpRequestData::get_string() and get_match_string(); therefore,
+  // no need to call again here.
+  url_str = rdata->get_match_string(&len, &key);
+  if (url_str == NULL) {
+    str = rdata->get_string();
+
+    // Can't do a regex match with a NULL string so
+    //  use an empty one instead
+    url_str = str ? str : "";
+    len = strlen(url_str);
+    key = matcher_hash(url_str, len);
+  }
+
+  MatchString(url_str, len, key, rdata, result);
+  ats_free(str);
+}
+
+//
+// void RegexMatcher<Data,Result>::MatchString(const char* str, int len, uint64_t key,
+//                                             RD* rdata, Result* result)
+//
+//   Updates arg result for each regex that matches arg str, taking
+//     the matching rules from the thread's match cache when it has
+//     them and caching them otherwise
+//
+template<class Data, class Result>
+void RegexMatcher<Data, Result>::MatchString(const char *str, int len, uint64_t key, RD * rdata, Result * result)
+{
+  int rules[MATCH_CACHE_MAX_RULES];
+  int num_rules = 0;
+  bool cacheable = num_el >= MATCH_CACHE_MIN_TABLE;
+  int r;
+
+  if (cacheable) {
+    MatchCacheEntry *e = match_cache_get(table_id, key, str, len);
+
+    if (e != NULL) {
+      for (int i = 0; i < e->num_rules; i++) {
+        Debug("matcher", "%s Matched %s with regex at line %d (cached)", matcher_name, str,
+              data_array[e->rules[i]].line_num);
+        data_array[e->rules[i]].UpdateMatch(result, rdata);
+      }
+      return;
+    }
+  }
 
   for (int i = 0; i < num_el; i++) {
 
-    r = pcre_exec(re_array[i], NULL, url_str, strlen(url_str), 0, 0, NULL, 0);
+    r = pcre_exec(re_array[i], NULL, str, len, 0, 0, NULL, 0);
     if (r > -1) {
-      Debug("matcher", "%s Matched %s with regex at line %d", matcher_name, url_str, data_array[i].line_num);
+      Debug("matcher", "%s Matched %s with regex at line %d", matcher_name, str, data_array[i].line_num);
       data_array[i].UpdateMatch(result, rdata);
+      if (num_rules < MATCH_CACHE_MAX_RULES) {
+        rules[num_rules] = i;
+      }
+      num_rules++;
     } else if (r < -1) {
-      // An error has occured
+      // An error has occured, try again next time
       Warning("Error [%d] matching regex at line %d.", r, data_array[i].line_num);
+      cacheable = false;
     } // else it's -1 which means no match was found.
 
   }
-  ats_free(url_str);
+
+  if (cacheable && num_rules <= MATCH_CACHE_MAX_RULES) {
+    match_cache_put(table_id, key, str, len, rules, num_rules);
+  }
 }
 
 //
@@ -404,7 +680,7 @@ Result > (name, filename)
 template<class Data, class Result> void HostRegexMatcher<Data, Result>::Match(RD * rdata, Result * result)
 {
   const char *url_str;
-  int r;
+  int len;
 
   // Check to see there is any work to before we copy the
   //   URL
@@ -419,17 +695,8 @@ template<class Data, class Result> void HostRegexMatcher<Data, Result>::Match(RD
   if (url_str == NULL) {
     url_str = "";
   }
-  for (int i = 0; i < this->num_el; i++) {
-    r = pcre_exec(this->re_array[i], NULL, url_str, strlen(url_str), 0, 0, NULL, 0);
-    if (r != -1) {
-      Debug("matcher", "%s Matched %s with regex at line %d",
-            const_cast<char*>(this->matcher_name), url_str, this->data_array[i].line_num);
-      this->data_array[i].UpdateMatch(result, rdata);
-    } else {
-      // An error has occured
-      Warning("error matching regex at line %d", this->data_array[i].line_num);
-    }
-  }
+  len = strlen(url_str);
+  this->MatchString(url_str, len, matcher_hash(url_str, len), rdata, result);
 }
 
 //
@@ -124,6 +124,15 @@ public:
   virtual sockaddr const* get_ip() = 0;
 
   virtual sockaddr const* get_client_ip() = 0;
+
+  // The unescaped string the regex table matches, with its length
+  //  and hash, shared by every table looked up for this request.
+  //  It stays owned by the request data.  NULL means the request
+  //  data does not keep one and get_string() is used instead
+  virtual const char *get_match_string(int * /* length */, uint64_t * /* key */)
+  {
+    return NULL;
+  }
   enum RD_Type
   { RD_NULL, RD_HTTP, RD_CONGEST_ENTRY };
   virtual RD_Type data_type(void)
@@ -140,14 +149,26 @@ public:
   inkcoreapi const char *get_host();
   inkcoreapi sockaddr const* get_ip();
   inkcoreapi sockaddr const* get_client_ip();
+  inkcoreapi const char *get_match_string(int *length, uint64_t *key);
 
   HttpRequestData()
     : hdr(NULL), hostname_str(NULL), api_info(NULL),
-      xact_start(0), incoming_port(0), tag(NULL)
+      xact_start(0), incoming_port(0), tag(NULL),
+      match_buf(NULL), match_url_len(0), match_host_len(0), match_port(0),
+      match_len(0), match_key(0)
   { 
     ink_zero(src_ip);
     ink_zero(dest_ip);
   }
+  ~HttpRequestData()
+  {
+    clear_match_string();
+  }
+  void clear_match_string()
+  {
+    ats_free(match_buf);
+    match_buf = NULL;
+  }
 
   HTTPHdr *hdr;
   char *hostname_str;
@@ -157,6 +178,15 @@ public:
   IpEndpoint dest_ip;
   uint16_t incoming_port;
   char *tag;
+
+  // The URL and target host the match string was built from,
+  //  followed by the match string itself
+  char *match_buf;
+  int match_url_len;
+  int match_host_len;
+  int match_port;
+  int match_len;
+  uint64_t match_key;
 };
 
 
@@ -179,6 +209,8 @@ public:
 #ifndef TS_MICRO
 protected:
 #endif
+  void MatchString(const char *str, int len, uint64_t key, RD * rdata, Result * result);
+  uint32_t table_id;            // Unique per table, keys the per thread match cache
   pcre** re_array;              // array of compiled regexs
   char **re_str;                // array of uncompiled regex strings
   Data *data_array;             // data array.  Corresponds to re_array
@@ -6669,6 +6669,12 @@ TSStatCreate(const char *the_name, TSRecordDataType the_type, TSStatPersistence
       (sdk_sanity_check_null_ptr((void*)api_rsb) != TS_SUCCESS))
     return TS_ERROR;
 
+  if (id >= api_rsb->max_stats) {
+    Warning("Can't create plugin stat %s, all %d slots are used, rebuild with --with-max-api-stats=<n>",
+            the_name, api_rsb->max_stats);
+    return TS_ERROR;
+  }
+
   switch (sync) {
   case TS_STAT_SYNC_SUM:
     syncer = RecRawStatSyncSum;
@@ -1258,6 +1258,30 @@ adjust_num_of_net_threads(void)
   }
 }
 
+/**
+ * Create the sockets of the per thread listen sockets
+ * (proxy.config.net.listen_per_thread) of the proxy ports. Linux only
+ * lets sockets created by the same user share a port, so to join the
+ * sockets the manager opened they must be created before we change user.
+ */
+static void
+reserve_per_thread_listen_sockets(void)
+{
+  int listen_per_thread = 0;
+
+  TS_ReadConfigInteger(listen_per_thread, "proxy.config.net.listen_per_thread");
+  if (!listen_per_thread)
+    return;
+  HttpProxyPort::Group &ports = HttpProxyPort::global();
+  for (int i = 0, n = ports.length(); i < n; ++i) {
+    HttpProxyPort &p = ports[i];
+    // one thread of each keeps polling the shared socket
+    int threads = p.isSSL() ? getNumSSLThreads() : num_of_net_threads;
+    if (threads > 1)
+      Server::reserve_reuseport_sockets(p.m_family, threads - 1);
+  }
+}
+
 /**
  * Change the uid and gid to what is in the passwd entry for supplied user name.
  * @param user User name in the passwd file to change the uid and gid to.
@@ -1434,6 +1458,12 @@ main(int argc, char **argv)
     ) && user[0] != '\0' && 0 != strcmp(user, "#-1")
     ;
 
+  // Load HTTP port data. getNumSSLThreads depends on this.
+  if (!HttpProxyPort::loadValue(http_accept_port_descriptor))
+    HttpProxyPort::loadConfig();
+  HttpProxyPort::loadDefaultIfEmpty();
+  adjust_num_of_net_threads();
+
 # if TS_USE_POSIX_CAP
   // Change the user of the process.
   // Do this before we start threads so we control the user id of the
@@ -1442,6 +1472,7 @@ main(int argc, char **argv)
   // as those are thread local and if we change the user id it will
   // modify the capabilities in other threads, breaking things.
   if (admin_user_p) {
+    reserve_per_thread_listen_sockets();
     PreserveCapabilities();
     change_uid_gid(user);
     RestrictCapabilities();
@@ -1583,8 +1614,6 @@ main(int argc, char **argv)
   // Initialize New Stat system
   initialize_all_global_stats();
 
-  adjust_num_of_net_threads();
-
   ink_event_system_init(makeModuleVersion(1, 0, PRIVATE_MODULE_HEADER));
   ink_net_init(makeModuleVersion(1, 0, PRIVATE_MODULE_HEADER));
   ink_aio_init(makeModuleVersion(1, 0, PRIVATE_MODULE_HEADER));
@@ -1593,6 +1622,7 @@ main(int argc, char **argv)
   ink_dns_init(makeModuleVersion(1, 0, PRIVATE_MODULE_HEADER));
   ink_split_dns_init(makeModuleVersion(1, 0, PRIVATE_MODULE_HEADER));
   eventProcessor.start(num_of_net_threads);
+  ink_aio_start();
 
   int use_separate_thread = 0;
   int num_remap_threads = 1;
@@ -1649,11 +1679,6 @@ main(int argc, char **argv)
     clusterProcessor.init();
 #endif
 
-    // Load HTTP port data. getNumSSLThreads depends on this.
-    if (!HttpProxyPort::loadValue(http_accept_port_descriptor))
-      HttpProxyPort::loadConfig();
-    HttpProxyPort::loadDefaultIfEmpty();
-
     cacheProcessor.start();
     udpNet.start(num_of_udp_threads);
     sslNetProcessor.start(getNumSSLThreads());
@@ -62,7 +62,8 @@ static const char *ParentResultStr[] = {
 static const char *ParentRRStr[] = {
   "false",
   "strict",
-  "true"
+  "true",
+  "consistent_hash"
 };
 
 //
@@ -479,6 +480,72 @@ ParentConfigParams::nextParent(HttpRequestData * rdata, ParentResult * result)
 //   End API functions
 //
 
+// Weighted rendezvous hashing: every parent scores the URL hash and the
+//   highest score wins.  Marking a parent down only moves the URLs it
+//   owned, each to the parent with the next highest score for that URL.
+static inline uint64_t
+parent_hash_mix(uint64_t x)
+{
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+static inline double
+parent_hash_score(uint64_t url_hash, pRecord *p)
+{
+  // Map the mixed hash to (0, 1) and weight it as -w / ln(u)
+  double u = ((double) (parent_hash_mix(url_hash ^ p->hash) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+  return -p->weight / log(u);
+}
+
+static uint64_t
+parent_url_hash(HttpRequestData *rdata)
+{
+  INK_MD5 md5;
+
+  if (rdata->hdr == NULL)
+    return 0;
+  rdata->hdr->url_get()->MD5_get(&md5);
+  return md5.fold();
+}
+
+// int ParentRecord::NextHashParent(uint64_t url_hash, int prev)
+//
+//    Returns the parent ranked right after prev for url_hash, or the
+//      best ranked parent if prev is negative or the last one.  Ties
+//      in score are broken by index so the order is total.
+//
+int
+ParentRecord::NextHashParent(uint64_t url_hash, int prev)
+{
+  double prev_score = 0;
+  double best_score = -1;
+  int best = -1;
+  int top = 0;
+  double top_score = -1;
+
+  if (prev >= 0)
+    prev_score = parent_hash_score(url_hash, &parents[prev]);
+
+  for (int i = 0; i < num_parents; i++) {
+    double score = parent_hash_score(url_hash, &parents[i]);
+
+    if (score > top_score) {
+      top_score = score;
+      top = i;
+    }
+    if (prev >= 0 && (score < prev_score || (score == prev_score && i > prev)) && score > best_score) {
+      best_score = score;
+      best = i;
+    }
+  }
+  return best < 0 ? top : best;
+}
+
 void
 ParentRecord::FindParent(bool first_call, ParentResult * result, RD * rdata, ParentConfigParams * config)
 {
@@ -487,11 +554,15 @@ ParentRecord::FindParent(bool first_call, ParentResult * result, RD * rdata, Par
   bool parentUp = false;
   bool parentRetry = false;
   bool bypass_ok = (go_direct == true && config->DNS_ParentOnly == 0);
+  uint64_t url_hash = 0;
 
   HttpRequestData *request_info = (HttpRequestData *) rdata;
 
   ink_assert(num_parents > 0 || go_direct == true);
 
+  if (round_robin == P_CONSISTENT_HASH && parents != NULL)
+    url_hash = parent_url_hash(request_info);
+
   if (first_call == true) {
     if (parents == NULL) {
       // We should only get into this state if
@@ -522,13 +593,19 @@ ParentRecord::FindParent(bool first_call, ParentResult * result, RD * rdata, Par
       case P_NO_ROUND_ROBIN:
         cur_index = result->start_parent = 0;
         break;
+      case P_CONSISTENT_HASH:
+        cur_index = result->start_parent = NextHashParent(url_hash, -1);
+        break;
       default:
         ink_release_assert(0);
       }
     }
   } else {
     // Move to next parent due to failure
-    cur_index = (result->last_parent + 1) % num_parents;
+    if (round_robin == P_CONSISTENT_HASH)
+      cur_index = NextHashParent(url_hash, result->last_parent);
+    else
+      cur_index = (result->last_parent + 1) % num_parents;
 
     // Check to see if we have wrapped around
     if ((unsigned int) cur_index == result->start_parent) {
@@ -579,7 +656,10 @@ ParentRecord::FindParent(bool first_call, ParentResult * result, RD * rdata, Par
       return;
     }
 
-    cur_index = (cur_index + 1) % num_parents;
+    if (round_robin == P_CONSISTENT_HASH)
+      cur_index = NextHashParent(url_hash, cur_index);
+    else
+      cur_index = (cur_index + 1) % num_parents;
 
   } while ((unsigned int) cur_index != result->start_parent);
 
@@ -617,8 +697,10 @@ ParentRecord::ProcessParents(char *val)
   int numTok;
   const char *current;
   int port;
+  double weight;
   char *tmp;
   const char *errPtr;
+  INK_MD5 md5;
 
   if (parents != NULL) {
     return "Can not specify more than one set of parents";
@@ -654,6 +736,15 @@ ParentRecord::ProcessParents(char *val)
     //   port
     char *scan = tmp + 1;
     for (; *scan != '\0' && ParseRules::is_digit(*scan); scan++);
+    // An optional "|weight" follows the port
+    weight = 1.0;
+    if (*scan == '|') {
+      weight = strtod(scan + 1, &scan);
+      if (!(weight > 0)) {
+        errPtr = "Malformed parent weight";
+        goto MERROR;
+      }
+    }
     for (; *scan != '\0' && ParseRules::is_wslfcr(*scan); scan++);
     if (*scan != '\0') {
       errPtr = "Garbage trailing entry or invalid separator";
@@ -674,6 +765,9 @@ ParentRecord::ProcessParents(char *val)
     this->parents[i].port = port;
     this->parents[i].failedAt = 0;
     this->parents[i].scheme = scheme;
+    this->parents[i].weight = weight;
+    md5.encodeBuffer(current, tmp - current);
+    this->parents[i].hash = md5.fold() ^ (uint64_t) port;
   }
 
   num_parents = numTok;
@@ -759,6 +853,8 @@ ParentRecord::Init(matcher_line * line_info)
         round_robin = P_STRICT_ROUND_ROBIN;
       } else if (strcasecmp(val, "false") == 0) {
         round_robin = P_NO_ROUND_ROBIN;
+      } else if (strcasecmp(val, "consistent_hash") == 0) {
+        round_robin = P_CONSISTENT_HASH;
       } else {
         round_robin = P_NO_ROUND_ROBIN;
         errPtr = "invalid argument to round_robin directive";
@@ -1278,6 +1374,99 @@ EXCLUSIVE_REGRESSION_TEST(PARENTSELECTION) (RegressionTest * t, int intensity_le
       ink_assert(0);
     }
   }
+
+  // Test 173 - 175 Consistent Hash Parent Table
+  tbl[0] = '\0';
+  T("dest_domain=hash.net parent=alpha:80,beta:80,gamma:80,delta:80 round_robin=consistent_hash go_direct=false\n")
+  T("dest_domain=weight.net parent=big:80|3,small:80 round_robin=consistent_hash\n")
+  REBUILD
+  char hash_url[64];
+  uint32_t hash_parent[64];
+  int hash_used[4] = { 0, 0, 0, 0 };
+  bool hash_ok = true;
+
+  // Test 173 - every URL sticks to one parent and all parents get some
+  ST(173)
+  for (c = 0; c < 64; c++) {
+    snprintf(hash_url, sizeof(hash_url), "http://www.hash.net/object/%d", c);
+    REINIT br(request, "www.hash.net");
+    request->hdr->url_set(hash_url, strlen(hash_url));
+    FP hash_parent[c] = result->last_parent;
+    hash_used[hash_parent[c]]++;
+    REINIT br(request, "www.hash.net");
+    request->hdr->url_set(hash_url, strlen(hash_url));
+    FP if (result->r != PARENT_SPECIFIED || result->last_parent != hash_parent[c])
+      hash_ok = false;
+  }
+  RE(hash_ok && hash_used[0] && hash_used[1] && hash_used[2] && hash_used[3], 173)
+
+  // Test 174 - marking a parent down only remaps that parent's URLs
+  ST(174)
+  REINIT br(request, "www.hash.net");
+  request->hdr->url_set("http://www.hash.net/object/0", strlen("http://www.hash.net/object/0"));
+  FP params->markParentDown(result);
+  hash_ok = true;
+  for (c = 0; c < 64; c++) {
+    snprintf(hash_url, sizeof(hash_url), "http://www.hash.net/object/%d", c);
+    REINIT br(request, "www.hash.net");
+    request->hdr->url_set(hash_url, strlen(hash_url));
+    FP if (result->r != PARENT_SPECIFIED)
+      hash_ok = false;
+    else if (hash_parent[c] != hash_parent[0] && result->last_parent != hash_parent[c])
+      hash_ok = false;
+    else if (hash_parent[c] == hash_parent[0] && result->last_parent == hash_parent[0])
+      hash_ok = false;
+  }
+  RE(hash_ok, 174)
+
+  // Test 175 - weights skew the share of the URL space
+  ST(175)
+  int big = 0;
+  for (c = 0; c < 400; c++) {
+    snprintf(hash_url, sizeof(hash_url), "http://www.weight.net/object/%d", c);
+    REINIT br(request, "www.weight.net");
+    request->hdr->url_set(hash_url, strlen(hash_url));
+    FP big += verify(result, PARENT_SPECIFIED, "big", 80);
+  }
+  RE(big > 240 && big < 360, 175)
+
+  // Test 176 - 177 Regex Table, large enough for the per thread match cache
+  tbl[0] = '\0';
+  T("url_regex=apple parent=red:80\n")
+  T("url_regex=banana parent=yellow:80\n")
+  T("url_regex=grape parent=purple:80\n")
+  T("url_regex=lime parent=green:80\n")
+  T("url_regex=plum parent=violet:80\n")
+  REBUILD
+  const char *apple_url = "http://www.fruit.net/apple";
+  const char *banana_url = "http://www.fruit.net/banana";
+  int fruit = 0;
+
+  // Test 176 - cached outcomes and a URL rewritten between lookups
+  ST(176)
+  for (c = 0; c < 4; c++) {
+    REINIT br(request, "www.fruit.net");
+    request->hdr->url_set(apple_url, strlen(apple_url));
+    FP fruit += verify(result, PARENT_SPECIFIED, "red", 80);
+    delete result;
+    result = new ParentResult();
+    request->hdr->url_set(banana_url, strlen(banana_url));
+    FP fruit += verify(result, PARENT_SPECIFIED, "yellow", 80);
+  }
+  RE(fruit == 8, 176)
+
+  // Test 177 - a rebuilt table does not see the old table's outcomes
+  ST(177)
+  tbl[0] = '\0';
+  T("url_regex=apple parent=green:80\n")
+  T("url_regex=grape parent=purple:80\n")
+  T("url_regex=lime parent=green:80\n")
+  T("url_regex=plum parent=violet:80\n")
+  REBUILD
+  REINIT br(request, "www.fruit.net");
+  request->hdr->url_set(apple_url, strlen(apple_url));
+  FP RE(verify(result, PARENT_SPECIFIED, "green", 80), 177)
+
   delete request;
   delete result;
 
@@ -163,13 +163,16 @@ struct pRecord
   int failCount;
   int32_t upAt;
   const char *scheme;           // for which parent matches (if any)
+  float weight;                 // share of the URL space for consistent hashing
+  uint64_t hash;                // hash of "hostname:port", seeds the consistent hash
 };
 
 enum ParentRR_t
 {
   P_NO_ROUND_ROBIN = 0,
   P_STRICT_ROUND_ROBIN,
-  P_HASH_ROUND_ROBIN
+  P_HASH_ROUND_ROBIN,
+  P_CONSISTENT_HASH
 };
 
 // class ParentRecord : public ControlBase
@@ -199,6 +202,7 @@ public:
   const char *scheme;
   //private:
   const char *ProcessParents(char *val);
+  int NextHashParent(uint64_t url_hash, int prev);
   ParentRR_t round_robin;
   volatile uint32_t rr_next;
   bool go_direct;
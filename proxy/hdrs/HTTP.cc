@@ -1640,7 +1640,7 @@ ClassAllocator<HTTPCacheAlt> httpCacheAltAllocator("httpCacheAltAllocator");
 HTTPCacheAlt::HTTPCacheAlt():
 m_magic(CACHE_ALT_MAGIC_ALIVE), m_writeable(1),
 m_unmarshal_len(-1),
-m_id(-1), m_rid(-1), m_request_hdr(),
+m_id(-1), m_variant_key(-1), m_request_hdr(),
 m_response_hdr(), m_request_sent_time(0), m_response_received_time(0),
 m_frag_offset_count(0), m_frag_offsets(0),
 m_ext_buffer(NULL)
@@ -1679,7 +1679,7 @@ HTTPCacheAlt::copy(HTTPCacheAlt *to_copy)
   // m_writeable =      to_copy->m_writeable;
   m_unmarshal_len = to_copy->m_unmarshal_len;
   m_id = to_copy->m_id;
-  m_rid = to_copy->m_rid;
+  m_variant_key = to_copy->m_variant_key;
   m_object_key[0] = to_copy->m_object_key[0];
   m_object_key[1] = to_copy->m_object_key[1];
   m_object_key[2] = to_copy->m_object_key[2];
@@ -1264,7 +1264,9 @@ struct HTTPCacheAlt
   int32_t m_unmarshal_len;
 
   int32_t m_id;
-  int32_t m_rid;
+  /// Hash of the request headers named in the response Vary,
+  /// -1 if none. See HttpTransactCache::CalcVariantKey().
+  int32_t m_variant_key;
 
   int32_t m_object_key[4];
   int32_t m_object_size[2];
@@ -1335,10 +1337,10 @@ public:
   int get_handle(char *buf, int len);
 
   int32_t id_get() const { return m_alt->m_id; }
-  int32_t rid_get() { return m_alt->m_rid; }
+  int32_t variant_key_get() const { return m_alt->m_variant_key; }
 
   void id_set(int32_t id) { m_alt->m_id = id; }
-  void rid_set(int32_t id) { m_alt->m_rid = id; }
+  void variant_key_set(int32_t key) { m_alt->m_variant_key = key; }
 
   INK_MD5 object_key_get();
   void object_key_get(INK_MD5 *);
@@ -79,6 +79,7 @@ HdrTest::go(RegressionTest * t, int atype)
   status = status & test_http_parser_eos_boundary_cases();
   status = status & test_http_mutation();
   status = status & test_mime();
+  status = status & test_mime_corpus();
   status = status & test_http();
 
   return (status ? REGRESSION_TEST_PASSED : REGRESSION_TEST_FAILED);
@@ -626,6 +627,93 @@ HdrTest::test_mime()
   return (failures_to_status("test_mime", 0));
 }
 
+/*-------------------------------------------------------------------------
+  Parse a few real world header blocks, whole and split at every byte, and
+  check the fields come out the same with every line finder the CPU has.
+  -------------------------------------------------------------------------*/
+
+int
+HdrTest::test_mime_corpus()
+{
+  static const struct
+  {
+    const char *hdr;
+    int fields;
+    const char *name;
+    const char *value;
+  } corpus[] = {
+    {"Host: www.example.com\r\n"
+     "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:17.0) Gecko/20100101 Firefox/17.0\r\n"
+     "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+     "Accept-Language: en-US,en;q=0.5\r\n"
+     "Accept-Encoding: gzip, deflate\r\n"
+     "Cookie: uid=0123456789abcdef0123456789abcdef; session=fedcba9876543210\r\n"
+     "Connection: keep-alive\r\n"
+     "If-Modified-Since: Tue, 04 Dec 2012 10:21:31 GMT\r\n"
+     "\r\n", 8, "Cookie", "uid=0123456789abcdef0123456789abcdef; session=fedcba9876543210"},
+    {"Date: Tue, 04 Dec 2012 10:22:03 GMT\r\n"
+     "Server: Apache\r\n"
+     "Last-Modified: Tue, 04 Dec 2012 10:21:31 GMT\r\n"
+     "ETag: \"1e4b2-4d003bb3b8cc0\"\r\n"
+     "Accept-Ranges: bytes\r\n"
+     "Content-Length: 124082\r\n"
+     "Cache-Control: max-age=3600, public\r\n"
+     "Vary: Accept-Encoding\r\n"
+     "Content-Type: text/html; charset=UTF-8\r\n"
+     "\r\n", 9, "Content-Type", "text/html; charset=UTF-8"},
+    {"X-Continued: first\r\n"
+     "\tsecond\r\n"
+     "Via: http/1.1 cache01.example.net (ApacheTrafficServer/3.3.0 [cMsSf ])\n"
+     "X-No-Space:value\r\n"
+     "\r\n", 3, "Via", "http/1.1 cache01.example.net (ApacheTrafficServer/3.3.0 [cMsSf ])"},
+  };
+
+  static const char *impls[] = { "memchr", "sse2", "avx2" };
+  int failed = 0;
+
+  bri_box("test_mime_corpus");
+
+  for (unsigned f = 0; f < sizeof(impls) / sizeof(impls[0]); ++f) {
+    if (!mime_find_char_select(impls[f]))
+      continue;
+
+    for (unsigned i = 0; i < sizeof(corpus) / sizeof(corpus[0]); ++i) {
+      int len = (int) strlen(corpus[i].hdr);
+
+      for (int split = len; split > 0; --split) {
+        MIMEHdr hdr;
+        MIMEParser parser;
+        const char *start = corpus[i].hdr;
+        const char *end = start + len;
+        int err;
+
+        mime_parser_init(&parser);
+        hdr.create(NULL);
+
+        err = hdr.parse(&parser, &start, start + split, true, false);
+        if (err == PARSE_CONT)
+          err = hdr.parse(&parser, &start, end, true, true);
+
+        int value_len = 0;
+        const char *value = hdr.value_get(corpus[i].name, strlen(corpus[i].name), &value_len);
+
+        if (err != PARSE_DONE || hdr.fields_count() != corpus[i].fields || value == NULL ||
+            value_len != (int) strlen(corpus[i].value) || memcmp(value, corpus[i].value, value_len) != 0) {
+          printf("FAILED: %s: corpus header %u split at %d: result %d, %d fields\n", impls[f], i, split, err,
+                 hdr.fields_count());
+          ++failed;
+        }
+
+        mime_parser_clear(&parser);
+        hdr.destroy();
+      }
+    }
+  }
+  mime_find_char_select(NULL);
+
+  return (failures_to_status("test_mime_corpus", failed));
+}
+
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
 
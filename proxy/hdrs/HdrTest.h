@@ -68,6 +68,7 @@ private:
   int test_insert_comma_vals();
   int test_parse_comma_list();
   int test_mime();
+  int test_mime_corpus();
   int test_http();
   int test_http_mutation();
 
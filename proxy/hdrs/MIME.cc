@@ -32,6 +32,13 @@
 #include "HdrUtils.h"
 #include "HttpCompat.h"
 
+#if defined(__x86_64__) && (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define MIME_FIND_X86 1
+#include <immintrin.h>
+#else
+#define MIME_FIND_X86 0
+#endif
+
 /***********************************************************************
  *                                                                     *
  *                    C O M P I L E    O P T I O N S                   *
@@ -853,6 +860,7 @@ mime_init()
 
     mime_init_date_format_table();
     mime_init_cache_control_cooking_masks();
+    mime_find_char_select(NULL);
   }
 }
 
@@ -2223,6 +2231,121 @@ mime_scanner_append(MIMEScanner *scanner, const char *data, int data_size)
   scanner->m_line_length += data_size;
 }
 
+/*-------------------------------------------------------------------------
+  Finders for the line feed and the name/value colon of header lines.
+  memchr() is the fallback; on x86-64 mime_init() picks the widest of
+  the inline SSE2 and AVX2 versions the CPU supports.  mime_bench
+  times each of them over a header corpus.
+  -------------------------------------------------------------------------*/
+
+static const char *
+mime_find_char_memchr(const char *s, size_t n, char c)
+{
+  return static_cast<const char *>(memchr(s, c, n));
+}
+
+#if MIME_FIND_X86
+__attribute__ ((target("sse2")))
+static const char *
+mime_find_char_sse2(const char *s, size_t n, char c)
+{
+  const char *e = s + n;
+  __m128i needle = _mm_set1_epi8(c);
+
+  for (; e - s >= 16; s += 16) {
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) s), needle));
+    if (mask)
+      return s + __builtin_ctz(mask);
+  }
+  for (; s < e; ++s) {
+    if (*s == c)
+      return s;
+  }
+  return NULL;
+}
+
+__attribute__ ((target("avx2")))
+static const char *
+mime_find_char_avx2(const char *s, size_t n, char c)
+{
+  const char *e = s + n;
+  __m256i needle = _mm256_set1_epi8(c);
+
+  for (; e - s >= 32; s += 32) {
+    unsigned mask = (unsigned) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) s), needle));
+    if (mask)
+      return s + __builtin_ctz(mask);
+  }
+  if (e - s >= 16) {
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) s), _mm256_castsi256_si128(needle)));
+    if (mask)
+      return s + __builtin_ctz(mask);
+    s += 16;
+  }
+  for (; s < e; ++s) {
+    if (*s == c)
+      return s;
+  }
+  return NULL;
+}
+#endif
+
+static const struct
+{
+  const char *name;
+  MIMEFindCharFunc func;
+} mime_find_char_impls[] = {
+  // widest first
+#if MIME_FIND_X86
+  {"avx2", mime_find_char_avx2},
+  {"sse2", mime_find_char_sse2},
+#endif
+  {"memchr", mime_find_char_memchr},
+};
+
+MIMEFindCharFunc mime_find_char = mime_find_char_memchr;
+
+static bool
+mime_find_char_supported(MIMEFindCharFunc func)
+{
+#if MIME_FIND_X86
+  __builtin_cpu_init();
+  if (func == mime_find_char_avx2)
+    return __builtin_cpu_supports("avx2");
+  if (func == mime_find_char_sse2)
+    return __builtin_cpu_supports("sse2");
+#endif
+  return func == mime_find_char_memchr;
+}
+
+// Points mime_find_char at the named version, or at the widest one
+//   the CPU supports when impl is NULL; false if it cannot be used
+bool
+mime_find_char_select(const char *impl)
+{
+  for (unsigned i = 0; i < SIZEOF(mime_find_char_impls); i++) {
+    if (impl && strcmp(impl, mime_find_char_impls[i].name) != 0)
+      continue;
+    if (mime_find_char_supported(mime_find_char_impls[i].func)) {
+      mime_find_char = mime_find_char_impls[i].func;
+      return true;
+    }
+    if (impl)
+      return false;
+  }
+  return false;
+}
+
+const char *
+mime_find_char_name()
+{
+  for (unsigned i = 0; i < SIZEOF(mime_find_char_impls); i++) {
+    if (mime_find_char == mime_find_char_impls[i].func)
+      return mime_find_char_impls[i].name;
+  }
+  return NULL;
+}
+
 MIMEParseResult
 mime_scanner_get(MIMEScanner *S,
                  const char **raw_input_s,
@@ -2280,7 +2403,7 @@ mime_scanner_get(MIMEScanner *S,
       }
       break;
     case MIME_PARSE_INSIDE:
-      lf_ptr = static_cast<char const*>(memchr(raw_input_c, ParseRules::CHAR_LF, runway));
+      lf_ptr = mime_find_char(raw_input_c, runway, ParseRules::CHAR_LF);
       if (lf_ptr) {
         raw_input_c = lf_ptr + 1;
         if (MIME_SCANNER_TYPE_LINE == raw_input_scan_type) {
@@ -2448,7 +2571,7 @@ mime_parser_parse(MIMEParser *parser, HdrHeap *heap, MIMEHdrImpl *mh, const char
       continue;                 // toss away garbage line
 
     // find name last
-    colon = (char *) memchr(line_c, ':', (line_e - line_c));
+    colon = mime_find_char(line_c, line_e - line_c, ':');
     if (!colon)
       continue;                 // toss away garbage line
     field_name_last = colon - 1;
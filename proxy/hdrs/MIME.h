@@ -656,6 +656,13 @@ void mime_field_name_value_set(HdrHeap * heap, MIMEHdrImpl * mh, MIMEField * fie
 void mime_field_value_append(HdrHeap * heap, MIMEHdrImpl * mh, MIMEField * field,
                              const char *value, int length, bool prepend_comma, const char separator);
 
+// Finds the first c in the n bytes at s, or returns NULL.  mime_init()
+//   points it at the widest vector version the CPU supports.
+typedef const char *(*MIMEFindCharFunc) (const char *s, size_t n, char c);
+extern MIMEFindCharFunc mime_find_char;
+bool mime_find_char_select(const char *impl);
+const char *mime_find_char_name();
+
 void mime_scanner_init(MIMEScanner * scanner);
 void mime_scanner_clear(MIMEScanner * scanner);
 void mime_scanner_append(MIMEScanner * scanner, const char *data, int data_size);
@@ -0,0 +1,164 @@
+/** @file
+
+  Times MIME header parsing with each header line finder
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+/****************************************************************************
+
+   mime_bench.cc
+
+   Description:
+
+   Parses a corpus of request and response header blocks over and over
+   with each mime_find_char() version the CPU supports, and prints the
+   time per block.  Each file given on the command line is read as one
+   header block; without files a built-in set of real headers is used.
+
+
+ ****************************************************************************/
+
+#include "libts.h"
+#include "MIME.h"
+#include "HTTP.h"
+#include "Diags.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+
+static const char *builtin_corpus[] = {
+  "Host: www.example.com\r\n"
+  "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:17.0) Gecko/20100101 Firefox/17.0\r\n"
+  "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+  "Accept-Language: en-US,en;q=0.5\r\n"
+  "Accept-Encoding: gzip, deflate\r\n"
+  "Cookie: uid=0123456789abcdef0123456789abcdef; session=fedcba9876543210\r\n"
+  "Connection: keep-alive\r\n"
+  "If-Modified-Since: Tue, 04 Dec 2012 10:21:31 GMT\r\n"
+  "\r\n",
+  "Host: static.example.net\r\n"
+  "User-Agent: Mozilla/5.0 (Windows NT 6.1; WOW64) AppleWebKit/537.11 (KHTML, like Gecko) Chrome/23.0.1271.95 Safari/537.11\r\n"
+  "Accept: image/png,image/*;q=0.8,*/*;q=0.5\r\n"
+  "Referer: http://www.example.com/news/2012/12/04/index.html\r\n"
+  "Accept-Encoding: gzip,deflate,sdch\r\n"
+  "Accept-Language: en-GB,en-US;q=0.8,en;q=0.6\r\n"
+  "Accept-Charset: ISO-8859-1,utf-8;q=0.7,*;q=0.3\r\n"
+  "X-Forwarded-For: 192.0.2.17, 198.51.100.4\r\n"
+  "Connection: keep-alive\r\n"
+  "\r\n",
+  "Date: Tue, 04 Dec 2012 10:22:03 GMT\r\n"
+  "Server: Apache\r\n"
+  "Last-Modified: Tue, 04 Dec 2012 10:21:31 GMT\r\n"
+  "ETag: \"1e4b2-4d003bb3b8cc0\"\r\n"
+  "Accept-Ranges: bytes\r\n"
+  "Content-Length: 124082\r\n"
+  "Cache-Control: max-age=3600, public\r\n"
+  "Vary: Accept-Encoding\r\n"
+  "Content-Type: text/html; charset=UTF-8\r\n"
+  "\r\n",
+  "Date: Tue, 04 Dec 2012 10:22:04 GMT\r\n"
+  "Content-Type: image/png\r\n"
+  "Content-Length: 3407\r\n"
+  "Connection: keep-alive\r\n"
+  "Expires: Wed, 04 Dec 2013 10:22:04 GMT\r\n"
+  "Cache-Control: max-age=31536000\r\n"
+  "Set-Cookie: track=7f3e0c2a91b84d55; expires=Wed, 04-Dec-2013 10:22:04 GMT; path=/; domain=.example.net\r\n"
+  "Via: http/1.1 cache01.example.net (ApacheTrafficServer/3.3.0 [cMsSf ])\r\n"
+  "Age: 0\r\n"
+  "\r\n",
+};
+
+static char *
+load_block(const char *path)
+{
+  FILE *fp = fopen(path, "r");
+
+  if (fp == NULL) {
+    fprintf(stderr, "Could not open file %s : %s\n", path, strerror(errno));
+    exit(1);
+  }
+
+  int size = 0, len = 0;
+  char *block = NULL;
+
+  do {
+    size += 4096;
+    block = (char *)ats_realloc(block, size + 1);
+    len += fread(block + len, 1, size - len, fp);
+  } while (len == size);
+  block[len] = '\0';
+  fclose(fp);
+  return block;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  static const char *impls[] = { "memchr", "sse2", "avx2" };
+  const char **corpus = builtin_corpus;
+  int ncorpus = SIZEOF(builtin_corpus);
+  int rounds = 200000;
+
+  http_init();
+  diags = new Diags(NULL, NULL);
+  printf("mime_init() picked %s\n", mime_find_char_name());
+
+  if (argc > 1) {
+    corpus = (const char **)ats_malloc((argc - 1) * sizeof(char *));
+    for (ncorpus = 0; ncorpus < argc - 1; ncorpus++)
+      corpus[ncorpus] = load_block(argv[ncorpus + 1]);
+  }
+
+  for (unsigned i = 0; i < SIZEOF(impls); i++) {
+    if (!mime_find_char_select(impls[i])) {
+      printf("%-8s not supported\n", impls[i]);
+      continue;
+    }
+
+    MIMEParser parser;
+    ink_hrtime start, elapsed;
+    int fields = 0;
+
+    mime_parser_init(&parser);
+    start = ink_get_hrtime_internal();
+    for (int r = 0; r < rounds; r++) {
+      for (int c = 0; c < ncorpus; c++) {
+        MIMEHdr hdr;
+        const char *s = corpus[c];
+
+        hdr.create(NULL);
+        if (hdr.parse(&parser, &s, s + strlen(s), false, true) != PARSE_DONE) {
+          fprintf(stderr, "Header block %d did not parse\n", c);
+          exit(1);
+        }
+        fields += hdr.fields_count();
+        mime_parser_clear(&parser);
+        hdr.destroy();
+      }
+    }
+    elapsed = ink_get_hrtime_internal() - start;
+    mime_parser_clear(&parser);
+
+    printf("%-8s %8.1f ns per header block (%d fields)\n", impls[i],
+           (double) elapsed / ((double) rounds * ncorpus), fields / rounds);
+  }
+
+  return 0;
+}
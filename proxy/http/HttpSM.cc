@@ -5567,6 +5567,10 @@ HttpSM::setup_cache_read_transfer()
   if ( t_state.client_info.receive_chunked_response ) {
     tunnel.set_producer_chunking_action(p, client_response_hdr_bytes, TCA_CHUNK_CONTENT);
     tunnel.set_producer_chunking_size(p, t_state.txn_conf->http_chunking_size);
+  } else if (ua_session && ua_session->get_netvc()->is_zero_copy_capable()) {
+    // the body goes to the client untouched, so the cache may send large
+    // fragments straight from the disk
+    cache_sm.cache_read_vc->set_zero_copy();
   }
   ua_entry->in_tunnel = true;
   cache_sm.cache_read_vc = NULL;
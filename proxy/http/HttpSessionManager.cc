@@ -39,21 +39,270 @@
 #define FIRST_LEVEL_HASH(x)   ats_ip_hash(x) % HSM_LEVEL1_BUCKETS
 #define SECOND_LEVEL_HASH(x)  ats_ip_hash(x) % HSM_LEVEL2_BUCKETS
 
+#define SESSION_TABLE_MIN_SIZE  64
+#define SESSION_TABLE_TOMBSTONE ((HttpServerSession *) 1)
+
 // Initialize a thread to handle HTTP session management
 void
 initialize_thread_for_http_sessions(EThread *thread, int thread_index)
 {
   NOWARN_UNUSED(thread_index);
 
-  thread->l1_hash = NEW(new SessionBucket[HSM_LEVEL1_BUCKETS]);
-  for (int i = 0; i < HSM_LEVEL1_BUCKETS; ++i)
-    thread->l1_hash[i].mutex = new_ProxyMutex();
-  //thread->l1_hash[i].mutex = thread->mutex;
+  // ET_SSL may be the same threads as ET_NET
+  if (thread->server_session_pool)
+    return;
+  thread->server_session_pool = NEW(new ServerSessionPool);
+  httpSessionManager.add_thread_pool(thread->server_session_pool);
 }
 
 
 HttpSessionManager httpSessionManager;
 
+static inline uint32_t
+session_key_hash(sockaddr const* ip, INK_MD5 &hostname_hash)
+{
+  uint64_t h = hostname_hash.fold() ^ ats_ip_hash(ip) ^ ((uint64_t) ats_ip_port_cast(ip) << 32);
+  return (uint32_t) (h ^ (h >> 32));
+}
+
+static inline uint32_t
+session_vc_hash(NetVConnection *vc)
+{
+  uintptr_t h = (uintptr_t) vc;
+  h ^= h >> 17;
+  h *= 0x9E3779B1;
+  return (uint32_t) (h ^ (h >> 16));
+}
+
+ServerSessionTable::ServerSessionTable()
+  : slots(NULL), mask(0), n_used(0), n_live(0)
+{
+  rehash(SESSION_TABLE_MIN_SIZE);
+}
+
+ServerSessionTable::~ServerSessionTable()
+{
+  ats_free(slots);
+}
+
+void
+ServerSessionTable::rehash(uint32_t new_size)
+{
+  Slot *old_slots = slots;
+  uint32_t old_size = slots ? mask + 1 : 0;
+
+  slots = (Slot *)ats_malloc(new_size * sizeof(Slot));
+  memset(slots, 0, new_size * sizeof(Slot));
+  mask = new_size - 1;
+  n_used = n_live;
+
+  for (uint32_t i = 0; i < old_size; i++) {
+    if (old_slots[i].ss && old_slots[i].ss != SESSION_TABLE_TOMBSTONE) {
+      uint32_t pos = old_slots[i].hash & mask;
+      while (slots[pos].ss)
+        pos = (pos + 1) & mask;
+      slots[pos] = old_slots[i];
+    }
+  }
+  ats_free(old_slots);
+}
+
+void
+ServerSessionTable::insert(HttpServerSession *ss, uint32_t hash)
+{
+  // keep the load (including tombstones) under 1/2 so probe sequences stay short
+  if ((n_used + 1) * 2 > mask + 1) {
+    uint32_t size = mask + 1;
+    while ((n_live + 1) * 4 > size)
+      size <<= 1;
+    while (size > SESSION_TABLE_MIN_SIZE && (n_live + 1) * 8 < size)
+      size >>= 1;
+    rehash(size);
+  }
+
+  uint32_t pos = hash & mask;
+  while (slots[pos].ss && slots[pos].ss != SESSION_TABLE_TOMBSTONE)
+    pos = (pos + 1) & mask;
+  if (!slots[pos].ss)
+    n_used++;
+  slots[pos].ss = ss;
+  slots[pos].hash = hash;
+  n_live++;
+}
+
+void
+ServerSessionTable::remove(HttpServerSession *ss, uint32_t hash)
+{
+  uint32_t pos = hash & mask;
+
+  while (slots[pos].ss) {
+    if (slots[pos].ss == ss) {
+      slots[pos].ss = SESSION_TABLE_TOMBSTONE;
+      n_live--;
+      return;
+    }
+    pos = (pos + 1) & mask;
+  }
+  ink_assert(!"session not in table");
+}
+
+HttpServerSession *
+ServerSessionTable::first(uint32_t hash, uint32_t &pos) const
+{
+  pos = (hash & mask) - 1;
+  return next(hash, pos);
+}
+
+HttpServerSession *
+ServerSessionTable::next(uint32_t hash, uint32_t &pos) const
+{
+  for (pos = (pos + 1) & mask; slots[pos].ss; pos = (pos + 1) & mask) {
+    if (slots[pos].ss != SESSION_TABLE_TOMBSTONE && slots[pos].hash == hash)
+      return slots[pos].ss;
+  }
+  return NULL;
+}
+
+ServerSessionPool::ServerSessionPool()
+  : Continuation(new_ProxyMutex()), index(-1), n_sessions(0)
+{
+  SET_HANDLER(&ServerSessionPool::event_handler);
+}
+
+void
+ServerSessionPool::remove(HttpServerSession *ss)
+{
+  lru_list.remove(ss);
+  key_table.remove(ss, session_key_hash(&ss->server_ip.sa, ss->hostname_hash));
+  vc_table.remove(ss, session_vc_hash(ss->get_netvc()));
+  n_sessions--;
+}
+
+// HttpServerSession *ServerSessionPool::acquire(...)
+//
+//   Take an idle session to ip/hostname_hash out of the pool.
+//   The caller must hold the pool's mutex.
+//
+HttpServerSession *
+ServerSessionPool::acquire(sockaddr const* ip, INK_MD5 &hostname_hash)
+{
+  uint32_t pos;
+  uint32_t hash = session_key_hash(ip, hostname_hash);
+
+  for (HttpServerSession *ss = key_table.first(hash, pos); ss; ss = key_table.next(hash, pos)) {
+    if (ats_ip_addr_eq(&ss->server_ip.sa, ip) &&
+        ats_ip_port_cast(ip) == ats_ip_port_cast(&ss->server_ip) &&
+        hostname_hash == ss->hostname_hash) {
+      remove(ss);
+      ss->state = HSS_ACTIVE;
+      return ss;
+    }
+  }
+  return NULL;
+}
+
+// void ServerSessionPool::release(HttpServerSession *ss)
+//
+//   Put ss into the pool and make the pool the target of its IO, so
+//   we get called back (with the pool mutex held) if the origin closes.
+//   The caller must hold the pool's mutex.
+//
+void
+ServerSessionPool::release(HttpServerSession *ss)
+{
+  ss->state = HSS_KA_SHARED;
+  lru_list.enqueue(ss);
+  key_table.insert(ss, session_key_hash(&ss->server_ip.sa, ss->hostname_hash));
+  vc_table.insert(ss, session_vc_hash(ss->get_netvc()));
+  n_sessions++;
+
+  ss->do_io_read(this, INT64_MAX, ss->read_buffer);
+  ss->do_io_write(this, 0, NULL);
+
+  // we probably don't need the active timeout set, but will leave it for now
+  ss->get_netvc()->set_inactivity_timeout(ss->get_netvc()->get_inactivity_timeout());
+  ss->get_netvc()->set_active_timeout(ss->get_netvc()->get_active_timeout());
+}
+
+void
+ServerSessionPool::purge()
+{
+  while (lru_list.head) {
+    HttpServerSession *ss = lru_list.head;
+    remove(ss);
+    ss->do_io_close();
+  }
+}
+
+// int ServerSessionPool::event_handler(int event, void* data)
+//
+//   Called from the NetProcessor to let us know that a pooled
+//    connection has closed down or timed out
+//
+int
+ServerSessionPool::event_handler(int event, void *data)
+{
+  NetVConnection *net_vc = NULL;
+  HttpServerSession *s = NULL;
+  uint32_t pos;
+
+  switch (event) {
+  case VC_EVENT_READ_READY:
+    // The server sent us data.  This is unexpected so
+    //   close the connection
+    /* Fall through */
+  case VC_EVENT_EOS:
+  case VC_EVENT_ERROR:
+  case VC_EVENT_INACTIVITY_TIMEOUT:
+  case VC_EVENT_ACTIVE_TIMEOUT:
+    net_vc = (NetVConnection *) ((VIO *) data)->vc_server;
+    break;
+
+  default:
+    ink_release_assert(0);
+    return 0;
+  }
+
+  uint32_t hash = session_vc_hash(net_vc);
+  for (s = vc_table.first(hash, pos); s; s = vc_table.next(hash, pos)) {
+    if (s->get_netvc() == net_vc)
+      break;
+  }
+
+  if (s == NULL) {
+    // We failed to find our session.  This can only be the result
+    //  of a programming flaw
+    Warning("Connection leak from http keep-alive system");
+    ink_assert(0);
+    return 0;
+  }
+
+  // Keep the connection if closing it would take us under the minimum
+  // number of keep alive connections to this origin
+  if ((event == VC_EVENT_INACTIVITY_TIMEOUT || event == VC_EVENT_ACTIVE_TIMEOUT) &&
+      s->enable_origin_connection_limiting) {
+    HttpConfigParams *http_config_params = HttpConfig::acquire();
+    bool connection_count_below_min = s->connection_count->getCount(s->server_ip) <= http_config_params->origin_min_keep_alive_connections;
+    HttpConfig::release(http_config_params);
+
+    if (connection_count_below_min) {
+      Debug("http_ss", "[%" PRId64 "] [session_pool] session received io notice [%s], "
+            "reseting timeout to maintain minimum number of connections", s->con_id,
+            HttpDebugNames::get_event_name(event));
+      s->get_netvc()->set_inactivity_timeout(s->get_netvc()->get_inactivity_timeout());
+      s->get_netvc()->set_active_timeout(s->get_netvc()->get_active_timeout());
+      return 0;
+    }
+  }
+
+  Debug("http_ss", "[%" PRId64 "] [session_pool] session received io notice [%s]",
+        s->con_id, HttpDebugNames::get_event_name(event));
+  ink_assert(s->state == HSS_KA_SHARED);
+  remove(s);
+  s->do_io_close();
+  return 0;
+}
+
 SessionBucket::SessionBucket()
   : Continuation(NULL)
 {
@@ -154,12 +403,26 @@ HttpSessionManager::init()
   }
 }
 
+void
+HttpSessionManager::add_thread_pool(ServerSessionPool *pool)
+{
+  ink_release_assert(n_thread_pools < MAX_EVENT_THREADS);
+  pool->index = n_thread_pools;
+  thread_pools[n_thread_pools++] = pool;
+}
+
 // TODO: Should this really purge all keep-alive sessions?
 void
 HttpSessionManager::purge_keepalives()
 {
   EThread *ethread = this_ethread();
 
+  if (ethread->server_session_pool) {
+    MUTEX_TRY_LOCK(lock, ethread->server_session_pool->mutex, ethread);
+    if (lock)
+      ethread->server_session_pool->purge();
+  }
+
   for (int i = 0; i < HSM_LEVEL1_BUCKETS; i++) {
     SessionBucket *b = &g_l1_hash[i];
     MUTEX_TRY_LOCK(lock, b->mutex, ethread);
@@ -210,6 +473,38 @@ _acquire_session(SessionBucket *bucket, sockaddr const* ip, INK_MD5 &hostname_ha
   return HSM_NOT_FOUND;
 }
 
+// HSMresult_t HttpSessionManager::steal_session(...)
+//
+//   Our own pool has nothing for this origin, look for an idle
+//   session in the other threads' pools. We never wait for another
+//   pool's mutex, a pool that is busy is skipped. The session stays
+//   on the net thread that owns its connection, just as it does
+//   with the global pool.
+//
+HSMresult_t
+HttpSessionManager::steal_session(ServerSessionPool *own, sockaddr const* ip, INK_MD5 &hostname_hash, HttpSM *sm)
+{
+  EThread *ethread = this_ethread();
+
+  for (int i = 1; i < n_thread_pools; i++) {
+    ServerSessionPool *pool = thread_pools[(own->index + i) % n_thread_pools];
+
+    if (pool->count() == 0)
+      continue;
+    MUTEX_TRY_LOCK(lock, pool->mutex, ethread);
+    if (!lock)
+      continue;
+    HttpServerSession *ss = pool->acquire(ip, hostname_hash);
+    if (ss) {
+      Debug("http_ss", "[%" PRId64 "] [acquire session] return session from pool of thread %d", ss->con_id, pool->index);
+      RecIncrRawStat(http_rsb, ethread, (int) http_server_session_steals_stat, 1);
+      sm->attach_server_session(ss);
+      return HSM_DONE;
+    }
+  }
+  return HSM_NOT_FOUND;
+}
+
 HSMresult_t
 HttpSessionManager::acquire_session(Continuation *cont, sockaddr const* ip,
                                     const char *hostname, HttpClientSession *ua_session, HttpSM *sm)
@@ -270,8 +565,21 @@ HttpSessionManager::acquire_session(Continuation *cont, sockaddr const* ip,
     ink_code_MMH((unsigned char *) hostname, strlen(hostname), (unsigned char *) &hostname_hash);
 
   if (2 == sm->t_state.txn_conf->share_server_sessions) {
-    ink_assert(ethread->l1_hash);
-    return _acquire_session(ethread->l1_hash + l1_index, ip, hostname_hash, sm);
+    ServerSessionPool *pool = ethread->server_session_pool;
+
+    ink_assert(pool);
+    MUTEX_TRY_LOCK(lock, pool->mutex, ethread);
+    if (lock) {
+      to_return = pool->acquire(ip, hostname_hash);
+      if (to_return) {
+        Debug("http_ss", "[%" PRId64 "] [acquire session] " "return session from thread pool", to_return->con_id);
+        sm->attach_server_session(to_return);
+        return HSM_DONE;
+      }
+    }
+    if (sm->t_state.http_config_param->server_session_steal)
+      return steal_session(pool, ip, hostname_hash, sm);
+    return lock ? HSM_NOT_FOUND : HSM_RETRY;
   } else {
     SessionBucket *bucket = g_l1_hash + l1_index;
 
@@ -296,11 +604,21 @@ HttpSessionManager::release_session(HttpServerSession *to_release)
   ink_assert(l1_index < HSM_LEVEL1_BUCKETS);
 
   if (2 == to_release->share_session) {
-    bucket = ethread->l1_hash + l1_index;
-  } else {
-    bucket = g_l1_hash + l1_index;
+    ServerSessionPool *pool = ethread->server_session_pool;
+
+    ink_assert(pool);
+    MUTEX_TRY_LOCK(lock, pool->mutex, ethread);
+    if (lock) {
+      pool->release(to_release);
+      Debug("http_ss", "[%" PRId64 "] [release session] " "session placed into thread pool", to_release->con_id);
+      return HSM_DONE;
+    }
+    Debug("http_ss", "[%" PRId64 "] [release session] could not release session due to lock contention", to_release->con_id);
+    return HSM_RETRY;
   }
 
+  bucket = g_l1_hash + l1_index;
+
   MUTEX_TRY_LOCK(lock, bucket->mutex, ethread);
   if (lock) {
     int l2_index = SECOND_LEVEL_HASH(&to_release->server_ip.sa);
@@ -60,6 +60,75 @@ public:
   DList(HttpServerSession, hash_link) l2_hash[HSM_LEVEL2_BUCKETS];
 };
 
+/** Open addressing table of idle server sessions.
+
+    Each slot caches the hash it was inserted with, so lookups skip
+    non-matching entries without touching the session and the table can
+    be rehashed without recomputing anything. Deleted slots are marked
+    with a tombstone until the next rehash.
+*/
+class ServerSessionTable
+{
+public:
+  ServerSessionTable();
+  ~ServerSessionTable();
+
+  void insert(HttpServerSession *ss, uint32_t hash);
+  void remove(HttpServerSession *ss, uint32_t hash);
+
+  /// Walk the sessions inserted with @a hash, @a pos is the iterator.
+  HttpServerSession *first(uint32_t hash, uint32_t &pos) const;
+  HttpServerSession *next(uint32_t hash, uint32_t &pos) const;
+
+private:
+  struct Slot
+  {
+    HttpServerSession *ss;
+    uint32_t hash;
+  };
+
+  void rehash(uint32_t new_size);
+
+  Slot *slots;
+  uint32_t mask;                // number of slots - 1, number of slots is a power of 2
+  uint32_t n_used;              // live entries + tombstones
+  uint32_t n_live;
+};
+
+/** Idle server sessions of one event thread (share_server_sessions == 2).
+
+    Sessions are found by (ip, port, hostname hash) when they are
+    acquired and by their NetVConnection when the origin closes them.
+    The pool's mutex is the mutex of the read VIO of every session it
+    holds, so another thread that try-locks it can take sessions out
+    of the pool (see HttpSessionManager::acquire_session).
+*/
+class ServerSessionPool: public Continuation
+{
+public:
+  ServerSessionPool();
+  int event_handler(int event, void *data);
+
+  HttpServerSession *acquire(sockaddr const* ip, INK_MD5 &hostname_hash);
+  void release(HttpServerSession *ss);
+  void purge();
+
+  int count() const
+  {
+    return n_sessions;
+  }
+
+  int index;                    // position in HttpSessionManager::thread_pools
+
+private:
+  void remove(HttpServerSession *ss);
+
+  ServerSessionTable key_table;
+  ServerSessionTable vc_table;
+  Que(HttpServerSession, lru_link) lru_list;
+  volatile int n_sessions;
+};
+
 enum HSMresult_t
 { HSM_DONE, HSM_RETRY, HSM_NOT_FOUND };
 
@@ -67,6 +136,7 @@ class HttpSessionManager
 {
 public:
   HttpSessionManager()
+    : n_thread_pools(0)
     { }
 
   ~HttpSessionManager()
@@ -79,10 +149,17 @@ public:
   void purge_keepalives();
   void init();
   int main_handler(int event, void *data);
+  void add_thread_pool(ServerSessionPool *pool);
 
 private:
+  HSMresult_t steal_session(ServerSessionPool *own, sockaddr const* ip, INK_MD5 &hostname_hash, HttpSM *sm);
+
   //    Global l1 hash, used when there is no per-thread buckets
   SessionBucket g_l1_hash[HSM_LEVEL1_BUCKETS];
+
+  //    Per-thread pools, used when share_server_sessions is 2
+  ServerSessionPool *thread_pools[MAX_EVENT_THREADS];
+  int n_thread_pools;
 };
 
 extern HttpSessionManager httpSessionManager;
@@ -1217,6 +1217,7 @@ public:
 
       ParentConfig::release(parent_params);
       parent_params = NULL;
+      request_data.clear_match_string();
 
       hdr_info.client_request.destroy();
       hdr_info.client_response.destroy();
@@ -29,6 +29,8 @@
 #include "time.h"
 #include "HTTP.h"
 #include "HttpCompat.h"
+#include "HdrUtils.h"
+#include "Regression.h"
 #include "Error.h"
 #include "InkErrno.h"
 
@@ -164,6 +166,107 @@ is_empty(char *s)
   @return index in cache alternates vector.
 
 */
+/**
+  Hashes the values the request has for the headers in vary_list the way
+  HttpCompat::do_header_values_rfc2068_14_43_match() compares them: split
+  on commas without the surrounding white space, lower cased and cut at
+  the first terminator. Requests whose Vary headers match always get the
+  same key. Keys can also collide, so equal keys prove nothing and the
+  alternate still goes through calculate_quality_of_match().
+
+  @return false if the list has a field that CalcVariability() treats
+  specially under http_config_params, so no key applies.
+
+*/
+static bool
+hash_vary_values(CacheLookupHttpConfig * http_config_params, HTTPHdr * request, StrList * vary_list, int32_t * key)
+{
+  uint32_t h = 2166136261U;     // FNV-1a
+
+  for (Str * field = vary_list->head; field != NULL; field = field->next) {
+    if (field->len == 0)
+      continue;
+
+    if ((field->str[0] == '*') && (field->str[1] == NUL))
+      return false;
+    if (http_config_params != NULL &&
+        ((http_config_params->cache_global_user_agent_header &&
+          !ink_string_fast_strcasecmp((char *) field->str, "User-Agent")) ||
+         (http_config_params->ignore_accept_encoding_mismatch &&
+          !ink_string_fast_strcasecmp((char *) field->str, "Accept-Encoding"))))
+      return false;
+
+    const char *field_name_str = hdrtoken_string_to_wks(field->str, field->len);
+    if (field_name_str == NULL)
+      field_name_str = field->str;
+
+    MIMEField *hdr_field = request->field_find(field_name_str, field->len);
+
+    // a missing header only matches a missing one, not an empty one
+    h = (h ^ (hdr_field ? 1 : 0)) * 16777619U;
+    if (hdr_field) {
+      HdrCsvIter iter;
+      int len;
+
+      for (const char *val = iter.get_first(hdr_field, &len); val; val = iter.get_next(&len)) {
+        for (int j = 0; j < len && !ParseRules::is_eow(val[j]); j++)
+          h = (h ^ (uint8_t) ParseRules::ink_tolower(val[j])) * 16777619U;
+        h = (h ^ ',') * 16777619U;
+      }
+    }
+  }
+
+  *key = (h == (uint32_t) -1) ? 0 : (int32_t) h;
+  return true;
+}
+
+/**
+  The client request's key for the Vary value last seen. The alternates
+  of an object nearly always carry the same Vary, so the request headers
+  are hashed once per lookup rather than once per alternate.
+
+*/
+struct VariantKeyCache
+{
+  const char *vary;
+  int vary_len;
+  bool valid;
+  int32_t key;
+
+  VariantKeyCache():vary(NULL), vary_len(0), valid(false), key(-1) { }
+};
+
+static bool
+request_variant_key(CacheLookupHttpConfig * http_config_params, HTTPHdr * client_request,
+                    HTTPHdr * obj_origin_server_response, VariantKeyCache * cache, int32_t * key)
+{
+  MIMEField *vary_field = obj_origin_server_response->field_find(MIME_FIELD_VARY, MIME_LEN_VARY);
+  const char *vary;
+  int vary_len;
+  bool cacheable, valid;
+  StrList vary_list;
+
+  if (vary_field == NULL)
+    return false;
+
+  vary = vary_field->value_get(&vary_len);
+  cacheable = !vary_field->has_dups();
+  if (cacheable && cache->vary != NULL && vary_len == cache->vary_len && memcmp(vary, cache->vary, vary_len) == 0) {
+    *key = cache->key;
+    return cache->valid;
+  }
+
+  valid = obj_origin_server_response->value_get_comma_list(MIME_FIELD_VARY, MIME_LEN_VARY, &vary_list) > 0 &&
+    hash_vary_values(http_config_params, client_request, &vary_list, key);
+  if (cacheable) {
+    cache->vary = vary;
+    cache->vary_len = vary_len;
+    cache->valid = valid;
+    cache->key = valid ? *key : -1;
+  }
+  return valid;
+}
+
 int
 HttpTransactCache::SelectFromAlternates(CacheHTTPInfoVector * cache_vector,
                                         HTTPHdr * client_request, CacheLookupHttpConfig * http_config_params)
@@ -200,6 +303,14 @@ HttpTransactCache::SelectFromAlternates(CacheHTTPInfoVector * cache_vector,
     return 0;
   }
 
+  // An alternate whose variant key differs from the request's would be
+  // rejected by CalcVariability(), so it is skipped without scoring.
+  // PURGE and SELECT_ALT plugins can accept any alternate, and with a
+  // single alternate there is nothing to gain.
+  bool use_variant_keys = alt_count > 1 && client_request->method_get_wksidx() != HTTP_WKSIDX_PURGE &&
+    !http_global_hooks->get(TS_HTTP_SELECT_ALT_HOOK);
+  VariantKeyCache request_key;
+
   for (int i = 0; i < alt_count; i++) {
     float Q;
     CacheHTTPInfo *obj = cache_vector->get(i);
@@ -210,6 +321,17 @@ HttpTransactCache::SelectFromAlternates(CacheHTTPInfoVector * cache_vector,
       ink_debug_assert(cached_request->valid());
       ink_debug_assert(cached_response->valid());
 
+      if (use_variant_keys && obj->variant_key_get() != -1 && cached_response->status_get() == HTTP_STATUS_OK) {
+        int32_t key;
+
+        if (request_variant_key(http_config_params, client_request, cached_response, &request_key, &key) &&
+            key != obj->variant_key_get()) {
+          Debug("http_match", "[SelectFromAlternates] alternate #%d skipped, variant key %d != %d",
+                i + 1, obj->variant_key_get(), key);
+          continue;
+        }
+      }
+
       Q = calculate_quality_of_match(http_config_params, client_request, cached_request, cached_response);
 
       if (alt_count > 1) {
@@ -1282,6 +1404,28 @@ HttpTransactCache::CalcVariability(CacheLookupHttpConfig * http_config_params,
   return (variability);
 }
 
+/**
+  Computes the variant key stored with an alternate: a hash of the values
+  its request had for the headers named in the response's Vary. Returns
+  -1 if the response has no Vary or varies on '*', in which case the
+  alternate is always scored in full.
+
+*/
+int32_t
+HttpTransactCache::CalcVariantKey(HTTPHdr * obj_client_request, HTTPHdr * obj_origin_server_response)
+{
+  StrList vary_list;
+  int32_t key;
+
+  if (!obj_client_request->valid() || !obj_origin_server_response->valid() ||
+      !obj_origin_server_response->presence(MIME_PRESENCE_VARY))
+    return -1;
+  if (obj_origin_server_response->value_get_comma_list(MIME_FIELD_VARY, MIME_LEN_VARY, &vary_list) <= 0 ||
+      !hash_vary_values(NULL, obj_client_request, &vary_list, &key))
+    return -1;
+  return key;
+}
+
 /**
   If the request has If-modified-since or If-none-match,
   HTTP_STATUS_NOT_MODIFIED is returned if both or the existing one
@@ -1564,3 +1708,100 @@ CacheLookupHttpConfig::unmarshal(Arena * arena, const char *buf, int buflen)
 
   return (p - buf);
 }
+
+static void
+variant_test_request(HTTPHdr * h, const char *accept_encoding, const char *accept_language)
+{
+  h->create(HTTP_TYPE_REQUEST);
+  h->method_set(HTTP_METHOD_GET, HTTP_LEN_GET);
+  if (accept_encoding)
+    h->value_set(MIME_FIELD_ACCEPT_ENCODING, MIME_LEN_ACCEPT_ENCODING, accept_encoding, strlen(accept_encoding));
+  if (accept_language)
+    h->value_set(MIME_FIELD_ACCEPT_LANGUAGE, MIME_LEN_ACCEPT_LANGUAGE, accept_language, strlen(accept_language));
+}
+
+REGRESSION_TEST(HttpTransactCache_VariantKey) (RegressionTest * t, int atype, int *pstatus)
+{
+  NOWARN_UNUSED(atype);
+  *pstatus = REGRESSION_TEST_PASSED;
+
+  static const struct
+  {
+    const char *accept_encoding;
+    const char *accept_language;
+  } alts[] = {
+    { "gzip", "en" },
+    { "gzip", "fr" },
+    { NULL, "en" },
+    { "gzip, deflate", "en, fr;q=0.5" },
+    { "deflate", NULL },
+  };
+  static const struct
+  {
+    const char *accept_encoding;
+    const char *accept_language;
+    int expected;
+  } requests[] = {
+    { "gzip", "fr", 1 },
+    { "GZIP", "En", 0 },
+    { NULL, "en", 2 },
+    { "gzip,deflate", "en ,fr;q=0.5", 3 },
+    { "deflate", NULL, 4 },
+    { "gzip", "de", -1 },
+    { "deflate", "en", -1 },
+  };
+  const int n_alts = sizeof(alts) / sizeof(alts[0]);
+
+  CacheLookupHttpConfig config;
+  CacheHTTPInfoVector vector;
+  int32_t keys[n_alts];
+
+  for (int i = 0; i < n_alts; i++) {
+    HTTPHdr req, resp;
+    CacheHTTPInfo info;
+    INK_MD5 md5;
+
+    variant_test_request(&req, alts[i].accept_encoding, alts[i].accept_language);
+    resp.create(HTTP_TYPE_RESPONSE);
+    resp.status_set(HTTP_STATUS_OK);
+    resp.value_set(MIME_FIELD_VARY, MIME_LEN_VARY, "Accept-Encoding, Accept-Language", 32);
+
+    info.create();
+    info.request_set(&req);
+    info.response_set(&resp);
+    md5.encodeBuffer((char *) &i, sizeof(i));
+    info.object_key_set(md5);
+    keys[i] = HttpTransactCache::CalcVariantKey(info.request_get(), info.response_get());
+    info.variant_key_set(keys[i]);
+    vector.insert(&info);
+    req.destroy();
+    resp.destroy();
+
+    if (keys[i] == -1) {
+      rprintf(t, "alternate %d has no variant key\n", i);
+      *pstatus = REGRESSION_TEST_FAILED;
+    }
+  }
+
+  for (unsigned r = 0; r < sizeof(requests) / sizeof(requests[0]); r++) {
+    HTTPHdr req;
+    int with_keys, without_keys;
+
+    variant_test_request(&req, requests[r].accept_encoding, requests[r].accept_language);
+    with_keys = HttpTransactCache::SelectFromAlternates(&vector, &req, &config);
+    for (int i = 0; i < n_alts; i++)
+      vector.get(i)->variant_key_set(-1);
+    without_keys = HttpTransactCache::SelectFromAlternates(&vector, &req, &config);
+    for (int i = 0; i < n_alts; i++)
+      vector.get(i)->variant_key_set(keys[i]);
+    req.destroy();
+
+    if (with_keys != requests[r].expected || without_keys != requests[r].expected) {
+      rprintf(t, "request %u selected alternate %d with variant keys, %d without, expected %d\n",
+              r, with_keys, without_keys, requests[r].expected);
+      *pstatus = REGRESSION_TEST_FAILED;
+    }
+  }
+
+  vector.clear();
+}
@@ -136,6 +136,8 @@ public:
                                        HTTPHdr * obj_origin_server_response     // in
     );
 
+  static int32_t CalcVariantKey(HTTPHdr * obj_client_request, HTTPHdr * obj_origin_server_response);
+
   static HTTPStatus match_response_to_request_conditionals(HTTPHdr * ua_request, HTTPHdr * c_response);
 
 };
@@ -0,0 +1,456 @@
+/** @file
+
+    Literal prefilter for regex_map host patterns
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+#include "UrlMappingRegexIndex.h"
+#include "Regression.h"
+
+#ifdef HAVE_PCRE_PCRE_H
+#include <pcre/pcre.h>
+#else
+#include <pcre.h>
+#endif
+
+UrlMappingRegexIndex::UrlMappingRegexIndex()
+  : m_n(0), m_unindexed(NULL), m_next(NULL), m_table(NULL), m_table_mask(0)
+{ }
+
+UrlMappingRegexIndex::~UrlMappingRegexIndex()
+{
+  ats_free(m_unindexed);
+  ats_free(m_next);
+  ats_free(m_table);
+}
+
+UrlMappingRegexIndex::GramEntry *
+UrlMappingRegexIndex::_find(uint32_t gram) const
+{
+  for (uint32_t slot = _hash(gram) & m_table_mask; m_table[slot].first >= 0; slot = (slot + 1) & m_table_mask) {
+    if (m_table[slot].gram == gram)
+      return &m_table[slot];
+  }
+  return NULL;
+}
+
+void
+UrlMappingRegexIndex::Build(const char * const *literals, const int *literal_lens, int n)
+{
+  ink_assert(m_n == 0);
+
+  m_n = n;
+  m_unindexed = (uint64_t *)ats_calloc(CandidateWords() + 1, sizeof(uint64_t));
+  m_next = (int *)ats_malloc((n + 1) * sizeof(int));
+
+  // count how often each window occurs over all literals, so every
+  // pattern can be filed under its least common window and no bucket
+  // ends up holding e.g. every pattern ending in ".com"
+  int n_windows = 0;
+  for (int i = 0; i < n; ++i) {
+    if (literal_lens[i] >= GRAM_LEN)
+      n_windows += literal_lens[i] - GRAM_LEN + 1;
+  }
+
+  uint32_t count_size = 16;
+  while (count_size < 2U * n_windows)
+    count_size <<= 1;
+  GramEntry *counts = (GramEntry *)ats_malloc(count_size * sizeof(GramEntry));
+  for (uint32_t s = 0; s < count_size; ++s)
+    counts[s].first = -1;
+
+  for (int i = 0; i < n; ++i) {
+    for (int p = 0; p + GRAM_LEN <= literal_lens[i]; ++p) {
+      uint32_t gram = _gram(literals[i] + p);
+      uint32_t slot = _hash(gram) & (count_size - 1);
+      while (counts[slot].first >= 0 && counts[slot].gram != gram)
+        slot = (slot + 1) & (count_size - 1);
+      if (counts[slot].first < 0) {
+        counts[slot].gram = gram;
+        counts[slot].first = 0;
+      }
+      ++counts[slot].first;
+    }
+  }
+
+  uint32_t table_size = 16;
+  while (table_size < 2U * n)
+    table_size <<= 1;
+  m_table_mask = table_size - 1;
+  m_table = (GramEntry *)ats_malloc(table_size * sizeof(GramEntry));
+  int *tails = (int *)ats_malloc(table_size * sizeof(int));
+  for (uint32_t s = 0; s < table_size; ++s)
+    m_table[s].first = -1;
+
+  int n_unindexed = 0;
+  for (int i = 0; i < n; ++i) {
+    m_next[i] = -1;
+    if (literal_lens[i] < GRAM_LEN) {
+      m_unindexed[i / 64] |= (uint64_t) 1 << (i % 64);
+      ++n_unindexed;
+      continue;
+    }
+
+    uint32_t best = 0;
+    int best_count = INT_MAX;
+    for (int p = 0; p + GRAM_LEN <= literal_lens[i]; ++p) {
+      uint32_t gram = _gram(literals[i] + p);
+      uint32_t slot = _hash(gram) & (count_size - 1);
+      while (counts[slot].gram != gram)
+        slot = (slot + 1) & (count_size - 1);
+      if (counts[slot].first < best_count) {
+        best_count = counts[slot].first;
+        best = gram;
+      }
+    }
+
+    // patterns are added in rank order, so appending keeps every chain
+    // sorted by rank
+    uint32_t slot = _hash(best) & m_table_mask;
+    while (m_table[slot].first >= 0 && m_table[slot].gram != best)
+      slot = (slot + 1) & m_table_mask;
+    if (m_table[slot].first < 0) {
+      m_table[slot].gram = best;
+      m_table[slot].first = i;
+    } else {
+      m_next[tails[slot]] = i;
+    }
+    tails[slot] = i;
+  }
+
+  ats_free(tails);
+  ats_free(counts);
+
+  Debug("url_rewrite_regex", "Indexed %d regex mappings, %d without a usable literal", n, n_unindexed);
+}
+
+void
+UrlMappingRegexIndex::Candidates(const char *host, int host_len, uint64_t *candidates) const
+{
+  memcpy(candidates, m_unindexed, CandidateWords() * sizeof(uint64_t));
+
+  for (int p = 0; p + GRAM_LEN <= host_len; ++p) {
+    GramEntry *e = _find(_gram(host + p));
+    if (e) {
+      for (int i = e->first; i >= 0; i = m_next[i])
+        candidates[i / 64] |= (uint64_t) 1 << (i % 64);
+    }
+  }
+}
+
+/**
+  Walk the top level of the pattern, collecting runs of literal
+  characters.  Anything we do not fully understand ends the current run,
+  which can only make the literal shorter, never wrong: groups, classes
+  and escapes such as \x2e are skipped whole with their operands, a
+  character followed by a quantifier that allows zero repetitions is
+  dropped, and a top level alternation or an inline option means there
+  is no literal at all.
+*/
+int
+UrlMappingRegexIndex::RequiredLiteral(const char *pattern, char *buf, int buf_size)
+{
+  int best_start = 0, best_len = 0;
+  int run_start = 0, len = 0;   // current run is buf[run_start, len)
+  int pattern_len = strlen(pattern);
+
+  if (strstr(pattern, "(?"))
+    return 0;
+
+#define END_RUN() do { \
+    if (len - run_start > best_len) { best_start = run_start; best_len = len - run_start; } \
+    run_start = len; \
+  } while (0)
+
+  for (int i = 0; i < pattern_len; ++i) {
+    char c = pattern[i];
+    bool literal = false;
+
+    switch (c) {
+    case '|':
+      return 0;
+    case '\\':
+      if (i + 1 < pattern_len && !ParseRules::is_alnum(pattern[i + 1])) {
+        c = pattern[++i];
+        literal = true;
+      } else if (++i < pattern_len) {
+        // \d, \w, \b, back references ...: none is literal, and the
+        // operand of those that take one is not literal text either
+        switch (pattern[i]) {
+        case 'x':
+        case 'o':
+        case 'p':
+        case 'P':
+        case 'N':
+        case 'g':
+        case 'k':
+          if (i + 1 < pattern_len && (pattern[i + 1] == '{' || pattern[i + 1] == '<' || pattern[i + 1] == '\'')) {
+            char close = pattern[i + 1] == '{' ? '}' : pattern[i + 1] == '<' ? '>' : '\'';
+            while (++i < pattern_len && pattern[i] != close)
+              ;
+          } else if (pattern[i] == 'x') {
+            for (int n = 0; n < 2 && i + 1 < pattern_len && ParseRules::is_hex(pattern[i + 1]); ++n)
+              ++i;
+          } else if (pattern[i] == 'p' || pattern[i] == 'P') {
+            ++i;                // \pL
+          } else if (pattern[i] == 'g') {
+            if (i + 1 < pattern_len && pattern[i + 1] == '-')
+              ++i;
+            while (i + 1 < pattern_len && ParseRules::is_digit(pattern[i + 1]))
+              ++i;
+          }
+          break;
+        case 'c':
+          ++i;                  // \cX
+          break;
+        default:
+          // \0nn octal, \nn back reference
+          if (ParseRules::is_digit(pattern[i])) {
+            while (i + 1 < pattern_len && ParseRules::is_digit(pattern[i + 1]))
+              ++i;
+          }
+          break;
+        }
+      }
+      break;
+    case '[':
+      // skip the class; ']' right after '[' or '[^' is a member
+      ++i;
+      if (i < pattern_len && pattern[i] == '^')
+        ++i;
+      if (i < pattern_len && pattern[i] == ']')
+        ++i;
+      while (i < pattern_len && pattern[i] != ']') {
+        if (pattern[i] == '\\')
+          ++i;
+        ++i;
+      }
+      break;
+    case '(': {
+      int depth = 1;
+      while (++i < pattern_len && depth > 0) {
+        if (pattern[i] == '\\')
+          ++i;
+        else if (pattern[i] == '(')
+          ++depth;
+        else if (pattern[i] == ')')
+          --depth;
+      }
+      --i;
+      break;
+    }
+    case '*':
+    case '?':
+    case '{':
+    case '+':
+      // quantifier on the previous atom; if that was the last character
+      // of the run it may be absent (or repeated, for '+')
+      if (c != '+' && len > run_start)
+        --len;
+      if (c == '{') {
+        while (i < pattern_len && pattern[i] != '}')
+          ++i;
+      }
+      if (i + 1 < pattern_len && (pattern[i + 1] == '?' || pattern[i + 1] == '+'))
+        ++i;                    // lazy / possessive
+      break;
+    case '.':
+    case '^':
+    case '$':
+    case ')':
+      break;
+    default:
+      literal = true;
+      break;
+    }
+
+    if (literal && len < buf_size) {
+      // a quantifier may still remove this character, see above
+      buf[len++] = c;
+    } else {
+      END_RUN();
+    }
+  }
+  END_RUN();
+
+#undef END_RUN
+
+  memmove(buf, buf + best_start, best_len);
+  return best_len;
+}
+
+/*-------------------------------------------------------------------------
+  Regression: check the literal extraction, then check that the index
+  picks the same first match as a linear scan over 5000 host regexes, and
+  report how long each takes.
+  -------------------------------------------------------------------------*/
+
+struct RegexIndexTestRule
+{
+  pcre *re;
+  pcre_extra *re_extra;
+  char literal[256];
+  int literal_len;
+};
+
+static int
+regex_index_linear_match(RegexIndexTestRule *rules, int n, const char *host, int host_len)
+{
+  int ovector[30];
+
+  for (int i = 0; i < n; ++i) {
+    if (pcre_exec(rules[i].re, rules[i].re_extra, host, host_len, 0, 0, ovector, 30) > 0)
+      return i;
+  }
+  return -1;
+}
+
+static int
+regex_index_indexed_match(UrlMappingRegexIndex &index, RegexIndexTestRule *rules, const char *host, int host_len,
+                          uint64_t *candidates)
+{
+  int ovector[30];
+
+  index.Candidates(host, host_len, candidates);
+  for (int w = 0; w < index.CandidateWords(); ++w) {
+    for (uint64_t bits = candidates[w]; bits; bits &= bits - 1) {
+      int i = w * 64 + __builtin_ctzll(bits);
+      if (pcre_exec(rules[i].re, rules[i].re_extra, host, host_len, 0, 0, ovector, 30) > 0)
+        return i;
+    }
+  }
+  return -1;
+}
+
+REGRESSION_TEST(UrlMappingRegexIndex) (RegressionTest * t, int atype, int *pstatus)
+{
+  NOWARN_UNUSED(atype);
+  *pstatus = REGRESSION_TEST_PASSED;
+
+  static const struct
+  {
+    const char *pattern;
+    const char *literal;
+  } literal_tests[] = {
+    { "(.*)\\.example\\.com", ".example.com" },
+    { "^www[0-9]+\\.foo\\.net$", ".foo.net" },
+    { "^(www|cdn)\\.bar\\.org$", ".bar.org" },
+    { "colou?r-images", "r-images" },
+    { "ab+cd", "ab" },
+    { "abc+d", "abc" },
+    { "a{2}bcd", "bcd" },
+    { "[.a-z]+static[0-9]*\\.img", "static" },
+    { "foo|bar", "" },
+    { "(?i)mixedcase", "" },
+    { "\\d+\\.cdn\\.com", ".cdn.com" },
+    { "foo\\x2ebar\\.com", "bar.com" },
+    { "foo\\x{2e}bar\\.com", "bar.com" },
+    { "img\\d\\.cdn\\.com", ".cdn.com" },
+    { "a\\p{Lu}bcd", "bcd" },
+    { "a\\pLbcd", "bcd" },
+    { "ab\\012cdef", "cdef" },
+    { "abcd\\cMef", "abcd" },
+  };
+
+  for (unsigned i = 0; i < sizeof(literal_tests) / sizeof(literal_tests[0]); ++i) {
+    char buf[256];
+    int len = UrlMappingRegexIndex::RequiredLiteral(literal_tests[i].pattern, buf, sizeof(buf));
+    if (len != (int)strlen(literal_tests[i].literal) || memcmp(buf, literal_tests[i].literal, len) != 0) {
+      buf[len] = '\0';       // rprintf() has no %.*s
+      rprintf(t, "literal of [%s] is [%s], expected [%s]\n", literal_tests[i].pattern, buf, literal_tests[i].literal);
+      *pstatus = REGRESSION_TEST_FAILED;
+    }
+  }
+
+  // a multi-tenant style configuration: mostly per-tenant suffixes, with
+  // a few patterns that have no usable literal sprinkled in
+  const int n_rules = 5000;
+  RegexIndexTestRule *rules = (RegexIndexTestRule *)ats_malloc(n_rules * sizeof(RegexIndexTestRule));
+  const char **literals = (const char **)ats_malloc(n_rules * sizeof(char *));
+  int *literal_lens = (int *)ats_malloc(n_rules * sizeof(int));
+
+  for (int i = 0; i < n_rules; ++i) {
+    char pattern[256];
+    const char *err;
+    int err_offset;
+
+    if (i % 500 == 499)
+      snprintf(pattern, sizeof(pattern), "^[a-z]+%d[a-z]?$", i);
+    else
+      snprintf(pattern, sizeof(pattern), "^([a-z0-9-]+)\\.tenant%d\\.example\\.com$", i);
+    rules[i].re = pcre_compile(pattern, 0, &err, &err_offset, NULL);
+    rules[i].re_extra = rules[i].re ? pcre_study(rules[i].re, 0, &err) : NULL;
+    rules[i].literal_len = UrlMappingRegexIndex::RequiredLiteral(pattern, rules[i].literal, sizeof(rules[i].literal));
+    literals[i] = rules[i].literal;
+    literal_lens[i] = rules[i].literal_len;
+    if (!rules[i].re) {
+      rprintf(t, "could not compile [%s]\n", pattern);
+      *pstatus = REGRESSION_TEST_FAILED;
+    }
+  }
+
+  if (*pstatus == REGRESSION_TEST_PASSED) {
+    UrlMappingRegexIndex index;
+    uint64_t *candidates = (uint64_t *)ats_malloc(((n_rules + 63) / 64) * sizeof(uint64_t));
+    const int n_hosts = 200;
+    char hosts[n_hosts][128];
+    int host_lens[n_hosts];
+    int expected[n_hosts];
+
+    index.Build(literals, literal_lens, n_rules);
+
+    for (int h = 0; h < n_hosts; ++h) {
+      if (h % 4 == 3)
+        host_lens[h] = snprintf(hosts[h], sizeof(hosts[h]), "www.unknown%d.example.org", h);
+      else if (h % 10 == 5)
+        host_lens[h] = snprintf(hosts[h], sizeof(hosts[h]), "abc%d", (h * 97 % 10) * 500 + 499);
+      else
+        host_lens[h] = snprintf(hosts[h], sizeof(hosts[h]), "img-%d.tenant%d.example.com", h, (h * 7919) % n_rules);
+    }
+
+    ink_hrtime start = ink_get_hrtime_internal();
+    for (int h = 0; h < n_hosts; ++h)
+      expected[h] = regex_index_linear_match(rules, n_rules, hosts[h], host_lens[h]);
+    ink_hrtime linear = ink_get_hrtime_internal() - start;
+
+    start = ink_get_hrtime_internal();
+    for (int h = 0; h < n_hosts; ++h) {
+      int got = regex_index_indexed_match(index, rules, hosts[h], host_lens[h], candidates);
+      if (got != expected[h]) {
+        rprintf(t, "host [%s] matched rule %d with the index, %d without\n", hosts[h], got, expected[h]);
+        *pstatus = REGRESSION_TEST_FAILED;
+      }
+    }
+    ink_hrtime indexed = ink_get_hrtime_internal() - start;
+
+    rprintf(t, "%d hosts against %d regexes: linear %d us, indexed %d us\n",
+            n_hosts, n_rules, (int)(linear / HRTIME_USECOND), (int)(indexed / HRTIME_USECOND));
+    ats_free(candidates);
+  }
+
+  for (int i = 0; i < n_rules; ++i) {
+    if (rules[i].re)
+      pcre_free(rules[i].re);
+    if (rules[i].re_extra)
+      pcre_free(rules[i].re_extra);
+  }
+  ats_free(literal_lens);
+  ats_free(literals);
+  ats_free(rules);
+}
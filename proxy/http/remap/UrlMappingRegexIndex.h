@@ -0,0 +1,92 @@
+/** @file
+
+    Literal prefilter for regex_map host patterns
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+#ifndef _URL_MAPPING_REGEX_INDEX_H
+#define _URL_MAPPING_REGEX_INDEX_H
+
+#include "libts.h"
+
+/**
+   Index over the host regexes of a list of regex mappings, used to avoid
+   running every regex against every request host.
+
+   For each pattern we extract a literal string that any matching host
+   must contain, and file the pattern under the rarest 4-byte window of
+   that literal.  A lookup slides a window over the host and collects the
+   patterns filed under each window it finds, plus the patterns that had
+   no usable literal.  The result is a superset of the patterns that can
+   match; the caller still runs the regex for each candidate, in rank
+   order, so first-match semantics are unchanged.
+*/
+class UrlMappingRegexIndex
+{
+public:
+  static const int GRAM_LEN = 4;
+
+  UrlMappingRegexIndex();
+  ~UrlMappingRegexIndex();
+
+  /// Index @a n patterns, identified by their position (rank order).
+  /// @a literals[i] / @a literal_lens[i] is the required literal of
+  /// pattern i, as returned by RequiredLiteral().
+  void Build(const char * const *literals, const int *literal_lens, int n);
+
+  int Size() const { return m_n; }
+  int CandidateWords() const { return (m_n + 63) / 64; }
+
+  /// Set the bit of every pattern that may match @a host in
+  /// @a candidates, which must hold CandidateWords() words.
+  void Candidates(const char *host, int host_len, uint64_t *candidates) const;
+
+  /// Extract from @a pattern the longest literal that any match must
+  /// contain, unescaped, into @a buf.  Returns its length, 0 if no
+  /// literal could be proven.
+  static int RequiredLiteral(const char *pattern, char *buf, int buf_size);
+
+private:
+  struct GramEntry
+  {
+    uint32_t gram;
+    int first;                  // first pattern filed under gram, or -1
+  };
+
+  static uint32_t _gram(const char *p)
+  {
+    uint32_t g;
+    memcpy(&g, p, sizeof(g));
+    return g;
+  }
+  static uint32_t _hash(uint32_t gram) { return gram * 2654435761U; }
+  GramEntry *_find(uint32_t gram) const;
+
+  int m_n;
+  uint64_t *m_unindexed;        // patterns without a literal, as a bitset
+  int *m_next;                  // next pattern filed under the same gram
+  GramEntry *m_table;
+  uint32_t m_table_mask;
+
+  // not copyable
+  UrlMappingRegexIndex(const UrlMappingRegexIndex &);
+  UrlMappingRegexIndex &operator =(const UrlMappingRegexIndex &);
+};
+
+#endif // _URL_MAPPING_REGEX_INDEX_H
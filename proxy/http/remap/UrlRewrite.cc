@@ -481,6 +481,12 @@ UrlRewrite::UrlRewrite(const char *file_var_in)
   forward_mappings.hash_lookup = reverse_mappings.hash_lookup =
     permanent_redirects.hash_lookup = temporary_redirects.hash_lookup = 
     forward_mappings_with_recv_port.hash_lookup = NULL;
+  forward_mappings.regex_index = reverse_mappings.regex_index =
+    permanent_redirects.regex_index = temporary_redirects.regex_index =
+    forward_mappings_with_recv_port.regex_index = NULL;
+  forward_mappings.regex_array = reverse_mappings.regex_array =
+    permanent_redirects.regex_array = temporary_redirects.regex_array =
+    forward_mappings_with_recv_port.regex_array = NULL;
 
   char *config_file = NULL;
 
@@ -1527,6 +1533,12 @@ UrlRewrite::BuildTable()
       return 3;
     }
   }
+  _buildRegexIndex(forward_mappings);
+  _buildRegexIndex(reverse_mappings);
+  _buildRegexIndex(permanent_redirects);
+  _buildRegexIndex(temporary_redirects);
+  _buildRegexIndex(forward_mappings_with_recv_port);
+
   // Destroy unused tables
   if (num_rules_forward == 0) {
     forward_mappings.hash_lookup = ink_hash_table_destroy(forward_mappings.hash_lookup);
@@ -1813,7 +1825,7 @@ UrlRewrite::_mappingLookup(MappingsStore &mappings, URL *request_url,
     mapping_container.set(mapping);
     retval = true;
   }
-  if (_regexMappingLookup(mappings.regex_list, request_url, request_port, request_host_lower, request_host_len,
+  if (_regexMappingLookup(mappings, request_url, request_port, request_host_lower, request_host_len,
                           rank_ceiling, mapping_container)) {
     Debug("url_rewrite", "Using regex mapping with rank %d", (mapping_container.getMapping())->getRank());
     retval = true;
@@ -1870,12 +1882,83 @@ UrlRewrite::_expandSubstitutions(int *matches_info, const RegexMapping *reg_map,
   return 0;
 }
 
+/**
+  Tries a single regex mapping against the request.  Returns 1 and fills
+  in mapping_container on a match, 0 if the mapping does not apply and -1
+  if the regex could not be evaluated.
+*/
+int
+UrlRewrite::_regexMappingMatch(RegexMapping *reg_map, URL *request_url, int request_port,
+                               const char *request_host, int request_host_len,
+                               UrlMappingContainer &mapping_container)
+{
+  int reg_map_rank = reg_map->url_map->getRank();
+
+  int request_scheme_len, reg_map_scheme_len;
+  const char *request_scheme = request_url->scheme_get(&request_scheme_len), *reg_map_scheme;
+
+  int request_path_len, reg_map_path_len;
+  const char *request_path = request_url->path_get(&request_path_len), *reg_map_path;
+
+  reg_map_scheme = reg_map->url_map->fromURL.scheme_get(&reg_map_scheme_len);
+  if ((request_scheme_len != reg_map_scheme_len) ||
+      strncmp(request_scheme, reg_map_scheme, request_scheme_len)) {
+    Debug("url_rewrite_regex", "Skipping regex with rank %d as scheme does not match request scheme",
+          reg_map_rank);
+    return 0;
+  }
+
+  if (reg_map->url_map->fromURL.port_get() != request_port) {
+    Debug("url_rewrite_regex", "Skipping regex with rank %d as regex map port does not match request port. "
+          "regex map port: %d, request port %d",
+          reg_map_rank, reg_map->url_map->fromURL.port_get(), request_port);
+    return 0;
+  }
+
+  reg_map_path = reg_map->url_map->fromURL.path_get(&reg_map_path_len);
+  if ((request_path_len < reg_map_path_len) ||
+      strncmp(reg_map_path, request_path, reg_map_path_len)) { // use the shorter path length here
+    Debug("url_rewrite_regex", "Skipping regex with rank %d as path does not cover request path",
+          reg_map_rank);
+    return 0;
+  }
+
+  int matches_info[MAX_REGEX_SUBS * 3];
+  int match_result = pcre_exec(reg_map->re, reg_map->re_extra, request_host, request_host_len,
+                               0, 0, matches_info, (sizeof(matches_info) / sizeof(int)));
+  if (match_result > 0) {
+    Debug("url_rewrite_regex", "Request URL host [%.*s] matched regex in mapping of rank %d "
+          "with %d possible substitutions", request_host_len, request_host, reg_map_rank, match_result);
+
+    mapping_container.set(reg_map->url_map);
+
+    char buf[4096];
+    int buf_len;
+
+    // Expand substitutions in the host field from the stored template
+    buf_len = _expandSubstitutions(matches_info, reg_map, request_host, buf, sizeof(buf));
+    URL *expanded_url = mapping_container.createNewToURL();
+    expanded_url->copy(&((reg_map->url_map)->toUrl));
+    expanded_url->host_set(buf, buf_len);
+
+    Debug("url_rewrite_regex", "Expanded toURL to [%.*s]",
+          expanded_url->length_get(), expanded_url->string_get_ref());
+    return 1;
+  } else if (match_result == PCRE_ERROR_NOMATCH) {
+    Debug("url_rewrite_regex", "Request URL host [%.*s] did NOT match regex in mapping of rank %d",
+          request_host_len, request_host, reg_map_rank);
+    return 0;
+  }
+  Warning("pcre_exec() failed with error code %d", match_result);
+  return -1;
+}
+
 bool
-UrlRewrite::_regexMappingLookup(RegexMappingList &regex_mappings, URL *request_url, int request_port,
+UrlRewrite::_regexMappingLookup(MappingsStore &mappings, URL *request_url, int request_port,
                                 const char *request_host, int request_host_len, int rank_ceiling,
                                 UrlMappingContainer &mapping_container)
 {
-  bool retval = false;
+  int result = 0;
 
   if (rank_ceiling == -1) { // we will now look at all regex mappings
     rank_ceiling = INT_MAX;
@@ -1885,75 +1968,105 @@ UrlRewrite::_regexMappingLookup(RegexMappingList &regex_mappings, URL *request_u
     Debug("url_rewrite_regex", "Going to match regexes with rank <= %d", rank_ceiling);
   }
 
-  int request_scheme_len, reg_map_scheme_len;
-  const char *request_scheme = request_url->scheme_get(&request_scheme_len), *reg_map_scheme;
-
-  int request_path_len, reg_map_path_len;
-  const char *request_path = request_url->path_get(&request_path_len), *reg_map_path;
+  if (mappings.regex_index) {
+    // Only try the mappings whose required literal occurs in the host;
+    // the candidate bits are in rank order, like the list
+    uint64_t local_candidates[64];
+    int words = mappings.regex_index->CandidateWords();
+    uint64_t *candidates = (words <= 64) ? local_candidates : (uint64_t *)ats_malloc(words * sizeof(uint64_t));
 
-  // Loop over the entire linked list, or until we're satisfied
-  forl_LL(RegexMapping, list_iter, regex_mappings) {
-    int reg_map_rank = list_iter->url_map->getRank();
+    mappings.regex_index->Candidates(request_host, request_host_len, candidates);
+    for (int w = 0; w < words && result == 0; ++w) {
+      for (uint64_t bits = candidates[w]; bits; bits &= bits - 1) {
+        RegexMapping *reg_map = mappings.regex_array[w * 64 + __builtin_ctzll(bits)];
 
-    if (reg_map_rank > rank_ceiling) {
-      break;
+        if (reg_map->url_map->getRank() > rank_ceiling) {
+          result = -1;
+          break;
+        }
+        if ((result = _regexMappingMatch(reg_map, request_url, request_port, request_host, request_host_len,
+                                         mapping_container)) != 0) {
+          break;
+        }
+      }
     }
-
-    reg_map_scheme = list_iter->url_map->fromURL.scheme_get(&reg_map_scheme_len);
-    if ((request_scheme_len != reg_map_scheme_len) ||
-        strncmp(request_scheme, reg_map_scheme, request_scheme_len)) {
-      Debug("url_rewrite_regex", "Skipping regex with rank %d as scheme does not match request scheme",
-            reg_map_rank);
-      continue;
+    if (candidates != local_candidates) {
+      ats_free(candidates);
     }
-
-    if (list_iter->url_map->fromURL.port_get() != request_port) {
-      Debug("url_rewrite_regex", "Skipping regex with rank %d as regex map port does not match request port. "
-            "regex map port: %d, request port %d",
-            reg_map_rank, list_iter->url_map->fromURL.port_get(), request_port);
-      continue;
+  } else {
+    // Loop over the entire linked list, or until we're satisfied
+    forl_LL(RegexMapping, list_iter, mappings.regex_list) {
+      if (list_iter->url_map->getRank() > rank_ceiling) {
+        break;
+      }
+      if ((result = _regexMappingMatch(list_iter, request_url, request_port, request_host, request_host_len,
+                                       mapping_container)) != 0) {
+        break;
+      }
     }
+  }
 
-    reg_map_path = list_iter->url_map->fromURL.path_get(&reg_map_path_len);
-    if ((request_path_len < reg_map_path_len) ||
-        strncmp(reg_map_path, request_path, reg_map_path_len)) { // use the shorter path length here
-      Debug("url_rewrite_regex", "Skipping regex with rank %d as path does not cover request path",
-            reg_map_rank);
-      continue;
-    }
+  return (result > 0);
+}
 
-    int matches_info[MAX_REGEX_SUBS * 3];
-    int match_result = pcre_exec(list_iter->re, list_iter->re_extra, request_host, request_host_len,
-                                 0, 0, matches_info, (sizeof(matches_info) / sizeof(int)));
-    if (match_result > 0) {
-      Debug("url_rewrite_regex", "Request URL host [%.*s] matched regex in mapping of rank %d "
-            "with %d possible substitutions", request_host_len, request_host, reg_map_rank, match_result);
+/**
+  Indexes the regex mappings of a store by the literal each host regex
+  requires, so lookups only run the regexes that can possibly match.
+  Short lists are left to the linear walk.
+*/
+void
+UrlRewrite::_buildRegexIndex(MappingsStore &store)
+{
+  int n = 0;
 
-      mapping_container.set(list_iter->url_map);
+  forl_LL(RegexMapping, list_iter, store.regex_list) {
+    ++n;
+  }
+  if (n < REGEX_INDEX_MIN_MAPPINGS) {
+    return;
+  }
 
-      char buf[4096];
-      int buf_len;
+  char (*literal_bufs)[TS_MAX_HOST_NAME_LEN] = (char (*)[TS_MAX_HOST_NAME_LEN])ats_malloc(n * TS_MAX_HOST_NAME_LEN);
+  const char **literals = (const char **)ats_malloc(n * sizeof(char *));
+  int *literal_lens = (int *)ats_malloc(n * sizeof(int));
+  int i = 0;
 
-      // Expand substitutions in the host field from the stored template
-      buf_len = _expandSubstitutions(matches_info, list_iter, request_host, buf, sizeof(buf));
-      URL *expanded_url = mapping_container.createNewToURL();
-      expanded_url->copy(&((list_iter->url_map)->toUrl));
-      expanded_url->host_set(buf, buf_len);
+  store.regex_array = (RegexMapping **)ats_malloc(n * sizeof(RegexMapping *));
+  forl_LL(RegexMapping, list_iter, store.regex_list) {
+    char pattern[TS_MAX_HOST_NAME_LEN];
+    int pattern_len;
+    const char *from_host = list_iter->url_map->fromURL.host_get(&pattern_len);
 
-      Debug("url_rewrite_regex", "Expanded toURL to [%.*s]",
-            expanded_url->length_get(), expanded_url->string_get_ref());
-      retval = true;
-      break;
-    } else if (match_result == PCRE_ERROR_NOMATCH) {
-      Debug("url_rewrite_regex", "Request URL host [%.*s] did NOT match regex in mapping of rank %d",
-            request_host_len, request_host, reg_map_rank);
-    } else {
-      Warning("pcre_exec() failed with error code %d", match_result);
-      break;
+    // the regex was compiled from the lowercased host, see BuildTable()
+    if (pattern_len >= TS_MAX_HOST_NAME_LEN) {
+      pattern_len = 0;          // no literal; always a candidate
     }
+    for (int j = 0; j < pattern_len; ++j) {
+      pattern[j] = tolower(from_host[j]);
+    }
+    pattern[pattern_len] = 0;
+
+    store.regex_array[i] = list_iter;
+    literals[i] = literal_bufs[i];
+    literal_lens[i] = UrlMappingRegexIndex::RequiredLiteral(pattern, literal_bufs[i], TS_MAX_HOST_NAME_LEN);
+    ++i;
   }
 
-  return retval;
+  store.regex_index = NEW(new UrlMappingRegexIndex);
+  store.regex_index->Build(literals, literal_lens, n);
+
+  ats_free(literal_lens);
+  ats_free(literals);
+  ats_free(literal_bufs);
+}
+
+void
+UrlRewrite::_destroyRegexIndex(MappingsStore &store)
+{
+  delete store.regex_index;
+  store.regex_index = NULL;
+  ats_free(store.regex_array);
+  store.regex_array = NULL;
 }
 
 void
@@ -25,6 +25,7 @@
 #define _URL_REWRITE_H_
 
 #include "UrlMapping.h"
+#include "UrlMappingRegexIndex.h"
 #include "HttpTransact.h"
 
 #ifdef HAVE_PCRE_PCRE_H
@@ -80,6 +81,7 @@ public:
 //  private:
 
   static const int MAX_REGEX_SUBS = 10;
+  static const int REGEX_INDEX_MIN_MAPPINGS = 8; // shorter regex lists are walked linearly
 
   struct RegexMapping
   {
@@ -111,6 +113,10 @@ public:
   {
     InkHashTable *hash_lookup;
     RegexMappingList regex_list;
+    // built once the table is loaded, when regex_list is long enough to
+    // be worth it; regex_array holds regex_list in rank order
+    UrlMappingRegexIndex *regex_index;
+    RegexMapping **regex_array;
     bool empty() { return ((hash_lookup == NULL) && regex_list.empty()); }
   };
 
@@ -122,6 +128,7 @@ public:
   void DestroyStore(MappingsStore &store)
   {
     _destroyTable(store.hash_lookup);
+    _destroyRegexIndex(store);
     _destroyList(store.regex_list);
   }
 
@@ -196,14 +203,18 @@ private:
                       int request_host_len, UrlMappingContainer &mapping_container);
   url_mapping *_tableLookup(InkHashTable * h_table, URL * request_url, int request_port, char *request_host,
                             int request_host_len);
-  bool _regexMappingLookup(RegexMappingList &regex_mappings, URL * request_url, int request_port, const char *request_host,
+  bool _regexMappingLookup(MappingsStore &mappings, URL * request_url, int request_port, const char *request_host,
                            int request_host_len, int rank_ceiling,
                            UrlMappingContainer &mapping_container);
+  int _regexMappingMatch(RegexMapping *reg_map, URL *request_url, int request_port, const char *request_host,
+                         int request_host_len, UrlMappingContainer &mapping_container);
   int _expandSubstitutions(int *matches_info, const RegexMapping *reg_map, const char *matched_string, char *dest_buf,
                            int dest_buf_size);
   bool _processRegexMappingConfig(const char *from_host_lower, url_mapping *new_mapping, RegexMapping *reg_map);
   void _destroyTable(InkHashTable *h_table);
   void _destroyList(RegexMappingList &regexes);
+  void _buildRegexIndex(MappingsStore &store);
+  void _destroyRegexIndex(MappingsStore &store);
   inline bool _addToStore(MappingsStore &store, url_mapping *new_mapping, RegexMapping *reg_map, char *src_host,
                           bool is_cur_mapping_regex, int &count);
 };
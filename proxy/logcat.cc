@@ -44,6 +44,7 @@
 #include "LogObject.h"
 #include "LogConfig.h"
 #include "LogBuffer.h"
+#include "LogColumnar.h"
 #include "LogUtils.h"
 #include "LogSock.h"
 #include "Log.h"
@@ -56,6 +57,7 @@ static int follow_flag = 0;
 static int clf_flag = 0;
 static int elf_flag = 0;
 static int elf2_flag = 0;
+static int csv_flag = 0;
 static int auto_filenames = 0;
 static int overwrite_existing_file = 0;
 static char output_file[1024];
@@ -69,6 +71,7 @@ ArgumentDescription argument_descriptions[] = {
    "T", &auto_filenames, NULL, NULL},
   {"follow", 'f', "Follow the log file as it grows", "T", &follow_flag, NULL, NULL},
   {"clf", 'C', "Convert to Common Logging Format", "T", &clf_flag, NULL, NULL},
+  {"csv", 'c', "Convert to CSV, one column per field", "T", &csv_flag, NULL, NULL},
   {"elf", 'E', "Convert to Extended Logging Format", "T", &elf_flag, NULL, NULL},
   {"help", 'h', "Give this help", "T", &help, NULL, NULL},
   {"squid", 'S', "Convert to Squid Logging Format", "T", &squid_flag, NULL, NULL},
@@ -81,7 +84,7 @@ ArgumentDescription argument_descriptions[] = {
 };
 int n_argument_descriptions = SIZE(argument_descriptions);
 
-static const char *USAGE_LINE = "Usage: " PROGRAM_NAME " [-o output-file | -a] [-CEhS"
+static const char *USAGE_LINE = "Usage: " PROGRAM_NAME " [-o output-file | -a] [-cCEhS"
 #ifdef DEBUG
   "T"
 #endif
@@ -89,6 +92,115 @@ static const char *USAGE_LINE = "Usage: " PROGRAM_NAME " [-o output-file | -a] [
 
 
 
+/*-------------------------------------------------------------------------
+  write_logbuffer
+
+  Convert one (row-oriented) buffer to the requested output format.  For
+  CSV output, a header row naming the fields is written whenever the
+  format changes.
+  -------------------------------------------------------------------------*/
+
+static int
+write_logbuffer(LogBufferHeader * header, int out_fd)
+{
+  static char *csv_fieldlist = NULL;
+
+  if (!header->fmt_fieldlist()) {
+    // TODO investigate why this buffer goes wonky
+    return 0;
+  }
+
+  if (csv_flag) {
+    char *fieldlist = header->fmt_fieldlist();
+    int bytes = 0;
+
+    if (!csv_fieldlist || strcmp(csv_fieldlist, fieldlist) != 0) {
+      ats_free(csv_fieldlist);
+      csv_fieldlist = ats_strdup(fieldlist);
+      bytes += write(out_fd, fieldlist, strlen(fieldlist));
+      bytes += write(out_fd, "\n", 1);
+    }
+    return bytes + LogFile::write_csv_logbuffer(header, out_fd, ".");
+  }
+
+  // see if there is an alternate format request from the command
+  // line
+  //
+  char *alt_format = NULL;
+  if (squid_flag)
+    alt_format = (char *) LogFormat::squid_format;
+  if (clf_flag)
+    alt_format = (char *) LogFormat::common_format;
+  if (elf_flag)
+    alt_format = (char *) LogFormat::extended_format;
+  if (elf2_flag)
+    alt_format = (char *) LogFormat::extended2_format;
+
+  // convert the buffer to ascii entries and place onto stdout
+  //
+  return LogFile::write_ascii_logbuffer(header, out_fd, ".", alt_format);
+}
+
+/*-------------------------------------------------------------------------
+  process_columnar_block
+
+  Read the rest of a columnar block whose first 8 bytes are in buffer,
+  expand it back into a LogBuffer and write it out.
+  -------------------------------------------------------------------------*/
+
+static int
+process_columnar_block(int in_fd, int out_fd, char *buffer, unsigned first_read_size)
+{
+  LogColumnarHeader header;
+  unsigned header_size = sizeof(LogColumnarHeader);
+
+  memcpy(&header, buffer, first_read_size);
+  int nread = read(in_fd, (char *) &header + first_read_size, header_size - first_read_size);
+  if (nread != (int) (header_size - first_read_size)) {
+    if (follow_flag)
+      return 0;
+
+    fprintf(stderr, "Bad columnar block header read!\n");
+    return 1;
+  }
+  if (header.byte_count < header_size || header.byte_count > LOG_COLUMNAR_MAX_BLOCK) {
+    fprintf(stderr, "Bad columnar block!\n");
+    return 1;
+  }
+
+  char *block = (char *)ats_malloc(header.byte_count);
+  int block_bytes = header.byte_count - header_size;
+
+  memcpy(block, &header, header_size);
+  nread = 0;
+  while (nread < block_bytes) {
+    int rc = read(in_fd, block + header_size + nread, block_bytes - nread);
+
+    if (rc <= 0) {
+      // in follow mode the rest of the block may not be written yet
+      if (rc == 0 && follow_flag) {
+        usleep(10000);
+        continue;
+      }
+      fprintf(stderr, "Bad columnar block read!\n");
+      ats_free(block);
+      return 1;
+    }
+    nread += rc;
+  }
+
+  LogBufferHeader *buffer_header = LogColumnar::decode(block, header.byte_count);
+  ats_free(block);
+  if (!buffer_header) {
+    fprintf(stderr, "Bad columnar block!\n");
+    return 1;
+  }
+
+  write_logbuffer(buffer_header, out_fd);
+  ats_free(buffer_header);
+  return 0;
+}
+
 int
 process_file(int in_fd, int out_fd)
 {
@@ -113,6 +225,13 @@ process_file(int in_fd, int out_fd)
     if (!nread || nread == EOF)
       return 0;
 
+    // columnar blocks are self-contained and variable size
+    //
+    if (nread == (int) first_read_size && header->cookie == LOG_COLUMNAR_COOKIE) {
+      if (process_columnar_block(in_fd, out_fd, buffer, first_read_size) != 0)
+        return 1;
+      continue;
+    }
     // ensure that this is a valid logbuffer header
     //
     if (header->cookie != LOG_SEGMENT_COOKIE) {
@@ -164,26 +283,7 @@ process_file(int in_fd, int out_fd)
       fprintf(stderr, "Read too many bytes!\n");
       return 1;
     }
-    // see if there is an alternate format request from the command
-    // line
-    //
-    char *alt_format = NULL;
-    if (squid_flag)
-      alt_format = (char *) LogFormat::squid_format;
-    if (clf_flag)
-      alt_format = (char *) LogFormat::common_format;
-    if (elf_flag)
-      alt_format = (char *) LogFormat::extended_format;
-    if (elf2_flag)
-      alt_format = (char *) LogFormat::extended2_format;
-
-    // convert the buffer to ascii entries and place onto stdout
-    //
-    if (header->fmt_fieldlist()) {
-      bytes += LogFile::write_ascii_logbuffer(header, out_fd, ".", alt_format);
-    } else {
-      // TODO investigate why this buffer goes wonky
-    }
+    bytes += write_logbuffer(header, out_fd);
   }
 }
 
@@ -300,12 +400,14 @@ main(int argc, char *argv[])
         posix_fadvise(in_fd, 0, 0, POSIX_FADV_DONTNEED);
 #endif
         if (auto_filenames) {
-          // change .blog to .log
+          // change .blog (or .clog) to .log
           //
           int n = strlen(file_arguments[i]);
           int copy_len = (n >= bin_ext_len ? (strcmp(&file_arguments[i][n - bin_ext_len],
-                                                     BINARY_LOG_OBJECT_FILENAME_EXTENSION) ==
-                                              0 ? n - bin_ext_len : n) : n);
+                                                     BINARY_LOG_OBJECT_FILENAME_EXTENSION) == 0 ||
+                                              strcmp(&file_arguments[i][n - bin_ext_len],
+                                                     COLUMNAR_LOG_OBJECT_FILENAME_EXTENSION) == 0 ?
+                                              n - bin_ext_len : n) : n);
 
           char *out_filename = (char *)ats_malloc(copy_len + ascii_ext_len + 1);
 
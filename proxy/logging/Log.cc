@@ -1362,7 +1362,8 @@ Log::match_logobject(LogBufferHeader * header)
     if (fmt->valid()) {
       LogFileFormat file_format =
         header->log_object_flags & LogObject::BINARY ? BINARY_LOG :
-        (header->log_object_flags & LogObject::WRITES_TO_PIPE ? ASCII_PIPE : ASCII_LOG);
+        (header->log_object_flags & LogObject::WRITES_TO_PIPE ? ASCII_PIPE :
+         (header->log_object_flags & LogObject::COLUMNAR ? COLUMNAR_LOG : ASCII_LOG));
 
       obj = NEW(new LogObject(fmt, Log::config->logfile_dir,
                               header->log_filename(), file_format, NULL,
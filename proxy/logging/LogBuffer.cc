@@ -65,6 +65,74 @@ FieldListCacheElement fieldlist_cache[FIELDLIST_CACHE_SIZE];
 int fieldlist_cache_entries = 0;
 vint32 LogBuffer::M_ID = 0;
 
+/*-------------------------------------------------------------------------
+  LogBufferPool
+
+  Log buffers are created and destroyed at a high rate.  The data areas
+  of buffers of the configured size are kept on a freelist and reused
+  instead of going back to the heap after every flush.  When
+  log_buffer_size changes the pool is drained and then keeps areas of
+  the new size.  Each pooled area records its size just past the
+  freelist link, so an area of an old size that is put back while the
+  pool is drained is freed instead of being handed out again.
+  -------------------------------------------------------------------------*/
+
+#define LOG_BUFFER_POOL_MAX 256
+
+struct LogBufferPool
+{
+  InkAtomicList free_list;
+  volatile int64_t chunk_size;  // only chunks of this size are pooled
+  vint32 count;
+
+  LogBufferPool() : chunk_size(0), count(0)
+  {
+    ink_atomiclist_init(&free_list, "LogBufferPool", 0);
+  }
+
+  static int64_t &chunk_tag(char *p) { return ((int64_t *) p)[1]; }
+
+  char *pop(int64_t size)
+  {
+    char *p;
+
+    while ((p = (char *) ink_atomiclist_pop(&free_list))) {
+      ink_atomic_increment(&count, -1);
+      if (chunk_tag(p) == size)
+        return p;
+      delete [] p;
+    }
+    return NULL;
+  }
+
+  char *get(size_t size)
+  {
+    // the size buffers are made with now, see LogObject
+    int64_t want = Log::config->log_buffer_size + LB_DEFAULT_ALIGN;
+    int64_t have = chunk_size;
+
+    if ((int64_t) size != want)
+      return NEW (new char [size]);
+    if (have != want && ink_atomic_cas(&chunk_size, have, want))
+      pop(0);                   // drain chunks of the old size
+    char *p = pop(want);
+    return p ? p : NEW (new char [size]);
+  }
+
+  void put(char *p, size_t size)
+  {
+    if ((int64_t) size == chunk_size && count < LOG_BUFFER_POOL_MAX) {
+      chunk_tag(p) = size;
+      ink_atomic_increment(&count, 1);
+      ink_atomiclist_push(&free_list, p);
+    } else {
+      delete [] p;
+    }
+  }
+};
+
+static LogBufferPool log_buffer_pool;
+
 /*-------------------------------------------------------------------------
   The following LogBufferHeader routines are used to grab strings out from
   the data section using the offsets held in the buffer header.
@@ -138,7 +206,7 @@ LogBuffer::LogBuffer(LogObject * owner, size_t size, size_t buf_align, size_t wr
 
   // create the buffer
   //
-  m_unaligned_buffer = NEW (new char [size + buf_align]);
+  m_unaligned_buffer = log_buffer_pool.get(size + buf_align);
   m_buffer = (char *)align_pointer_forward(m_unaligned_buffer, buf_align);
 
   // add the header
@@ -181,7 +249,7 @@ LogBuffer::LogBuffer(LogObject * owner, LogBufferHeader * header):
 LogBuffer::~LogBuffer()
 {
   if (m_unaligned_buffer) {
-    delete [] m_unaligned_buffer;
+    log_buffer_pool.put(m_unaligned_buffer, m_size + m_buf_align);
   } else {
     delete [] m_buffer;
   }
@@ -428,6 +496,10 @@ LogBuffer::update_header_data()
   if (m_unaligned_buffer) {
     m_header->entry_count = m_state.s.num_entries;
     m_header->byte_count = m_state.s.byte_count;
+    if (m_header->entry_count) {
+      LogEntryHeader *first = (LogEntryHeader *) &m_buffer[m_header->data_offset];
+      m_header->low_timestamp = first->timestamp;
+    }
     m_header->high_timestamp = LogUtils::timestamp();
   }
 }
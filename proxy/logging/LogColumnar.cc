@@ -0,0 +1,752 @@
+/** @file
+
+  Column-oriented encoding of LogBuffers for the "columnar" log mode.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "libts.h"
+#include "ink_unused.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if TS_HAS_LIBZ
+#include <zlib.h>
+#endif
+
+#include "Error.h"
+#include "LogField.h"
+#include "LogFormat.h"
+#include "LogFormatType.h"
+#include "LogBuffer.h"
+#include "LogColumnar.h"
+
+// A dictionary is only worth building for columns where values repeat a
+// lot; beyond this many distinct values we store the column raw.
+#define COLUMNAR_MAX_DICT 65535
+
+/*-------------------------------------------------------------------------
+  ColumnarWriter / ColumnarReader
+
+  Growable output buffer and bounds-checked input cursor for the varint
+  encoded payload.
+  -------------------------------------------------------------------------*/
+
+struct ColumnarWriter
+{
+  char *data;
+  size_t len;
+  size_t size;
+
+  ColumnarWriter() : data(NULL), len(0), size(0) { }
+  ~ColumnarWriter() { ats_free(data); }
+
+  void reserve(size_t n)
+  {
+    if (len + n > size) {
+      size = size ? size * 2 : 4096;
+      if (size < len + n)
+        size = len + n;
+      data = (char *)ats_realloc(data, size);
+    }
+  }
+  void put(const void *p, size_t n)
+  {
+    reserve(n);
+    memcpy(data + len, p, n);
+    len += n;
+  }
+  void put_byte(uint8_t b)
+  {
+    reserve(1);
+    data[len++] = (char) b;
+  }
+  void put_varint(uint64_t v)
+  {
+    reserve(10);
+    while (v >= 0x80) {
+      data[len++] = (char) (v | 0x80);
+      v >>= 7;
+    }
+    data[len++] = (char) v;
+  }
+  void put_svarint(int64_t v)
+  {
+    put_varint(((uint64_t) v << 1) ^ (uint64_t) (v >> 63));
+  }
+  void put_bytes(const char *p, uint32_t n)
+  {
+    put_varint(n);
+    put(p, n);
+  }
+  // strings are stored as length + 1, with 0 meaning "not present"
+  void put_str(const char *s)
+  {
+    if (s) {
+      uint32_t n = (uint32_t)::strlen(s);
+      put_varint(n + 1);
+      put(s, n);
+    } else {
+      put_varint(0);
+    }
+  }
+};
+
+struct ColumnarReader
+{
+  const char *p;
+  const char *end;
+  bool ok;
+
+  ColumnarReader(const char *a_p, size_t a_len) : p(a_p), end(a_p + a_len), ok(true) { }
+
+  uint64_t get_varint()
+  {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (p >= end) {
+        ok = false;
+        return 0;
+      }
+      uint8_t b = (uint8_t) * p++;
+      v |= (uint64_t) (b & 0x7f) << shift;
+      if (!(b & 0x80))
+        return v;
+    }
+    ok = false;
+    return 0;
+  }
+  int64_t get_svarint()
+  {
+    uint64_t v = get_varint();
+    return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+  }
+  const char *get(uint64_t n)
+  {
+    if (!ok || n > (uint64_t) (end - p)) {
+      ok = false;
+      return NULL;
+    }
+    const char *r = p;
+    p += n;
+    return r;
+  }
+  // returns the string start (not nul terminated) and its length in *n
+  const char *get_str(uint32_t *n)
+  {
+    uint64_t v = get_varint();
+    if (v == 0 || !ok) {
+      *n = 0;
+      return NULL;
+    }
+    *n = (uint32_t) (v - 1);
+    return get(*n);
+  }
+};
+
+static inline unsigned
+varint_len(uint64_t v)
+{
+  unsigned n = 1;
+  while (v >= 0x80) {
+    v >>= 7;
+    ++n;
+  }
+  return n;
+}
+
+static inline uint32_t
+span_hash(const char *p, uint32_t n)
+{
+  uint32_t h = 2166136261U;     // FNV-1a
+  for (uint32_t i = 0; i < n; ++i) {
+    h ^= (uint8_t) p[i];
+    h *= 16777619U;
+  }
+  return h;
+}
+
+/*-------------------------------------------------------------------------
+  split_entries
+
+  Find the marshalled extent of every field of every entry by running the
+  field unmarshal routines over the entry, which is exactly how
+  LogBuffer::resolve_custom_entry walks it.  Returns false if an entry
+  does not parse cleanly, in which case the buffer is stored by rows.
+  -------------------------------------------------------------------------*/
+
+static bool
+split_entries(LogFieldList * fieldlist, int n_fields, LogEntryHeader ** entries, uint32_t n,
+              const char **vals, uint32_t *lens)
+{
+  uint32_t max_payload = 0;
+
+  for (uint32_t i = 0; i < n; ++i) {
+    uint32_t payload = entries[i]->entry_len - sizeof(LogEntryHeader);
+    if (payload > max_payload)
+      max_payload = payload;
+  }
+
+  // unmarshal needs somewhere to put the formatted value; no value can
+  // format to more than its marshalled size plus a little slack
+  int scratch_len = max_payload + 256;
+  char *scratch = (char *)ats_malloc(scratch_len);
+  bool ok = true;
+
+  for (uint32_t i = 0; ok && i < n; ++i) {
+    char *start = (char *) entries[i] + sizeof(LogEntryHeader);
+    char *end = (char *) entries[i] + entries[i]->entry_len;
+    char *read_from = start;
+    int c = 0;
+
+    for (LogField * field = fieldlist->first(); field; field = fieldlist->next(field), ++c) {
+      char *field_start = read_from;
+      if ((int) field->unmarshal(&read_from, scratch, scratch_len) < 0 || read_from > end || c >= n_fields) {
+        ok = false;
+        break;
+      }
+      vals[c * n + i] = field_start;
+      lens[c * n + i] = (uint32_t) (read_from - field_start);
+    }
+  }
+
+  ats_free(scratch);
+  return ok;
+}
+
+/*-------------------------------------------------------------------------
+  encode_column
+
+  Pick the smallest of the raw, dictionary and delta encodings for one
+  column and append it to the payload.
+  -------------------------------------------------------------------------*/
+
+static void
+encode_column(ColumnarWriter * out, const char **vals, const uint32_t *lens, uint32_t n)
+{
+  uint64_t raw_bytes = 0;
+  bool all_ints = true;
+
+  for (uint32_t i = 0; i < n; ++i) {
+    raw_bytes += varint_len(lens[i]) + lens[i];
+    if (lens[i] != sizeof(int64_t))
+      all_ints = false;
+  }
+
+  // delta encoding of 64 bit values; any 8 byte value round-trips, so
+  // this does not depend on the field type
+  uint64_t delta_bytes = (uint64_t) - 1;
+  if (all_ints) {
+    int64_t prev = 0;
+    delta_bytes = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+      int64_t v;
+      memcpy(&v, vals[i], sizeof(v));
+      int64_t d = (int64_t) ((uint64_t) v - (uint64_t) prev);   // wraps, never overflows
+      delta_bytes += varint_len(((uint64_t) d << 1) ^ (uint64_t) (d >> 63));
+      prev = v;
+    }
+  }
+
+  // dictionary; give up as soon as it stops paying for itself
+  uint32_t max_dict = n / 2 < COLUMNAR_MAX_DICT ? n / 2 : COLUMNAR_MAX_DICT;
+  uint32_t table_size = 16;
+  while (table_size < 2 * n)
+    table_size <<= 1;
+  uint32_t *table = (uint32_t *)ats_calloc(table_size, sizeof(uint32_t));  // dict index + 1
+  uint32_t *dict = (uint32_t *)ats_malloc(((max_dict ? max_dict : 1)) * sizeof(uint32_t));  // entry holding it
+  uint32_t *index = (uint32_t *)ats_malloc(n * sizeof(uint32_t));
+  uint32_t n_dict = 0;
+  uint64_t dict_bytes = 0;
+  bool use_dict = max_dict > 0;
+
+  for (uint32_t i = 0; use_dict && i < n; ++i) {
+    uint32_t slot = span_hash(vals[i], lens[i]) & (table_size - 1);
+    while (table[slot]) {
+      uint32_t e = dict[table[slot] - 1];
+      if (lens[e] == lens[i] && memcmp(vals[e], vals[i], lens[i]) == 0)
+        break;
+      slot = (slot + 1) & (table_size - 1);
+    }
+    if (!table[slot]) {
+      if (n_dict >= max_dict) {
+        use_dict = false;
+        break;
+      }
+      dict[n_dict++] = i;
+      table[slot] = n_dict;
+      dict_bytes += varint_len(lens[i]) + lens[i];
+    }
+    index[i] = table[slot] - 1;
+    dict_bytes += varint_len(index[i]);
+  }
+  if (use_dict)
+    dict_bytes += varint_len(n_dict);
+
+  if (use_dict && dict_bytes < raw_bytes && dict_bytes < delta_bytes) {
+    out->put_byte(LogColumnar::COL_DICT);
+    out->put_varint(n_dict);
+    for (uint32_t d = 0; d < n_dict; ++d)
+      out->put_bytes(vals[dict[d]], lens[dict[d]]);
+    for (uint32_t i = 0; i < n; ++i)
+      out->put_varint(index[i]);
+  } else if (delta_bytes < raw_bytes) {
+    int64_t prev = 0;
+    out->put_byte(LogColumnar::COL_DELTA);
+    for (uint32_t i = 0; i < n; ++i) {
+      int64_t v;
+      memcpy(&v, vals[i], sizeof(v));
+      out->put_svarint((int64_t) ((uint64_t) v - (uint64_t) prev));
+      prev = v;
+    }
+  } else {
+    out->put_byte(LogColumnar::COL_RAW);
+    for (uint32_t i = 0; i < n; ++i)
+      out->put_bytes(vals[i], lens[i]);
+  }
+
+  ats_free(index);
+  ats_free(dict);
+  ats_free(table);
+}
+
+/*-------------------------------------------------------------------------
+  LogColumnar::encode
+  -------------------------------------------------------------------------*/
+
+int
+LogColumnar::encode(LogBufferHeader * buffer_header, char **block)
+{
+  ink_assert(buffer_header != NULL);
+  ink_assert(block != NULL);
+
+  if (buffer_header->version != LOG_SEGMENT_VERSION) {
+    Note("Invalid LogBuffer version %d in LogColumnar::encode; "
+         "current version is %d", buffer_header->version, LOG_SEGMENT_VERSION);
+    return -1;
+  }
+
+  LogBufferIterator iter(buffer_header);
+  LogEntryHeader **entries = (LogEntryHeader **)ats_malloc((buffer_header->entry_count + 1) * sizeof(LogEntryHeader *));
+  uint32_t n = 0;
+
+  while (n < buffer_header->entry_count && (entries[n] = iter.next()))
+    ++n;
+
+  // split the entries by field; TEXT_LOG buffers (and anything we cannot
+  // parse) are kept as a single column of whole entries
+  LogFieldList fieldlist;
+  char *fieldlist_str = buffer_header->fmt_fieldlist();
+  int n_columns = 0;
+  uint32_t flags = 0;
+
+  if (buffer_header->format_type != TEXT_LOG && fieldlist_str && *fieldlist_str) {
+    bool contains_aggregates = false;
+    n_columns = LogFormat::parse_symbol_string(fieldlist_str, &fieldlist, &contains_aggregates);
+  }
+
+  const char **vals = (const char **)ats_malloc(((n_columns > 0 ? n_columns : 1) * n + 1) * sizeof(char *));
+  uint32_t *lens = (uint32_t *)ats_malloc(((n_columns > 0 ? n_columns : 1) * n + 1) * sizeof(uint32_t));
+
+  if (n_columns <= 0 || !split_entries(&fieldlist, n_columns, entries, n, vals, lens)) {
+    Debug("log-columnar", "storing %u entries of %s by rows", n, fieldlist_str ? fieldlist_str : "text log");
+    flags |= ROWS;
+    n_columns = 1;
+    for (uint32_t i = 0; i < n; ++i) {
+      vals[i] = (char *) entries[i] + sizeof(LogEntryHeader);
+      lens[i] = entries[i]->entry_len - sizeof(LogEntryHeader);
+    }
+  }
+
+  ColumnarWriter payload;
+
+  payload.put_str(buffer_header->fmt_name());
+  payload.put_str(buffer_header->fmt_fieldlist());
+  payload.put_str(buffer_header->fmt_printf());
+  payload.put_str(buffer_header->src_hostname());
+  payload.put_str(buffer_header->log_filename());
+
+  int64_t prev_ts = buffer_header->low_timestamp;
+  for (uint32_t i = 0; i < n; ++i) {
+    payload.put_svarint(entries[i]->timestamp - prev_ts);
+    prev_ts = entries[i]->timestamp;
+  }
+  for (uint32_t i = 0; i < n; ++i)
+    payload.put_varint((uint32_t) entries[i]->timestamp_usec);
+
+  for (int c = 0; c < n_columns; ++c)
+    encode_column(&payload, &vals[c * n], &lens[c * n], n);
+
+  ats_free(lens);
+  ats_free(vals);
+  ats_free(entries);
+
+  const char *stored = payload.data;
+  size_t stored_len = payload.len;
+  char *compressed = NULL;
+
+#if TS_HAS_LIBZ
+  uLongf z_len = compressBound(payload.len);
+  compressed = (char *)ats_malloc(z_len);
+  if (compress2((Bytef *) compressed, &z_len, (Bytef *) payload.data, payload.len, Z_BEST_SPEED) == Z_OK &&
+      z_len < payload.len) {
+    flags |= COMPRESSED;
+    stored = compressed;
+    stored_len = z_len;
+  }
+#endif
+
+  if (payload.len > LOG_COLUMNAR_MAX_BLOCK) {
+    Note("LogBuffer of %u entries too large for a columnar log block", n);
+    ats_free(compressed);
+    return -1;
+  }
+
+  int block_len = sizeof(LogColumnarHeader) + stored_len;
+  LogColumnarHeader *h = (LogColumnarHeader *)ats_malloc(block_len);
+
+  h->cookie = LOG_COLUMNAR_COOKIE;
+  h->version = LOG_COLUMNAR_VERSION;
+  h->byte_count = block_len;
+  h->payload_bytes = payload.len;
+  h->flags = flags;
+  h->format_type = buffer_header->format_type;
+  h->entry_count = n;
+  h->n_columns = n_columns;
+  h->low_timestamp = buffer_header->low_timestamp;
+  h->high_timestamp = buffer_header->high_timestamp;
+  h->log_object_flags = buffer_header->log_object_flags;
+  h->reserved = 0;
+  h->log_object_signature = buffer_header->log_object_signature;
+  memcpy((char *) h + sizeof(LogColumnarHeader), stored, stored_len);
+  ats_free(compressed);
+
+  Debug("log-columnar", "encoded %u entries (%u bytes) into %d bytes, flags %x",
+        n, buffer_header->byte_count, block_len, flags);
+
+  *block = (char *) h;
+  return block_len;
+}
+
+/*-------------------------------------------------------------------------
+  LogColumnar::decode
+  -------------------------------------------------------------------------*/
+
+LogBufferHeader *
+LogColumnar::decode(const char *block, int len)
+{
+  if (block == NULL || len < (int) sizeof(LogColumnarHeader))
+    return NULL;
+
+  LogColumnarHeader h;
+  memcpy(&h, block, sizeof(h));
+
+  if (h.cookie != LOG_COLUMNAR_COOKIE || h.version != LOG_COLUMNAR_VERSION || h.byte_count != (uint32_t) len ||
+      h.byte_count > LOG_COLUMNAR_MAX_BLOCK || h.payload_bytes > LOG_COLUMNAR_MAX_BLOCK) {
+    Note("Invalid columnar log block (cookie %x, version %u, %u bytes)", h.cookie, h.version, h.byte_count);
+    return NULL;
+  }
+
+  // every value takes at least one byte of payload
+  uint64_t n = h.entry_count;
+  uint64_t n_values = n * (h.n_columns + 2);
+  if (h.n_columns == 0 || n_values > h.payload_bytes)
+    return NULL;
+
+  const char *payload = block + sizeof(LogColumnarHeader);
+  char *uncompressed = NULL;
+
+  if (h.flags & COMPRESSED) {
+#if TS_HAS_LIBZ
+    uLongf z_len = h.payload_bytes;
+    uncompressed = (char *)ats_malloc(h.payload_bytes + 1);
+    if (uncompress((Bytef *) uncompressed, &z_len, (Bytef *) payload, len - sizeof(LogColumnarHeader)) != Z_OK ||
+        z_len != h.payload_bytes) {
+      Note("Could not uncompress columnar log block");
+      ats_free(uncompressed);
+      return NULL;
+    }
+    payload = uncompressed;
+#else
+    Note("Columnar log block is compressed, but zlib support is not available");
+    return NULL;
+#endif
+  } else if (h.payload_bytes != len - sizeof(LogColumnarHeader)) {
+    return NULL;
+  }
+
+  ColumnarReader in(payload, h.payload_bytes);
+  const char *strs[5];
+  uint32_t str_lens[5];
+
+  for (int s = 0; s < 5; ++s)
+    strs[s] = in.get_str(&str_lens[s]);
+
+  int64_t *timestamps = (int64_t *)ats_malloc((n + 1) * sizeof(int64_t));
+  int32_t *usecs = (int32_t *)ats_malloc((n + 1) * sizeof(int32_t));
+  int64_t ts = h.low_timestamp;
+
+  for (uint64_t i = 0; i < n; ++i) {
+    ts += in.get_svarint();
+    timestamps[i] = ts;
+  }
+  for (uint64_t i = 0; i < n; ++i)
+    usecs[i] = (int32_t) in.get_varint();
+
+  // resolve every column back into (pointer, length) values; delta
+  // encoded columns are materialized into ints[]
+  uint64_t n_cells = n * h.n_columns;
+  const char **vals = (const char **)ats_malloc((n_cells + 1) * sizeof(char *));
+  uint32_t *lens = (uint32_t *)ats_malloc((n_cells + 1) * sizeof(uint32_t));
+  int64_t *ints = (int64_t *)ats_malloc((n_cells + 1) * sizeof(int64_t));
+
+  for (uint32_t c = 0; in.ok && c < h.n_columns; ++c) {
+    const char **cv = &vals[c * n];
+    uint32_t *cl = &lens[c * n];
+    const char *enc = in.get(1);
+
+    if (!enc)
+      break;
+    switch (*enc) {
+    case COL_RAW:
+      for (uint64_t i = 0; in.ok && i < n; ++i) {
+        cl[i] = (uint32_t) in.get_varint();
+        cv[i] = in.get(cl[i]);
+      }
+      break;
+    case COL_DICT: {
+      uint64_t n_dict = in.get_varint();
+      if (n_dict > n) {
+        in.ok = false;
+        break;
+      }
+      const char **dv = (const char **)ats_malloc((n_dict + 1) * sizeof(char *));
+      uint32_t *dl = (uint32_t *)ats_malloc((n_dict + 1) * sizeof(uint32_t));
+      for (uint64_t d = 0; in.ok && d < n_dict; ++d) {
+        dl[d] = (uint32_t) in.get_varint();
+        dv[d] = in.get(dl[d]);
+      }
+      for (uint64_t i = 0; in.ok && i < n; ++i) {
+        uint64_t d = in.get_varint();
+        if (d >= n_dict) {
+          in.ok = false;
+          break;
+        }
+        cv[i] = dv[d];
+        cl[i] = dl[d];
+      }
+      ats_free(dl);
+      ats_free(dv);
+      break;
+    }
+    case COL_DELTA: {
+      int64_t v = 0;
+      for (uint64_t i = 0; in.ok && i < n; ++i) {
+        v = (int64_t) ((uint64_t) v + (uint64_t) in.get_svarint());
+        ints[c * n + i] = v;
+        cv[i] = (const char *) &ints[c * n + i];
+        cl[i] = sizeof(int64_t);
+      }
+      break;
+    }
+    default:
+      in.ok = false;
+      break;
+    }
+  }
+
+  LogBufferHeader *buffer_header = NULL;
+
+  if (in.ok) {
+    // lay the buffer out the way LogBuffer::_add_buffer_header and
+    // LogBuffer::checkout_write would have
+    uint64_t header_len = sizeof(LogBufferHeader);
+    for (int s = 0; s < 5; ++s)
+      if (strs[s])
+        header_len += str_lens[s] + 1;
+    header_len = INK_ALIGN_DEFAULT(header_len);
+
+    uint64_t byte_count = header_len;
+    for (uint64_t i = 0; i < n; ++i) {
+      uint64_t entry_len = sizeof(LogEntryHeader);
+      for (uint32_t c = 0; c < h.n_columns; ++c)
+        entry_len += lens[c * n + i];
+      byte_count += INK_ALIGN_DEFAULT(entry_len);
+    }
+
+    if (byte_count < (1ULL << 32)) {
+      char *buf = (char *)ats_calloc(1, byte_count);
+      uint32_t *offsets[5];
+      uint32_t off = sizeof(LogBufferHeader);
+
+      buffer_header = (LogBufferHeader *) buf;
+      buffer_header->cookie = LOG_SEGMENT_COOKIE;
+      buffer_header->version = LOG_SEGMENT_VERSION;
+      buffer_header->format_type = h.format_type;
+      buffer_header->byte_count = (uint32_t) byte_count;
+      buffer_header->entry_count = h.entry_count;
+      buffer_header->low_timestamp = h.low_timestamp;
+      buffer_header->high_timestamp = h.high_timestamp;
+      buffer_header->log_object_flags = h.log_object_flags;
+      buffer_header->log_object_signature = h.log_object_signature;
+
+      offsets[0] = &buffer_header->fmt_name_offset;
+      offsets[1] = &buffer_header->fmt_fieldlist_offset;
+      offsets[2] = &buffer_header->fmt_printf_offset;
+      offsets[3] = &buffer_header->src_hostname_offset;
+      offsets[4] = &buffer_header->log_filename_offset;
+      for (int s = 0; s < 5; ++s) {
+        if (strs[s]) {
+          *offsets[s] = off;
+          memcpy(buf + off, strs[s], str_lens[s]);
+          off += str_lens[s] + 1;
+        }
+      }
+      buffer_header->data_offset = (uint32_t) header_len;
+
+      char *p = buf + header_len;
+      for (uint64_t i = 0; i < n; ++i) {
+        LogEntryHeader *entry = (LogEntryHeader *) p;
+        char *to = p + sizeof(LogEntryHeader);
+
+        entry->timestamp = timestamps[i];
+        entry->timestamp_usec = usecs[i];
+        for (uint32_t c = 0; c < h.n_columns; ++c) {
+          memcpy(to, vals[c * n + i], lens[c * n + i]);
+          to += lens[c * n + i];
+        }
+        entry->entry_len = INK_ALIGN_DEFAULT(to - p);
+        p += entry->entry_len;
+      }
+    }
+  } else {
+    Note("Corrupt columnar log block");
+  }
+
+  ats_free(ints);
+  ats_free(lens);
+  ats_free(vals);
+  ats_free(usecs);
+  ats_free(timestamps);
+  ats_free(uncompressed);
+  return buffer_header;
+}
+
+#if TS_HAS_TESTS
+/*-------------------------------------------------------------------------
+  Regression: lay down a LogBuffer by hand with a dictionary friendly, a
+  delta friendly and a string column, and check that decode(encode())
+  gives back every entry byte for byte.
+  -------------------------------------------------------------------------*/
+
+REGRESSION_TEST(LogColumnar) (RegressionTest * t, int atype, int *pstatus)
+{
+  NOWARN_UNUSED(atype);
+  static const char *strs[5] = { "squid", "pssc,psql,cqu", "%<pssc> %<psql> %<cqu>", "host.test", "squid.blog" };
+  const uint32_t n = 100;
+  char url[64];
+
+  size_t header_len = sizeof(LogBufferHeader);
+  for (int s = 0; s < 5; ++s)
+    header_len += ::strlen(strs[s]) + 1;
+  header_len = INK_ALIGN_DEFAULT(header_len);
+
+  size_t size = header_len + n * INK_ALIGN_DEFAULT(sizeof(LogEntryHeader) + 2 * INK_MIN_ALIGN + sizeof(url));
+  char *buf = (char *)ats_calloc(1, size);
+  LogBufferHeader *bh = (LogBufferHeader *) buf;
+  uint32_t *offsets[5] = { &bh->fmt_name_offset, &bh->fmt_fieldlist_offset, &bh->fmt_printf_offset,
+                           &bh->src_hostname_offset, &bh->log_filename_offset };
+  uint32_t off = sizeof(LogBufferHeader);
+
+  bh->cookie = LOG_SEGMENT_COOKIE;
+  bh->version = LOG_SEGMENT_VERSION;
+  bh->format_type = CUSTOM_LOG;
+  bh->entry_count = n;
+  bh->low_timestamp = 1000000;
+  bh->high_timestamp = 1000000 + n;
+  for (int s = 0; s < 5; ++s) {
+    *offsets[s] = off;
+    memcpy(buf + off, strs[s], ::strlen(strs[s]) + 1);
+    off += ::strlen(strs[s]) + 1;
+  }
+  bh->data_offset = header_len;
+
+  char *p = buf + header_len;
+  for (uint32_t i = 0; i < n; ++i) {
+    LogEntryHeader *entry = (LogEntryHeader *) p;
+    char *to = p + sizeof(LogEntryHeader);
+    int url_len = snprintf(url, sizeof(url), "http://www.test/%u", i * 7919);
+    int padded = INK_ALIGN_DEFAULT(url_len + 1);
+
+    entry->timestamp = bh->low_timestamp + i;
+    entry->timestamp_usec = (i * 37) % 1000000;
+    LogAccess::marshal_int(to, i % 3 ? 200 : 404);
+    to += INK_MIN_ALIGN;
+    LogAccess::marshal_int(to, 1000 + 10 * i);
+    to += INK_MIN_ALIGN;
+    LogAccess::marshal_str(to, url, padded);
+    to += padded;
+    entry->entry_len = INK_ALIGN_DEFAULT(to - p);
+    p += entry->entry_len;
+  }
+  bh->byte_count = p - buf;
+
+  *pstatus = REGRESSION_TEST_PASSED;
+
+  char *block = NULL;
+  int block_len = LogColumnar::encode(bh, &block);
+  LogBufferHeader *out = block_len > 0 ? LogColumnar::decode(block, block_len) : NULL;
+
+  if (!out) {
+    rprintf(t, "round trip failed, block of %d bytes\n", block_len);
+    *pstatus = REGRESSION_TEST_FAILED;
+  } else {
+    LogColumnarHeader h;
+    memcpy(&h, block, sizeof(h));
+    rprintf(t, "%d bytes encoded into %d, flags %d\n", (int) bh->byte_count, block_len, (int) h.flags);
+    if (h.flags & LogColumnar::ROWS) {
+      rprintf(t, "entries were not split by field\n");
+      *pstatus = REGRESSION_TEST_FAILED;
+    }
+    if (out->byte_count != bh->byte_count || out->entry_count != n ||
+        memcmp((char *) out + out->data_offset, buf + header_len, bh->byte_count - header_len) != 0) {
+      rprintf(t, "decoded entries differ\n");
+      *pstatus = REGRESSION_TEST_FAILED;
+    }
+    if (strcmp(out->fmt_fieldlist(), strs[1]) || strcmp(out->log_filename(), strs[4])) {
+      rprintf(t, "decoded header strings differ\n");
+      *pstatus = REGRESSION_TEST_FAILED;
+    }
+  }
+
+  // a block claiming more than a reader accepts is refused
+  if (block_len > 0) {
+    ((LogColumnarHeader *) block)->byte_count = LOG_COLUMNAR_MAX_BLOCK + 1;
+    if (LogColumnar::decode(block, LOG_COLUMNAR_MAX_BLOCK + 1)) {
+      rprintf(t, "oversized block accepted\n");
+      *pstatus = REGRESSION_TEST_FAILED;
+    }
+  }
+
+  ats_free(out);
+  ats_free(block);
+  ats_free(buf);
+}
+#endif
@@ -0,0 +1,99 @@
+/** @file
+
+  Column-oriented encoding of LogBuffers for the "columnar" log mode.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#ifndef LOG_COLUMNAR_H
+#define LOG_COLUMNAR_H
+
+#include "libts.h"
+
+struct LogBufferHeader;
+
+#define LOG_COLUMNAR_COOKIE 0xc01face
+#define LOG_COLUMNAR_VERSION 1
+// Largest block, and largest uncompressed payload, a reader accepts.
+// LogBuffers are far smaller, so anything bigger is a corrupt block.
+#define LOG_COLUMNAR_MAX_BLOCK (64 * 1024 * 1024)
+
+/*-------------------------------------------------------------------------
+  LogColumnarHeader
+
+  Each LogBuffer written in COLUMNAR_LOG mode becomes one self-contained
+  block: this header followed by the (optionally zlib compressed) column
+  payload.  The cookie and version occupy the same position as in a
+  LogBufferHeader, so a reader can tell the two apart from the first 8
+  bytes.
+
+  The payload holds the five LogBufferHeader strings, the entry
+  timestamps (delta encoded), the microsecond column, and then one
+  column per field of the format.  Each field column is stored either
+  raw, dictionary encoded (for fields with few distinct values) or as
+  deltas of 64 bit integers, whichever the writer finds best.
+  -------------------------------------------------------------------------*/
+
+struct LogColumnarHeader
+{
+  uint32_t cookie;              // LOG_COLUMNAR_COOKIE
+  uint32_t version;             // LOG_COLUMNAR_VERSION
+  uint32_t byte_count;          // header + stored payload
+  uint32_t payload_bytes;       // payload size once uncompressed
+  uint32_t flags;               // COMPRESSED, ROWS
+  uint32_t format_type;         // from the LogBufferHeader
+  uint32_t entry_count;
+  uint32_t n_columns;
+  uint32_t low_timestamp;
+  uint32_t high_timestamp;
+  uint32_t log_object_flags;
+  uint32_t reserved;
+  uint64_t log_object_signature;
+};
+
+class LogColumnar
+{
+public:
+  enum BlockFlags
+  {
+    COMPRESSED = 1,             // payload is zlib compressed
+    ROWS = 2                    // entries could not be split by field
+  };
+
+  enum ColumnEncoding
+  {
+    COL_RAW = 0,
+    COL_DICT,
+    COL_DELTA
+  };
+
+  // Convert a row-oriented LogBuffer into a columnar block.  Returns the
+  // block length and sets *block to ats_malloc'd memory, or returns -1.
+  static int encode(LogBufferHeader * buffer_header, char **block);
+
+  // Rebuild the row-oriented LogBuffer from a complete block, so it can
+  // be formatted with the usual LogFile/LogBuffer routines.  The result
+  // is ats_malloc'd; NULL is returned for a corrupt block.
+  static LogBufferHeader *decode(const char *block, int len);
+
+private:
+  LogColumnar();
+};
+
+#endif
@@ -2202,7 +2202,8 @@ LogConfig::read_xml_log_config(int from_memory)
         char *mode_str = mode.dequeue();
         file_type = (strncasecmp(mode_str, "bin", 3) == 0 ||
                      (mode_str[0] == 'b' && mode_str[1] == 0) ?
-                     BINARY_LOG : (strcasecmp(mode_str, "ascii_pipe") == 0 ? ASCII_PIPE : ASCII_LOG));
+                     BINARY_LOG : (strcasecmp(mode_str, "ascii_pipe") == 0 ? ASCII_PIPE :
+                                   (strcasecmp(mode_str, "columnar") == 0 ? COLUMNAR_LOG : ASCII_LOG)));
       }
       // rolling
       //
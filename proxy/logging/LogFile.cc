@@ -45,6 +45,7 @@
 #include "LogFilter.h"
 #include "LogFormat.h"
 #include "LogBuffer.h"
+#include "LogColumnar.h"
 #include "LogFile.h"
 #include "LogHost.h"
 #include "LogObject.h"
@@ -286,7 +287,7 @@ LogFile::open_file()
   // file.
   //
   if (!file_exists) {
-    if (m_file_format != BINARY_LOG && m_header != NULL) {
+    if (m_file_format != BINARY_LOG && m_file_format != COLUMNAR_LOG && m_header != NULL) {
       Debug("log-file", "writing header to LogFile %s", m_name);
       writeln(m_header, strlen(m_header), m_fd, m_name);
     }
@@ -529,6 +530,9 @@ LogFile::write(LogBuffer * lb)
       Warning("An error was encountered writing to %s: [tried %d, wrote %d, '%s']", m_name, buffer_header->byte_count, bytes, strerror(errno));
     }
   }
+  else if (m_file_format == COLUMNAR_LOG) {
+    bytes = write_columnar_logbuffer(buffer_header);
+  }
   else if (m_file_format == ASCII_LOG || m_file_format == ASCII_PIPE) {
     bytes = write_ascii_logbuffer3(buffer_header);
 #if defined(LOG_BUFFER_TRACKING)
@@ -737,6 +741,133 @@ LogFile::write_ascii_logbuffer3(LogBufferHeader * buffer_header, char *alt_forma
   return total_bytes;
 }
 
+/*-------------------------------------------------------------------------
+  LogFile::write_columnar_logbuffer
+
+  Transpose the buffer into a columnar block (see LogColumnar.h) and write
+  it out in one go, just as a binary buffer would be.
+  -------------------------------------------------------------------------*/
+
+int
+LogFile::write_columnar_logbuffer(LogBufferHeader * buffer_header)
+{
+  ink_debug_assert(buffer_header != NULL);
+  ink_debug_assert(m_fd >= 0);
+
+  char *block = NULL;
+  int block_len = LogColumnar::encode(buffer_header, &block);
+
+  if (block_len < 0)
+    return 0;
+
+  int bytes = ::write(m_fd, block, block_len);
+  if (bytes != block_len) {
+    Warning("An error was encountered writing to %s: [tried %d, wrote %d, '%s']", m_name, block_len, bytes, strerror(errno));
+  }
+  ats_free(block);
+  return bytes;
+}
+
+/*-------------------------------------------------------------------------
+  LogFile::write_csv_logbuffer
+
+  Like write_ascii_logbuffer, but each entry becomes one CSV record with
+  one column per field of the format, in fieldlist order.  Fields are
+  formatted by LogBuffer::to_ascii, using a printf string of bare field
+  markers separated by a character that formatted fields never contain,
+  and quoted as needed.
+  -------------------------------------------------------------------------*/
+
+#define LOG_CSV_FIELD_SEPARATOR '\037'
+
+int
+LogFile::write_csv_logbuffer(LogBufferHeader * buffer_header, int fd, const char *path)
+{
+  ink_assert(buffer_header != NULL);
+  ink_assert(fd >= 0);
+
+  if (buffer_header->version != LOG_SEGMENT_VERSION) {
+    Note("Invalid LogBuffer version %d in write_csv_logbuffer; "
+         "current version is %d", buffer_header->version, LOG_SEGMENT_VERSION);
+    return 0;
+  }
+
+  LogFormatType format_type = (LogFormatType) buffer_header->format_type;
+  char *fieldlist_str = buffer_header->fmt_fieldlist();
+  char *printf_str = buffer_header->fmt_printf();
+  int n_fields = 0;
+
+  for (char *p = printf_str; p && *p; ++p) {
+    if (*p == LOG_FIELD_MARKER)
+      ++n_fields;
+  }
+
+  char *csv_printf = (char *)ats_malloc(2 * n_fields + 1);
+  for (int i = 0; i < n_fields; ++i) {
+    csv_printf[2 * i] = LOG_FIELD_MARKER;
+    csv_printf[2 * i + 1] = LOG_CSV_FIELD_SEPARATOR;
+  }
+  csv_printf[n_fields ? 2 * n_fields - 1 : 0] = 0;
+
+  // quoting can at worst double a field and add two quotes to it, and
+  // there is at most one field per formatted character
+  int csv_buf_size = 4 * LOG_MAX_FORMATTED_LINE + LOG_MAX_FORMATTED_BUFFER;
+  char *csv_buf = (char *)ats_malloc(csv_buf_size);
+  char fmt_line[LOG_MAX_FORMATTED_LINE];
+  LogBufferIterator iter(buffer_header);
+  LogEntryHeader *entry_header;
+  int csv_buf_bytes = 0;
+  int bytes = 0;
+
+  while ((entry_header = iter.next())) {
+    int fmt_line_bytes = LogBuffer::to_ascii(entry_header, format_type, &fmt_line[0], LOG_MAX_FORMATTED_LINE,
+                                             fieldlist_str, format_type == TEXT_LOG ? printf_str : csv_printf,
+                                             buffer_header->version);
+    if (fmt_line_bytes <= 0)
+      continue;
+
+    if (csv_buf_bytes + 4 * fmt_line_bytes + 4 >= csv_buf_size) {
+      if (!Log::config->logging_space_exhausted) {
+        bytes += writeln(csv_buf, csv_buf_bytes, fd, path);
+      }
+      csv_buf_bytes = 0;
+    }
+
+    // split on the separator, quoting fields that contain ',', '"' or
+    // line breaks and doubling any embedded quotes
+    char *field = fmt_line;
+    char *line_end = fmt_line + fmt_line_bytes;
+    while (field <= line_end) {
+      char *field_end = (char *)memchr(field, LOG_CSV_FIELD_SEPARATOR, line_end - field);
+      if (!field_end)
+        field_end = line_end;
+
+      bool quote = false;
+      for (char *c = field; c < field_end && !quote; ++c)
+        quote = (*c == ',' || *c == '"' || *c == '\r' || *c == '\n');
+      if (quote)
+        csv_buf[csv_buf_bytes++] = '"';
+      for (char *c = field; c < field_end; ++c) {
+        if (*c == '"')
+          csv_buf[csv_buf_bytes++] = '"';
+        csv_buf[csv_buf_bytes++] = *c;
+      }
+      if (quote)
+        csv_buf[csv_buf_bytes++] = '"';
+
+      csv_buf[csv_buf_bytes++] = (field_end == line_end ? '\n' : ',');
+      field = field_end + 1;
+    }
+  }
+  if (csv_buf_bytes > 0 && !Log::config->logging_space_exhausted) {
+    bytes += writeln(csv_buf, csv_buf_bytes, fd, path);
+  }
+
+  ats_free(csv_buf);
+  ats_free(csv_printf);
+  return bytes;
+}
+
 /*-------------------------------------------------------------------------
   LogFile::writeln
 
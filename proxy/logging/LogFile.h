@@ -155,11 +155,14 @@ public:
 
   LogFileFormat get_format() const { return m_file_format; }
   const char *get_format_name() const {
-    return (m_file_format == BINARY_LOG ? "binary" : (m_file_format == ASCII_PIPE ? "ascii_pipe" : "ascii"));
+    return (m_file_format == BINARY_LOG ? "binary" : (m_file_format == ASCII_PIPE ? "ascii_pipe" :
+                                                      (m_file_format == COLUMNAR_LOG ? "columnar" : "ascii")));
   }
 
   static int write_ascii_logbuffer(LogBufferHeader * buffer_header, int fd, const char *path, char *alt_format = NULL);
   int write_ascii_logbuffer3(LogBufferHeader * buffer_header, char *alt_format = NULL);
+  static int write_csv_logbuffer(LogBufferHeader * buffer_header, int fd, const char *path);
+  int write_columnar_logbuffer(LogBufferHeader * buffer_header);
   static bool rolled_logfile(char *file);
   static bool exists(const char *pathname);
 
@@ -39,6 +39,16 @@
 #include "Log.h"
 #include "LogObject.h"
 
+static int
+compare_low_timestamp(const void *a, const void *b)
+{
+  LogBufferHeader *ha = (*(LogBuffer **) a)->header();
+  LogBufferHeader *hb = (*(LogBuffer **) b)->header();
+  if (ha->low_timestamp != hb->low_timestamp)
+    return ha->low_timestamp < hb->low_timestamp ? -1 : 1;
+  return 0;
+}
+
 size_t
 LogBufferManager::flush_buffers(LogBufferSink *sink) {
   SList(LogBuffer, write_link) q(write_list.popall()), new_q;
@@ -55,14 +65,27 @@ LogBufferManager::flush_buffers(LogBufferSink *sink) {
     }
   }
 
-  int flushed = 0;
-  while ((b = new_q.pop())) {
+  // Buffers come from several slots of the LogObject, write them out in
+  // the order they were started so that the file stays roughly ordered
+  // by time.
+  int count = 0;
+  LogBuffer *sorted[FLUSH_ARRAY_SIZE];
+  while (count < FLUSH_ARRAY_SIZE && (b = new_q.pop())) {
     b->update_header_data();
-    sink->write(b);
-    delete b;
+    sorted[count++] = b;
+  }
+  qsort(sorted, count, sizeof(LogBuffer *), compare_low_timestamp);
+
+  int flushed = 0;
+  for (int i = 0; i < count; i++) {
+    sink->write(sorted[i]);
+    delete sorted[i];
     ink_atomic_increment(&_num_flush_buffers, -1);
     flushed++;
   }
+  // anything that did not fit goes on the next flush
+  while ((b = new_q.pop()))
+    write_list.push(b);
 
   Debug("log-logbuffer", "flushed %d buffers", flushed);
   return flushed;
@@ -90,6 +113,8 @@ LogObject::LogObject(LogFormat *format, const char *log_dir,
 
     if (file_format == BINARY_LOG) {
         m_flags |= BINARY;
+    } else if (file_format == COLUMNAR_LOG) {
+        m_flags |= COLUMNAR;
     } else if (file_format == ASCII_PIPE) {
 #ifdef ASCII_PIPE_FORMAT_SUPPORTED
         m_flags |= WRITES_TO_PIPE;
@@ -117,9 +142,7 @@ LogObject::LogObject(LogFormat *format, const char *log_dir,
                                  Log::config->overspill_report_count));
 #endif // TS_MICRO
 
-    LogBuffer *b = NEW (new LogBuffer (this, Log::config->log_buffer_size));
-    ink_debug_assert(b);
-    SET_FREELIST_POINTER_VERSION(m_log_buffer, b, 0);
+    _init_log_buffers();
 
     _setup_rolling(rolling_enabled, rolling_interval_sec, rolling_offset_hr, rolling_size_mb);
 
@@ -161,11 +184,9 @@ LogObject::LogObject(LogObject& rhs)
         add_loghost (host);
     }
 
-    // copy gets a fresh log buffer
+    // copy gets fresh log buffers
     //
-    LogBuffer *b = NEW (new LogBuffer (this, Log::config->log_buffer_size));
-    ink_debug_assert(b);
-    SET_FREELIST_POINTER_VERSION(m_log_buffer, b, 0);
+    _init_log_buffers();
 
     Debug("log-config", "exiting LogObject copy constructor, "
           "filename=%s this=%p", m_filename, this);
@@ -192,7 +213,40 @@ LogObject::~LogObject()
   ats_free(m_filename);
   ats_free(m_alt_filename);
   delete m_format;
-  delete (LogBuffer*)FREELIST_POINTER(m_log_buffer);
+  for (int i = 0; i < m_buffer_slots; i++)
+    delete (LogBuffer*)FREELIST_POINTER(m_log_buffer[i].head);
+  ats_memalign_free(m_log_buffer);
+}
+
+// Number of buffer slots of every LogObject, fixed when the first one is
+// made: one for each event thread running then (net and SSL threads), plus
+// the task threads, which are started after logging.
+static int
+log_object_buffer_slots()
+{
+  static int slots = 0;
+
+  if (!slots) {
+    slots = eventProcessor.n_ethreads;
+    if (slots > 0)
+      slots += (int) LOG_ConfigReadInteger("proxy.config.task_threads");
+    else
+      slots = LOG_OBJECT_BUFFER_SLOTS;
+    Debug("log-logbuffer", "%d buffer slots per log object", slots);
+  }
+  return slots;
+}
+
+void
+LogObject::_init_log_buffers()
+{
+  m_buffer_slots = log_object_buffer_slots();
+  m_log_buffer = (LogBufferSlot *)ats_memalign(LOG_OBJECT_BUFFER_SLOT_SIZE, m_buffer_slots * sizeof(LogBufferSlot));
+  for (int i = 0; i < m_buffer_slots; i++) {
+    LogBuffer *b = NEW (new LogBuffer (this, Log::config->log_buffer_size));
+    ink_debug_assert(b);
+    SET_FREELIST_POINTER_VERSION(m_log_buffer[i].head, b, 0);
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -240,6 +294,10 @@ LogObject::generate_filenames(const char *log_dir, const char *basename, LogFile
       ext = ASCII_PIPE_OBJECT_FILENAME_EXTENSION;
       ext_len = 5;
       break;
+    case COLUMNAR_LOG:
+      ext = COLUMNAR_LOG_OBJECT_FILENAME_EXTENSION;
+      ext_len = 5;
+      break;
     default:
       ink_debug_assert(!"unknown file format");
     }
@@ -337,7 +395,8 @@ uint64_t LogObject::compute_signature(LogFormat * format, char *filename, unsign
     char *buffer = (char *)ats_malloc(buf_size);
 
     ink_string_concatenate_strings(buffer, fl, ps, filename, flags & LogObject::BINARY ? "B" :
-                                   (flags & LogObject::WRITES_TO_PIPE ? "P" : "A"), NULL);
+                                   (flags & LogObject::WRITES_TO_PIPE ? "P" :
+                                    (flags & LogObject::COLUMNAR ? "C" : "A")), NULL);
 
     INK_MD5 md5s;
 
@@ -385,7 +444,7 @@ LogObject::displayAsXML(FILE * fd, bool extended)
           "<LogObject>\n"
           "  <Mode        = \"%s\"/>\n"
           "  <Format      = \"%s\"/>\n"
-          "  <Filename    = \"%s\"/>\n", (m_flags & BINARY ? "binary" : "ascii"), m_format->name(), m_filename);
+          "  <Filename    = \"%s\"/>\n", (m_flags & BINARY ? "binary" : (m_flags & COLUMNAR ? "columnar" : "ascii")), m_format->name(), m_filename);
 
   LogFilter *filter;
   for (filter = m_filter_list.first(); filter != NULL; filter = m_filter_list.next(filter)) {
@@ -402,8 +461,33 @@ LogObject::displayAsXML(FILE * fd, bool extended)
 #endif // TS_MICRO
 
 
+// Each thread writes to one of the LogObject's buffer slots, handed out
+// round robin the first time the thread logs, so with a slot per event
+// thread each of them gets its own. The slot is kept in thread
+// specific data as slot + 1 so that zero means unassigned.
+static ink_thread_key log_buffer_slot_key;
+static vint32 log_buffer_slot_next = 0;
+
+struct LogBufferSlotKeyInit
+{
+  LogBufferSlotKeyInit() { ink_thread_key_create(&log_buffer_slot_key, NULL); }
+};
+static LogBufferSlotKeyInit log_buffer_slot_key_init;
+
+static inline int
+log_buffer_slot()
+{
+  intptr_t slot = (intptr_t) ink_thread_getspecific(log_buffer_slot_key);
+  if (unlikely(!slot)) {
+    slot = ink_atomic_increment(&log_buffer_slot_next, 1) % log_object_buffer_slots() + 1;
+    ink_thread_setspecific(log_buffer_slot_key, (void *) slot);
+  }
+  return (int) slot - 1;
+}
+
 LogBuffer *
-LogObject::_checkout_write(size_t * write_offset, size_t bytes_needed) {
+LogObject::_checkout_write(size_t * write_offset, size_t bytes_needed, int slot) {
+  volatile head_p &log_buffer = m_log_buffer[slot].head;
   LogBuffer::LB_ResultCode result_code;
   LogBuffer *buffer;
   LogBuffer *new_buffer;
@@ -415,10 +499,10 @@ LogObject::_checkout_write(size_t * write_offset, size_t bytes_needed) {
     head_p h;
     int result = 0;
     do {
-      INK_QUEUE_LD64(h, m_log_buffer);
+      INK_QUEUE_LD64(h, log_buffer);
       head_p new_h;
       SET_FREELIST_POINTER_VERSION(new_h, FREELIST_POINTER(h), FREELIST_VERSION(h) + 1);
-      result = ink_atomic_cas((int64_t*)&m_log_buffer.data, h.data, new_h.data);
+      result = ink_atomic_cas((int64_t*)&log_buffer.data, h.data, new_h.data);
     } while (!result);
     buffer = (LogBuffer*)FREELIST_POINTER(h);
     result_code = buffer->checkout_write(write_offset, bytes_needed);
@@ -440,10 +524,10 @@ LogObject::_checkout_write(size_t * write_offset, size_t bytes_needed) {
       INK_WRITE_MEMORY_BARRIER;
       head_p old_h;
       do {
-        INK_QUEUE_LD64(old_h, m_log_buffer);
+        INK_QUEUE_LD64(old_h, log_buffer);
         head_p tmp_h;
         SET_FREELIST_POINTER_VERSION(tmp_h, new_buffer, 0);
-        result = ink_atomic_cas((int64_t*)&m_log_buffer.data, old_h.data, tmp_h.data);
+        result = ink_atomic_cas((int64_t*)&log_buffer.data, old_h.data, tmp_h.data);
       } while (!result);
       if (FREELIST_POINTER(old_h) == FREELIST_POINTER(h))
         ink_atomic_increment(&buffer->m_references, FREELIST_VERSION(old_h) - 1);
@@ -478,12 +562,12 @@ LogObject::_checkout_write(size_t * write_offset, size_t bytes_needed) {
     if (!decremented) {
       head_p old_h;
       do {
-        INK_QUEUE_LD64(old_h, m_log_buffer);
+        INK_QUEUE_LD64(old_h, log_buffer);
         if (FREELIST_POINTER(old_h) != FREELIST_POINTER(h))
           break;
         head_p tmp_h;
         SET_FREELIST_POINTER_VERSION(tmp_h, FREELIST_POINTER(h), FREELIST_VERSION(old_h) - 1);
-        result = ink_atomic_cas((int64_t*)&m_log_buffer.data, old_h.data, tmp_h.data);
+        result = ink_atomic_cas((int64_t*)&log_buffer.data, old_h.data, tmp_h.data);
       } while (!result);
       if (FREELIST_POINTER(old_h) != FREELIST_POINTER(h))
         ink_atomic_increment(&buffer->m_references, -1);
@@ -576,7 +660,7 @@ LogObject::log(LogAccess * lad, char *text_entry)
   }
   // Now try to place this entry in the current LogBuffer.
 
-  buffer = _checkout_write(&offset, bytes_needed);
+  buffer = _checkout_write(&offset, bytes_needed, log_buffer_slot());
 
   if (!buffer) {
     Note("Traffic Server is skipping the current log entry for %s because "
@@ -777,9 +861,11 @@ LogObject::_roll_files(long last_roll_time, long time_now)
 void
 LogObject::check_buffer_expiration(long time_now)
 {
-  LogBuffer *b = (LogBuffer*)FREELIST_POINTER(m_log_buffer);
-  if (b && time_now > b->expiration_time()) {
-    force_new_buffer();
+  for (int i = 0; i < m_buffer_slots; i++) {
+    LogBuffer *b = (LogBuffer*)FREELIST_POINTER(m_log_buffer[i].head);
+    if (b && time_now > b->expiration_time()) {
+      _checkout_write(NULL, 0, i);
+    }
   }
 }
 
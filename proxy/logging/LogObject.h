@@ -52,9 +52,18 @@
 #define ASCII_LOG_OBJECT_FILENAME_EXTENSION ".log"
 #define BINARY_LOG_OBJECT_FILENAME_EXTENSION ".blog"
 #define ASCII_PIPE_OBJECT_FILENAME_EXTENSION ".pipe"
+#define COLUMNAR_LOG_OBJECT_FILENAME_EXTENSION ".clog"
 
 #define FLUSH_ARRAY_SIZE (512*4)
 
+// Each LogObject has a work buffer per event thread, so that writing
+// threads do not all contend on a single buffer head. This many are
+// used when there are no event threads to count.
+#define LOG_OBJECT_BUFFER_SLOTS 16
+// Each buffer head is padded to this size, the cache line size, so that
+// threads on different slots do not bounce the same line.
+#define LOG_OBJECT_BUFFER_SLOT_SIZE 64
+
 #define LOG_OBJECT_ARRAY_DELTA 8
 
 #define ACQUIRE_API_MUTEX(_f) \
@@ -89,13 +98,15 @@ public:
   {
     BINARY = 1,
     REMOTE_DATA = 2,
-    WRITES_TO_PIPE = 4
+    WRITES_TO_PIPE = 4,
+    COLUMNAR = 8
   };
 
   // BINARY: log is written in binary format (rather than ascii)
   // REMOTE_DATA: object receives data from remote collation clients, so
   //              it should not be destroyed during a reconfiguration
   // WRITES_TO_PIPE: object writes to a named pipe rather than to a file
+  // COLUMNAR: log is written as column-oriented blocks (see LogColumnar.h)
 
   LogObject(LogFormat *format, const char *log_dir, const char *basename,
                  LogFileFormat file_format, const char *header,
@@ -180,7 +191,8 @@ public:
   const char *get_format_string() { return (m_format ? m_format->format_string() : "<none>"); }
 
   void force_new_buffer() {
-    _checkout_write(NULL, 0);
+    for (int i = 0; i < m_buffer_slots; i++)
+      _checkout_write(NULL, 0, i);
   }
 
   bool operator==(LogObject & rhs);
@@ -216,7 +228,13 @@ private:
 
   int m_ref_count;
 
-  volatile head_p m_log_buffer;     // current work buffer
+  struct LogBufferSlot
+  {
+    volatile head_p head;
+    char pad[LOG_OBJECT_BUFFER_SLOT_SIZE - sizeof(head_p)];
+  };
+  LogBufferSlot *m_log_buffer;  // current work buffers
+  int m_buffer_slots;
   LogBufferManager m_buffer_manager;
 
   void generate_filenames(const char *log_dir, const char *basename, LogFileFormat file_format);
@@ -225,7 +243,8 @@ private:
   int _roll_files(long interval_start, long interval_end);
 #endif
 
-  LogBuffer *_checkout_write(size_t * write_offset, size_t write_size);
+  void _init_log_buffers();
+  LogBuffer *_checkout_write(size_t * write_offset, size_t write_size, int slot);
 
 private:
   // -- member functions not allowed --
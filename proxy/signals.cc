@@ -73,6 +73,7 @@ public:
       sigusr1_received = 0;
       // TODO: TS-567 Integrate with debugging allocators "dump" features?
       ink_freelists_dump(stderr);
+      thread_freelists_dump(stderr);
       if (!end)
         end = (char *) sbrk(0);
       if (!snap)
@@ -129,6 +130,7 @@ public:
       // TODO: TS-567 Integrate with debugging allocators "dump" features?
       ink_freelists_dump(stderr);
     }
+    thread_freelists_dump(stderr);
     if (!baseline_taken && use_baseline) {
       ink_freelists_snap_baseline();
       // TODO: TS-567 Integrate with debugging allocators "dump" features?